@@ -1,15 +1,143 @@
 #include "bench/bench_falcon.hpp"
 
+// register for benchmarking PRNG
+BENCHMARK(bench_falcon::prng_construct);
+BENCHMARK(bench_falcon::prng_thread_local);
+
 // register for benchmarking Falcon512
 BENCHMARK(bench_falcon::keygen<512>);
+BENCHMARK(bench_falcon::expand_skey<512>);
+BENCHMARK(bench_falcon::recompute_G<512, true>);
+BENCHMARK(bench_falcon::recompute_G<512, false>);
+BENCHMARK(bench_falcon::expand_seed<512>);
+BENCHMARK(bench_falcon::encode_keys<512>);
+BENCHMARK(bench_falcon::decode_keys<512>);
+BENCHMARK(bench_falcon::load_keys<512>)
+  ->RangeMultiplier(2)
+  ->Range(1, 32)
+  ->UseRealTime();
 BENCHMARK(bench_falcon::sign_single<512>)->Arg(32);
+BENCHMARK(bench_falcon::sign_cached<512>)->Arg(32);
+BENCHMARK(bench_falcon::open_key_store<512>)->Arg(1)->Arg(64);
 BENCHMARK(bench_falcon::sign_many<512>)->Arg(32);
+BENCHMARK(bench_falcon::sign_emulated<512>)->Arg(32);
+BENCHMARK(bench_falcon::sign_replay<512>)->Arg(32);
+BENCHMARK(bench_falcon::sign_pre_squeezed<512>)->Arg(32);
+BENCHMARK(bench_falcon::sign_stream<512>)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(bench_falcon::sign_xn<512, 4>)->Arg(32);
+BENCHMARK(bench_falcon::sign_xn<512, 8>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<512, 4>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<512, 1>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<512, 0>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn_fgFG<512>)->Arg(32);
+BENCHMARK(bench_falcon::ff_sampling<512, falcon_tree::layout_t::LEVEL_MAJOR>)
+  ->Arg(1)
+  ->Arg(256);
+BENCHMARK(bench_falcon::ff_sampling<512, falcon_tree::layout_t::PRE_ORDER>)
+  ->Arg(1)
+  ->Arg(256);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 2, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 2, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 4, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 4, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 8, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 8, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 16, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<512, 16, true>);
+BENCHMARK(bench_falcon::ffldl_level<512, 2>);
+BENCHMARK(bench_falcon::ffldl_level<512, 4>);
+BENCHMARK(bench_falcon::ffldl_level<512, 8>);
+BENCHMARK(bench_falcon::sign_batch<512>)
+  ->RangeMultiplier(2)
+  ->Range(1, 32)
+  ->UseRealTime();
 BENCHMARK(bench_falcon::verify<512>)->Arg(32);
+BENCHMARK(bench_falcon::verify_xn<512, 4>)->Arg(32);
+BENCHMARK(bench_falcon::verify_xn<512, 8>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<512, 1>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<512, 4>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<512, 8>)->Arg(32);
+BENCHMARK(bench_falcon::verify_stream<512>)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(bench_falcon::lookup_verify<512, pkey_store::form_t::COEFF>)
+  ->Arg(1)
+  ->Arg(1 << 16);
+BENCHMARK(bench_falcon::lookup_verify<512, pkey_store::form_t::NTT>)
+  ->Arg(1)
+  ->Arg(1 << 16);
 
 // register for benchmarking Falcon1024
 BENCHMARK(bench_falcon::keygen<1024>);
+BENCHMARK(bench_falcon::expand_skey<1024>);
+BENCHMARK(bench_falcon::recompute_G<1024, true>);
+BENCHMARK(bench_falcon::recompute_G<1024, false>);
+BENCHMARK(bench_falcon::expand_seed<1024>);
+BENCHMARK(bench_falcon::encode_keys<1024>);
+BENCHMARK(bench_falcon::decode_keys<1024>);
+BENCHMARK(bench_falcon::load_keys<1024>)
+  ->RangeMultiplier(2)
+  ->Range(1, 32)
+  ->UseRealTime();
 BENCHMARK(bench_falcon::sign_single<1024>)->Arg(32);
+BENCHMARK(bench_falcon::sign_cached<1024>)->Arg(32);
+BENCHMARK(bench_falcon::open_key_store<1024>)->Arg(1)->Arg(64);
 BENCHMARK(bench_falcon::sign_many<1024>)->Arg(32);
+BENCHMARK(bench_falcon::sign_emulated<1024>)->Arg(32);
+BENCHMARK(bench_falcon::sign_replay<1024>)->Arg(32);
+BENCHMARK(bench_falcon::sign_pre_squeezed<1024>)->Arg(32);
+BENCHMARK(bench_falcon::sign_stream<1024>)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(bench_falcon::sign_xn<1024, 4>)->Arg(32);
+BENCHMARK(bench_falcon::sign_xn<1024, 8>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<1024, 4>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<1024, 1>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn<1024, 0>)->Arg(32);
+BENCHMARK(bench_falcon::sign_dyn_fgFG<1024>)->Arg(32);
+BENCHMARK(bench_falcon::ff_sampling<1024, falcon_tree::layout_t::LEVEL_MAJOR>)
+  ->Arg(1)
+  ->Arg(256);
+BENCHMARK(bench_falcon::ff_sampling<1024, falcon_tree::layout_t::PRE_ORDER>)
+  ->Arg(1)
+  ->Arg(256);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 2, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 2, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 4, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 4, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 8, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 8, true>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 16, false>);
+BENCHMARK(bench_falcon::ff_sampling_level<1024, 16, true>);
+BENCHMARK(bench_falcon::ffldl_level<1024, 2>);
+BENCHMARK(bench_falcon::ffldl_level<1024, 4>);
+BENCHMARK(bench_falcon::ffldl_level<1024, 8>);
+BENCHMARK(bench_falcon::sign_batch<1024>)
+  ->RangeMultiplier(2)
+  ->Range(1, 32)
+  ->UseRealTime();
 BENCHMARK(bench_falcon::verify<1024>)->Arg(32);
+BENCHMARK(bench_falcon::verify_xn<1024, 4>)->Arg(32);
+BENCHMARK(bench_falcon::verify_xn<1024, 8>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<1024, 1>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<1024, 4>)->Arg(32);
+BENCHMARK(bench_falcon::hash_to_point<1024, 8>)->Arg(32);
+BENCHMARK(bench_falcon::verify_stream<1024>)->Arg(1 << 12)->Arg(1 << 16);
+BENCHMARK(bench_falcon::lookup_verify<1024, pkey_store::form_t::COEFF>)
+  ->Arg(1)
+  ->Arg(1 << 16);
+BENCHMARK(bench_falcon::lookup_verify<1024, pkey_store::form_t::NTT>)
+  ->Arg(1)
+  ->Arg(1 << 16);
+
+int
+main(int argc, char** argv)
+{
+  // report which ISA variant of hot kernels is benchmarked, see isa.hpp
+  benchmark::AddCustomContext("falcon_isa", isa::name(isa::active()));
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
 
-BENCHMARK_MAIN();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
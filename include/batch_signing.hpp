@@ -0,0 +1,142 @@
+#pragma once
+#include "falcon.hpp"
+#include "prng.hpp"
+#include "scratch.hpp"
+#include "thread_pool.hpp"
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Multi-threaded, batched Falcon{512, 1024} signing
+namespace batch_signing {
+
+// Batch signer, backed by a persistent pool of worker threads, s.t. each worker
+// owns its own independently seeded PRNG and its own scratch buffer ( see
+// `signing::sign_scratch_bytes` ), while secret key ( i.e. 2x2 matrix B and
+// falcon tree T ) is shared, read-only, by all workers.
+//
+// Note, `prng::prng_t` is not thread-safe, which is why it's never shared
+// across workers. Signer itself can be used from multiple threads, though
+// batches submitted concurrently are signed one after another.
+//
+// Falcon tree T is expected to be laid out following memory layout L, see
+// `falcon_tree::layout_t`.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+  requires((N == 512) || (N == 1024))
+class signer_t
+{
+private:
+  static constexpr size_t sclen = signing::sign_scratch_bytes<N>();
+
+  // Scratch buffers hold secret-dependent intermediates of signing, so they're
+  // wiped before being released.
+  struct free_t
+  {
+    void operator()(uint8_t* const ptr) const
+    {
+      scratch::secure_wipe(ptr, sclen);
+      std::free(ptr);
+    }
+  };
+
+  thread_pool::thread_pool_t pool;
+  std::vector<prng::prng_t> rngs;
+  std::vector<std::unique_ptr<uint8_t, free_t>> scratches;
+
+public:
+  // Spawns `cnt` -many worker threads, each with its own PRNG and scratch
+  // buffer. By default, as many workers as there are hardware threads.
+  //
+  // Throws `std::bad_alloc`, if scratch buffers can't be allocated.
+  explicit inline signer_t(
+    const size_t cnt = std::thread::hardware_concurrency())
+    : pool(cnt)
+    , rngs(pool.size())
+  {
+    scratches.reserve(pool.size());
+    for (size_t i = 0; i < pool.size(); i++) {
+      auto ptr = std::aligned_alloc(scratch::ALIGNMENT, sclen);
+      if (ptr == nullptr) {
+        throw std::bad_alloc();
+      }
+
+      scratches.emplace_back(static_cast<uint8_t*>(ptr));
+    }
+  }
+
+  // Number of worker threads signing messages.
+  inline size_t threads() const { return pool.size(); }
+
+  // Given 2x2 matrix B ( in its FFT form ) s.t. B = [[g, -f], [G, -F]] and
+  // falcon tree T, signs each message msgs[i], writing compressed signature to
+  // sigs[i], which must be able to hold `falcon_utils::compute_sig_len<N>()`
+  // -bytes. Messages are distributed over all workers, but signatures are
+  // always written in same order as messages are supplied.
+  //
+  // Returns false, without signing anything, if # -of messages and # -of
+  // signature buffers don't match, otherwise returns true once all messages
+  // are signed.
+  inline bool sign(const fft::cmplx* const __restrict B,
+                   const fft::cmplx* const __restrict T,
+                   const std::span<const std::span<const uint8_t>> msgs,
+                   const std::span<uint8_t* const> sigs)
+  {
+    if (msgs.size() != sigs.size()) {
+      return false;
+    }
+
+    const std::function<void(size_t, size_t)> job = [&](const size_t widx,
+                                                         const size_t tidx) {
+      const auto msg = msgs[tidx];
+
+      falcon::sign<N, L>(B,
+                         T,
+                         msg.data(),
+                         msg.size(),
+                         sigs[tidx],
+                         rngs[widx],
+                         scratches[widx].get());
+    };
+
+    pool.run(msgs.size(), job);
+    return true;
+  }
+};
+
+// Signs a batch of messages, using a persistent signer ( see `signer_t` ),
+// which is lazily created on first call, with as many workers as there are
+// hardware threads, and lives till program exits. See `signer_t::sign` for
+// description of arguments and return value.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline bool
+sign_batch(const fft::cmplx* const __restrict B, // [[g, -f], [G, -F]]
+           const fft::cmplx* const __restrict T, // Falcon Tree
+           const std::span<const std::span<const uint8_t>> msgs,
+           const std::span<uint8_t* const> sigs)
+  requires((N == 512) || (N == 1024))
+{
+  static signer_t<N, L> signer;
+  return signer.sign(B, T, msgs, sigs);
+}
+
+// Same as above, but signs using caller-owned signer, which lets caller pick
+// number of worker threads.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline bool
+sign_batch(signer_t<N, L>& signer,
+           const fft::cmplx* const __restrict B, // [[g, -f], [G, -F]]
+           const fft::cmplx* const __restrict T, // Falcon Tree
+           const std::span<const std::span<const uint8_t>> msgs,
+           const std::span<uint8_t* const> sigs)
+  requires((N == 512) || (N == 1024))
+{
+  return signer.sign(B, T, msgs, sigs);
+}
+
+}
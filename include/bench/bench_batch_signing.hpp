@@ -0,0 +1,85 @@
+#pragma once
+#include "batch_signing.hpp"
+#include "prng.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+#include <span>
+#include <vector>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark multi-threaded, batched Falcon{512, 1024} message signing, using
+// `state.range()` -many worker threads, each batch holding 256 messages, each
+// of 32 -bytes, signed with same secret key.
+//
+// Reports throughput as # -of signatures per second ( of wall clock time ), so
+// that scaling with number of worker threads can be read off directly.
+template<const size_t N>
+void
+sign_batch(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t threads = state.range();
+
+  constexpr size_t cnt = 256;
+  constexpr size_t mlen = 32;
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(cnt * mlen));
+  auto sigs_ = static_cast<uint8_t*>(std::malloc(cnt * siglen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msgs_, cnt * mlen);
+
+  std::vector<std::span<const uint8_t>> msgs;
+  std::vector<uint8_t*> sigs;
+  for (size_t i = 0; i < cnt; i++) {
+    msgs.emplace_back(msgs_ + i * mlen, mlen);
+    sigs.push_back(sigs_ + i * siglen);
+  }
+
+  batch_signing::signer_t<N> signer(threads);
+
+  for (auto _ : state) {
+    const bool _signed = batch_signing::sign_batch<N>(signer, B, T, msgs, sigs);
+
+    benchmark::DoNotOptimize(_signed);
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::DoNotOptimize(sigs_);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * cnt));
+  state.counters["threads"] = threads;
+
+  bool verified = true;
+  for (size_t i = 0; i < cnt; i++) {
+    verified &= verification::verify<N, β2>(h, msgs[i].data(), mlen, sigs[i]);
+  }
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(msgs_);
+  std::free(sigs_);
+
+  assert(verified);
+}
+
+}
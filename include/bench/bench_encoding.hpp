@@ -0,0 +1,97 @@
+#pragma once
+#include "decoding.hpp"
+#include "encoding.hpp"
+#include "prng.hpp"
+#include "utils.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Fills public key polynomial h and secret key polynomials f, g and F with
+// random coefficients, within ranges allowed by their fixed-width encodings.
+template<const size_t N>
+static inline void
+random_key_polys(ff::ff_t* const __restrict h,
+                 int32_t* const __restrict f,
+                 int32_t* const __restrict g,
+                 int32_t* const __restrict F)
+{
+  constexpr int32_t fg_lim = N == 512 ? 31 : 15;
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < N; i++) {
+    uint32_t v = 0;
+    rng.read(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+
+    h[i].v = static_cast<uint16_t>(v % ff::Q);
+    f[i] = static_cast<int32_t>((v >> 8) % (2 * fg_lim + 1)) - fg_lim;
+    g[i] = static_cast<int32_t>((v >> 16) % (2 * fg_lim + 1)) - fg_lim;
+    F[i] = static_cast<int32_t>((v >> 24) % 255) - 127;
+  }
+}
+
+// Benchmark encoding of Falcon{512, 1024} public and secret key, which packs
+// fixed-width coefficients of h, f, g and F into bytes.
+template<const size_t N>
+void
+encode_keys(benchmark::State& state)
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  ff::ff_t h[N];
+  int32_t f[N], g[N], F[N];
+  uint8_t pkey[pklen], skey[sklen];
+
+  random_key_polys<N>(h, f, g, F);
+
+  for (auto _ : state) {
+    encoding::encode_pkey<N>(h, pkey);
+    encoding::encode_skey<N>(f, g, F, skey);
+
+    benchmark::DoNotOptimize(pkey);
+    benchmark::DoNotOptimize(skey);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Benchmark decoding of Falcon{512, 1024} public and secret key, which unpacks
+// fixed-width coefficients of h, f, g and F out of bytes.
+template<const size_t N>
+void
+decode_keys(benchmark::State& state)
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  ff::ff_t h[N];
+  int32_t f[N], g[N], F[N];
+  uint8_t pkey[pklen], skey[sklen];
+
+  random_key_polys<N>(h, f, g, F);
+  encoding::encode_pkey<N>(h, pkey);
+  encoding::encode_skey<N>(f, g, F, skey);
+
+  bool flg = true;
+
+  for (auto _ : state) {
+    flg &= decoding::decode_pkey<N>(pkey, h);
+    flg &= decoding::decode_skey<N>(skey, f, g, F);
+
+    benchmark::DoNotOptimize(flg);
+    benchmark::DoNotOptimize(h);
+    benchmark::DoNotOptimize(f);
+    benchmark::DoNotOptimize(g);
+    benchmark::DoNotOptimize(F);
+    benchmark::ClobberMemory();
+  }
+
+  assert(flg);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+}
@@ -1,5 +1,13 @@
 #pragma once
 
+#include "bench_batch_signing.hpp"
+#include "bench_encoding.hpp"
+#include "bench_ffsampling.hpp"
+#include "bench_key_loader.hpp"
+#include "bench_key_store.hpp"
 #include "bench_keygen.hpp"
+#include "bench_pkey_store.hpp"
+#include "bench_prng.hpp"
 #include "bench_signing.hpp"
+#include "bench_streaming.hpp"
 #include "bench_verify.hpp"
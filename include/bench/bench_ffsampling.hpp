@@ -0,0 +1,231 @@
+#pragma once
+#include "falcon.hpp"
+#include "prng.hpp"
+#include <benchmark/benchmark.h>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark Falcon{512, 1024} ffSampling, while Falcon tree is laid out
+// following memory layout L ( see `falcon_tree::layout_t` ).
+//
+// `state.range()` copies of the same Falcon tree are kept in memory and each
+// iteration samples using next copy, so that with many copies, tree is not
+// cache resident and ffSampling's cost of fetching the tree from memory ( along
+// with how well hardware/ software prefetching works with that layout ) is
+// measured. With single copy, tree stays cache resident.
+template<const size_t N, const falcon_tree::layout_t L>
+void
+ff_sampling(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t tcnt = state.range();
+
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+  constexpr size_t mlen = 32;
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+  constexpr double σ = σ_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(
+    std::malloc(sizeof(fft::cmplx) * ftlen * tcnt));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto t0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto t1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto ws = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 5));
+  auto c = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  uint8_t salt[40];
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  keygen::keygen<N, L>(B, T, h, σ, rng);
+  for (size_t i = 1; i < tcnt; i++) {
+    std::memcpy(T + i * ftlen, T, sizeof(fft::cmplx) * ftlen);
+  }
+
+  rng.read(salt, sizeof(salt));
+  rng.read(msg, sizeof(msg));
+  signing::compute_target<N>(B, salt, msg, mlen, t0, t1, c, ws);
+
+  size_t tidx = 0;
+
+  for (auto _ : state) {
+    const fft::cmplx* const T_ = T + tidx * ftlen;
+
+    ffsampling::ff_sampling_inplace<N, 0, log2<N>(), L>(
+      t0, t1, T_, σ_min, z0, z1, ws, rng);
+
+    tidx = (tidx + 1) % tcnt;
+
+    benchmark::DoNotOptimize(t0);
+    benchmark::DoNotOptimize(t1);
+    benchmark::DoNotOptimize(T_);
+    benchmark::DoNotOptimize(z0);
+    benchmark::DoNotOptimize(z1);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["tree_bytes"] = sizeof(fft::cmplx) * ftlen * tcnt;
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(t0);
+  std::free(t1);
+  std::free(z0);
+  std::free(z1);
+  std::free(ws);
+  std::free(c);
+}
+
+// Benchmark sampling of all 2^i subtrees, rooted at level i = log2(N / n) of
+// Falcon{512, 1024} tree, giving per-level time breakdown of ffSampling.
+//
+// With CODELETS set, subtrees are sampled using `ff_sampling_inplace`, which
+// switches to unrolled, fused codelets for degree <= `codelets::MAX_N`
+// polynomials, otherwise using generic, reference `ff_sampling`.
+template<const size_t N, const size_t n, const bool CODELETS>
+void
+ff_sampling_level(benchmark::State& state)
+  requires(((N == 512) || (N == 1024)) && (n > 1) && (n <= N))
+{
+  constexpr size_t k = log2<N>();
+  constexpr size_t lvl = k - log2<n>();
+  constexpr size_t cnt = 1ul << lvl; // # -of subtrees at this level
+
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (k + 1) * N; // 2^k * (k+1)
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+  constexpr double σ = σ_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto t0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto t1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto ws = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 2 * n));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+
+  uint8_t rnd[2 * N];
+  rng.read(rnd, sizeof(rnd));
+
+  // random targets, of magnitude similar to what's seen during signing
+  for (size_t i = 0; i < N; i++) {
+    t0[i] = fft::cmplx{ static_cast<double>(rnd[2 * i + 0]) - 128. };
+    t1[i] = fft::cmplx{ static_cast<double>(rnd[2 * i + 1]) - 128. };
+  }
+
+  for (auto _ : state) {
+    // in level-major layout, subtrees rooted at level i are stored one after
+    // another, starting at T + i * N
+    for (size_t j = 0; j < cnt; j++) {
+      const fft::cmplx* const T_ = T + lvl * N + j * n;
+      const size_t off = j * n;
+
+      if constexpr (CODELETS) {
+        ffsampling::ff_sampling_inplace<n, lvl, k>(
+          t0 + off, t1 + off, T_, σ_min, z0 + off, z1 + off, ws, rng);
+      } else {
+        ffsampling::ff_sampling<n, lvl, k>(
+          t0 + off, t1 + off, T_, σ_min, z0 + off, z1 + off, rng);
+      }
+    }
+
+    benchmark::DoNotOptimize(z0);
+    benchmark::DoNotOptimize(z1);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["subtrees"] = cnt;
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(t0);
+  std::free(t1);
+  std::free(z0);
+  std::free(z1);
+  std::free(ws);
+}
+
+// Benchmark computation of all 2^i LDL subtrees, rooted at level i = log2(N /
+// n) of Falcon{512, 1024} tree, giving per-level time breakdown of ffLDL. For
+// degree <= `codelets::MAX_LDL_N` polynomials, closed-form LDL* decomposition
+// and unrolled codelets are used.
+template<const size_t N, const size_t n>
+void
+ffldl_level(benchmark::State& state)
+  requires(((N == 512) || (N == 1024)) && (n > 1) && (n <= N))
+{
+  constexpr size_t k = log2<N>();
+  constexpr size_t lvl = k - log2<n>();
+  constexpr size_t cnt = 1ul << lvl; // # -of subtrees at this level
+
+  constexpr size_t ftlen = (k + 1) * N; // 2^k * (k+1)
+
+  auto G = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto ws = static_cast<uint8_t*>(std::aligned_alloc(
+    scratch::ALIGNMENT, falcon_tree::ffldl_scratch_bytes<n>()));
+  prng::prng_t rng;
+
+  // 2^i self-adjoint Gram matrices of degree n, with positive definite
+  // diagonal, stored one after another
+  for (size_t j = 0; j < cnt; j++) {
+    fft::cmplx* const G_ = G + j * 4 * n;
+
+    for (size_t i = 0; i < n; i++) {
+      uint8_t rnd[4];
+      rng.read(rnd, sizeof(rnd));
+
+      const double g00 = static_cast<double>(rnd[0]) * 64. + 1024.;
+      const double g11 = static_cast<double>(rnd[1]) * 64. + 1024.;
+      const double re = static_cast<double>(rnd[2]) - 128.;
+      const double im = static_cast<double>(rnd[3]) - 128.;
+
+      G_[i] = fft::cmplx{ g00 };
+      G_[2 * n + i] = fft::cmplx{ re, im };
+      G_[n + i] = std::conj(G_[2 * n + i]);
+      G_[3 * n + i] = fft::cmplx{ g11 };
+    }
+  }
+
+  for (auto _ : state) {
+    for (size_t j = 0; j < cnt; j++) {
+      falcon_tree::ffldl<n, lvl, k>(G + j * 4 * n,
+                                    T + lvl * N + j * n,
+                                    reinterpret_cast<fft::cmplx*>(ws));
+    }
+
+    benchmark::DoNotOptimize(T);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["subtrees"] = cnt;
+
+  std::free(G);
+  std::free(T);
+  std::free(ws);
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "key_loader.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark time-to-ready of bulk loader ( see `key_loader::loader_t` ),
+// expanding 256 byte encoded secret keys, using `state.range()` -many worker
+// threads, including cost of spawning them.
+//
+// Reports throughput as # -of expanded keys per second ( of wall clock time ),
+// so that scaling with number of worker threads can be read off directly.
+template<const size_t N>
+void
+load_keys(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t threads = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t kcnt = 256;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * kcnt));
+
+  // key generation is slow, so same secret key is loaded `kcnt` -many times
+  falcon::keygen<N>(pkey, skeys);
+  for (size_t i = 1; i < kcnt; i++) {
+    std::memcpy(skeys + i * sklen, skeys, sklen);
+  }
+
+  for (auto _ : state) {
+    key_loader::loader_t<N> loader(kcnt, threads);
+
+    loader.load(skeys);
+    loader.wait();
+
+    benchmark::DoNotOptimize(loader.failed());
+    assert(loader.failed() == 0);
+
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kcnt));
+
+  std::free(pkey);
+  std::free(skeys);
+}
+
+}
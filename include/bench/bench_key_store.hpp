@@ -0,0 +1,96 @@
+#pragma once
+#include "key_store.hpp"
+#include "prng.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+#include <cstdlib>
+#include <unistd.h>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark startup cost of a signer, which keeps its expanded secret keys in a
+// memory mapped store ( see `key_store::mapped_t` ), holding `state.range()`
+// -many keys. Each iteration opens the store, looks up one key by its id, signs
+// a 32 -bytes message straight from the mapping and unmaps the store, so that
+// reported time covers header/ directory validation and page faults, but none
+// of the key expansion, which was done once, when store was built.
+template<const size_t N>
+void
+open_key_store(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t kcnt = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen];
+  uint8_t id[key_store::ID_LEN];
+  uint8_t other[key_store::ID_LEN];
+  prng::prng_t rng;
+
+  // key generation is slow, so store holds same expanded key under `kcnt`
+  // -many key ids, of which only one is its real id
+  falcon::keygen<N>(pkey, skey);
+  key_store::expand_skey<N, falcon_tree::layout_t::LEVEL_MAJOR>(skey, B, T, id);
+
+  char path[] = "/tmp/falcon_key_store_XXXXXX";
+  const int fd = ::mkstemp(path);
+  assert(fd >= 0);
+
+  key_store::writer_t<N> writer(fd);
+  for (size_t i = 0; i < kcnt - 1; i++) {
+    rng.read(other, sizeof(other));
+    writer.add(other, B, T);
+  }
+  writer.add(id, B, T);
+
+  const bool built = writer.finish();
+  benchmark::DoNotOptimize(built);
+  assert(built);
+
+  rng.read(msg, mlen);
+
+  for (auto _ : state) {
+    key_store::mapped_t<N> store;
+
+    const bool opened = store.open(path);
+    benchmark::DoNotOptimize(opened);
+    assert(opened);
+
+    const size_t idx = store.find(id);
+    benchmark::DoNotOptimize(idx);
+    assert(idx != store.npos);
+
+    falcon::sign<N>(store.B(idx), store.T(idx), msg, mlen, sig, rng);
+
+    benchmark::DoNotOptimize(sig);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+  const bool verified = falcon::verify<N>(pkey, msg, mlen, sig);
+
+  ::close(fd);
+  ::unlink(path);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+  std::free(B);
+  std::free(T);
+
+  assert(verified);
+}
+
+}
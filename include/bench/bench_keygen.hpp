@@ -34,4 +34,116 @@ keygen(benchmark::State& state)
   std::free(skey);
 }
 
+// Benchmark expansion of byte encoded Falcon{512, 1024} secret key into 2x2
+// matrix B and Falcon tree T, which is what signing with a stored secret key
+// costs, before first signature.
+template<const size_t N>
+void
+expand_skey(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  int32_t f[N], g[N], F[N], G[N];
+
+  falcon::keygen<N>(pkey, skey);
+
+  for (auto _ : state) {
+    decoding::decode_skey<N>(skey, f, g, F);
+    falcon::recompute_G<N>(f, g, F, G);
+    falcon::compute_matrix_B<N>(f, g, F, G, B);
+    falcon::compute_falcon_tree<N>(B, T);
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["stored_bytes"] = static_cast<double>(sklen);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(B);
+  std::free(T);
+}
+
+// Benchmark recomputation of G, from f, g and F, which is done during each
+// secret key expansion. When `exact` is set, it's computed using NTT over Z_q
+// ( see `falcon::recompute_G` ), otherwise using FFT over C, with rounding
+// ( see `falcon::recompute_G_fft` ).
+template<const size_t N, const bool exact>
+void
+recompute_G(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  int32_t f[N], g[N], F[N], G[N];
+
+  falcon::keygen<N>(pkey, skey);
+  decoding::decode_skey<N>(skey, f, g, F);
+
+  for (auto _ : state) {
+    if constexpr (exact) {
+      falcon::recompute_G<N>(f, g, F, G);
+    } else {
+      falcon::recompute_G_fft<N>(f, g, F, G);
+    }
+
+    benchmark::DoNotOptimize(G);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+  std::free(pkey);
+  std::free(skey);
+}
+
+// Benchmark regeneration of Falcon{512, 1024} secret key, from 48 -bytes seed,
+// straight into 2x2 matrix B and Falcon tree T ( see `falcon::expand_seed` ).
+// Compare it with `expand_skey`, while `saved_bytes` reports how much less
+// storage is taken per key, by keeping only seed, instead of byte encoded
+// secret key.
+template<const size_t N>
+void
+expand_seed(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t seed[falcon::SEED_LEN];
+  prng::prng_t rng;
+
+  rng.read(seed, sizeof(seed));
+
+  for (auto _ : state) {
+    falcon::expand_seed<N>(seed, B, T);
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["stored_bytes"] = static_cast<double>(sizeof(seed));
+  state.counters["saved_bytes"] = static_cast<double>(sklen - sizeof(seed));
+
+  std::free(B);
+  std::free(T);
+}
+
 }
@@ -0,0 +1,90 @@
+#pragma once
+#include "pkey_store.hpp"
+#include "prng.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+#include <cstdlib>
+#include <unistd.h>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark Falcon{512, 1024} signature verification, using public key looked
+// up by key id, in a memory mapped public key store ( see `pkey_store::mapped_t`
+// ), holding `state.range()` -many keys, in form F. Compare it with `verify`,
+// which decodes public key everytime signature verification is requested.
+template<const size_t N, const pkey_store::form_t F>
+void
+lookup_verify(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t kcnt = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t mlen = 32;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+  uint8_t id[pkey_store::ID_LEN];
+  uint8_t other[pkey_store::ID_LEN];
+  ff::ff_t h[N];
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  rng.read(msg, mlen);
+  const bool _signed = falcon::sign<N>(skey, msg, mlen, sig);
+  assert(_signed);
+
+  // key generation is slow, so store holds same public key under `kcnt`
+  // -many key ids, of which only one is its real id
+  char path[] = "/tmp/falcon_pkey_store_XXXXXX";
+  const int fd = ::mkstemp(path);
+  assert(fd >= 0);
+
+  decoding::decode_pkey<N>(pkey, h);
+  key_store::key_id<N>(pkey, id);
+
+  pkey_store::writer_t<N> writer(fd, F);
+  for (size_t i = 0; i < kcnt - 1; i++) {
+    rng.read(other, sizeof(other));
+    writer.add(other, h);
+  }
+  writer.add(id, h);
+
+  const bool built = writer.finish();
+  benchmark::DoNotOptimize(built);
+  assert(built);
+
+  pkey_store::mapped_t<N> store;
+  const bool opened = store.attach(fd);
+  benchmark::DoNotOptimize(opened);
+  assert(opened);
+
+  for (auto _ : state) {
+    const bool verified = store.verify(id, msg, mlen, sig);
+
+    benchmark::DoNotOptimize(verified);
+    assert(verified);
+
+    benchmark::DoNotOptimize(id);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(sig);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+  store.close();
+  ::close(fd);
+  ::unlink(path);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+}
+
+}
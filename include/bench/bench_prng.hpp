@@ -0,0 +1,48 @@
+#pragma once
+#include "prng.hpp"
+#include <benchmark/benchmark.h>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Benchmark construction of a PRNG, seeded from operating system, followed by
+// reading 32 -bytes out of it, which is what a convenience API had to pay for,
+// on each call, before it started reusing PRNG local to calling thread.
+void
+prng_construct(benchmark::State& state)
+{
+  uint8_t bytes[32];
+
+  for (auto _ : state) {
+    prng::prng_t rng;
+    rng.read(bytes, sizeof(bytes));
+
+    benchmark::DoNotOptimize(rng);
+    benchmark::DoNotOptimize(bytes);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Benchmark looking up PRNG local to calling thread ( see
+// `prng::thread_prng` ), followed by reading 32 -bytes out of it, which is what
+// a convenience API pays for, on each call.
+void
+prng_thread_local(benchmark::State& state)
+{
+  uint8_t bytes[32];
+
+  for (auto _ : state) {
+    prng::prng_t& rng = prng::thread_prng();
+    rng.read(bytes, sizeof(bytes));
+
+    benchmark::DoNotOptimize(rng);
+    benchmark::DoNotOptimize(bytes);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+}
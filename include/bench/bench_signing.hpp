@@ -1,12 +1,35 @@
 #pragma once
+#include "entropy.hpp"
 #include "falcon.hpp"
+#include "fpr.hpp"
+#include "key_cache.hpp"
 #include "prng.hpp"
+#include "stats.hpp"
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <cassert>
+#include <vector>
 
 // Benchmark Falcon PQC suite implementation
 namespace bench_falcon {
 
+// Reports rejection and retry counters of calling thread ( see
+// `stats::counters_t` ), averaged over `sigs` -many signatures, unless counting
+// isn't compiled in, in which case nothing is reported, see `stats::ENABLED`.
+inline void
+report_rejects(benchmark::State& state, const size_t sigs)
+{
+  if constexpr (!stats::ENABLED) {
+    return;
+  }
+
+  const double cnt = static_cast<double>(std::max<size_t>(sigs, 1));
+
+  state.counters["samplerz_rejects"] = stats::counters.samplerz_rejects / cnt;
+  state.counters["norm_rejects"] = stats::counters.norm_rejects / cnt;
+  state.counters["compress_rejects"] = stats::counters.compress_rejects / cnt;
+}
+
 // Benchmark Falcon{512, 1024} message signing algorithm, emulating only single
 // message is signed with secret key.
 //
@@ -57,6 +80,59 @@ sign_single(benchmark::State& state)
   assert(verified);
 }
 
+// Benchmark Falcon{512, 1024} message signing algorithm, using byte encoded
+// secret key, same as `sign_single` does, but with caching of expanded secret
+// keys enabled ( see `key_cache::enable` ), so that in steady state, secret key
+// is expanded only once.
+template<const size_t N>
+void
+sign_cached(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  rng.read(msg, mlen);
+
+  key_cache::enable<N>(4 * key_cache::entry_t<N>::bytes());
+
+  for (auto _ : state) {
+    const bool _signed = falcon::sign<N>(skey, msg, mlen, sig);
+
+    benchmark::DoNotOptimize(_signed);
+    assert(_signed);
+
+    benchmark::DoNotOptimize(skey);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(mlen);
+    benchmark::DoNotOptimize(sig);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+
+  key_cache::disable<N>();
+
+  const bool verified = falcon::verify<N>(pkey, msg, mlen, sig);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+  std::free(msg);
+
+  assert(verified);
+}
+
 // Benchmark Falcon{512, 1024} message signing algorithm, emulating many
 // messages are consecutively signed with same secret key.
 //
@@ -93,6 +169,8 @@ sign_many(benchmark::State& state)
   keygen::keygen<N>(B, T, h, σ, rng);
   rng.read(msg, mlen);
 
+  stats::reset();
+
   for (auto _ : state) {
     falcon::sign<N>(B, T, msg, mlen, sig, rng);
 
@@ -106,11 +184,439 @@ sign_many(benchmark::State& state)
   }
 
   state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["key_bytes"] = sizeof(fft::cmplx) * (matblen + ftlen);
+  report_rejects(state, state.iterations());
+
+  const bool verified = verification::verify<N, β2>(h, msg, mlen, sig);
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(sig);
+  std::free(msg);
+
+  assert(verified);
+}
+
+// Benchmark Falcon{512, 1024} message signing algorithm, same as `sign_many`
+// does, but with matrix B and falcon tree T made of emulated complex numbers (
+// see `fpr::cmplx_t` ), so that all floating point arithmetic of signing is
+// performed using integer instructions. Compare against `sign_many` to find out
+// what bit-identical signing, on every target, costs.
+template<const size_t N>
+void
+sign_emulated(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto Be =
+    static_cast<fpr::cmplx_t*>(std::malloc(sizeof(fpr::cmplx_t) * matblen));
+  auto Te =
+    static_cast<fpr::cmplx_t*>(std::malloc(sizeof(fpr::cmplx_t) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msg, mlen);
+
+  std::transform(B, B + matblen, Be, [](const fft::cmplx c) {
+    return fpr::cmplx_t{ c };
+  });
+  std::transform(T, T + ftlen, Te, [](const fft::cmplx c) {
+    return fpr::cmplx_t{ c };
+  });
+
+  stats::reset();
+
+  for (auto _ : state) {
+    falcon::sign<N>(Be, Te, msg, mlen, sig, rng);
+
+    benchmark::DoNotOptimize(Be);
+    benchmark::DoNotOptimize(Te);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(mlen);
+    benchmark::DoNotOptimize(sig);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  report_rejects(state, state.iterations());
 
   const bool verified = verification::verify<N, β2>(h, msg, mlen, sig);
 
   std::free(B);
   std::free(T);
+  std::free(Be);
+  std::free(Te);
+  std::free(h);
+  std::free(sig);
+  std::free(msg);
+
+  assert(verified);
+}
+
+// Benchmark Falcon{512, 1024} signing, replaying a fixed corpus of messages,
+// each signed with PRNG seeded with a fixed seed of its own, using a secret key
+// generated from a fixed seed, so that every run ( and every iteration ) takes
+// same paths through `samplerz`, norm check and compression, leaving only
+// timing to vary. Rejection and retry counts, reported per signature, must be
+// same across runs of same build.
+template<const size_t N>
+void
+sign_replay(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t CORPUS = 16;
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto sigs = static_cast<uint8_t*>(std::malloc(siglen * CORPUS));
+  auto msgs = static_cast<uint8_t*>(std::malloc(mlen * CORPUS));
+
+  uint8_t seed[falcon::SEED_LEN];
+  for (size_t i = 0; i < sizeof(seed); i++) {
+    seed[i] = static_cast<uint8_t>(i);
+  }
+
+  falcon::keygen_from_seed<N>(seed, pkey, skey);
+  falcon::expand_skey<N>(skey, B, T);
+
+  // message corpus and per message PRNG, both derived from fixed seeds
+  prng::prng_t corpus(seed, sizeof(seed));
+  corpus.read(msgs, mlen * CORPUS);
+
+  std::vector<prng::prng_t> rngs;
+  rngs.reserve(CORPUS);
+
+  for (size_t i = 0; i < CORPUS; i++) {
+    seed[0] = static_cast<uint8_t>(0xff - i);
+    rngs.emplace_back(seed, sizeof(seed));
+  }
+
+  stats::reset();
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < CORPUS; i++) {
+      prng::prng_t rng = rngs[i];
+
+      falcon::sign<N>(B, T, msgs + i * mlen, mlen, sigs + i * siglen, rng);
+    }
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::DoNotOptimize(msgs);
+    benchmark::DoNotOptimize(sigs);
+    benchmark::ClobberMemory();
+  }
+
+  const size_t cnt = static_cast<size_t>(state.iterations()) * CORPUS;
+
+  state.SetItemsProcessed(static_cast<int64_t>(cnt));
+  report_rejects(state, cnt);
+
+  bool verified = true;
+  for (size_t i = 0; i < CORPUS; i++) {
+    const uint8_t* const msg = msgs + i * mlen;
+    verified &= falcon::verify<N>(pkey, msg, mlen, sigs + i * siglen);
+  }
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(B);
+  std::free(T);
+  std::free(sigs);
+  std::free(msgs);
+
+  assert(verified);
+}
+
+// Benchmark Falcon{512, 1024} signing of many messages, with same secret key,
+// when sampler randomness is read out of a ring buffer, which is topped up by
+// entropy producer ( see `entropy::producer_t` ), in between signatures, with
+// timer paused, emulating producer running during idle time or on another
+// core. Compare against `sign_many`, which generates randomness inline.
+template<const size_t N>
+void
+sign_pre_squeezed(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msg, mlen);
+
+  entropy::producer_t producer(1);
+  rng.attach(&producer.ring(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    producer.refill();
+    state.ResumeTiming();
+
+    falcon::sign<N>(B, T, msg, mlen, sig, rng);
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(mlen);
+    benchmark::DoNotOptimize(sig);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["dry"] = producer.ring(0).dry();
+
+  rng.attach(nullptr);
+  const bool verified = verification::verify<N, β2>(h, msg, mlen, sig);
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(sig);
+  std::free(msg);
+
+  assert(verified);
+}
+
+// Benchmark Falcon{512, 1024} lockstep signing of W messages, with same secret
+// key, see `falcon::sign_xn`. Items processed are # -of signatures, so that
+// throughput can be directly compared against `sign_many`.
+template<const size_t N, const size_t W>
+void
+sign_xn(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+  constexpr size_t sclen = signing::sign_xn_scratch_bytes<N, W>();
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sigs_ = static_cast<uint8_t*>(std::malloc(siglen * W));
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(mlen * W));
+  auto scratch_ =
+    static_cast<uint8_t*>(std::aligned_alloc(scratch::ALIGNMENT, sclen));
+  prng::prng_t rng;
+  prng::prng_t rngs[W];
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msgs_, mlen * W);
+
+  const uint8_t* msgs[W];
+  size_t mlens[W];
+  uint8_t* sigs[W];
+
+  for (size_t w = 0; w < W; w++) {
+    msgs[w] = msgs_ + w * mlen;
+    mlens[w] = mlen;
+    sigs[w] = sigs_ + w * siglen;
+  }
+
+  for (auto _ : state) {
+    falcon::sign_xn<N, W>(B, T, msgs, mlens, sigs, rngs, scratch_);
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(T);
+    benchmark::DoNotOptimize(msgs_);
+    benchmark::DoNotOptimize(sigs_);
+    benchmark::DoNotOptimize(rngs);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * W));
+
+  bool verified = true;
+  for (size_t w = 0; w < W; w++) {
+    verified &= verification::verify<N, β2>(h, msgs[w], mlen, sigs[w]);
+  }
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(sigs_);
+  std::free(msgs_);
+  std::free(scratch_);
+
+  assert(verified);
+}
+
+// Benchmark tree-less ( dynamic ) Falcon{512, 1024} message signing algorithm,
+// which keeps matrix B and only top `CACHED` levels of falcon tree resident in
+// memory, recomputing rest of the tree during each signing.
+//
+// Reports how many bytes of expanded secret key are required to be kept in
+// memory, so that signing throughput can be compared against memory footprint
+// per resident key, see `sign_many` for full falcon tree.
+template<const size_t N, const size_t CACHED>
+void
+sign_dyn(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+  constexpr size_t tclen = falcon_tree::cached_tree_len<N, CACHED>();
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto Tc = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tclen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  falcon::compute_cached_tree<N, CACHED>(B, Tc);
+  rng.read(msg, mlen);
+
+  for (auto _ : state) {
+    falcon::sign_dyn<N, CACHED>(B, Tc, msg, mlen, sig, rng);
+
+    benchmark::DoNotOptimize(B);
+    benchmark::DoNotOptimize(Tc);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(mlen);
+    benchmark::DoNotOptimize(sig);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["key_bytes"] = sizeof(fft::cmplx) * (matblen + tclen);
+
+  const bool verified = verification::verify<N, β2>(h, msg, mlen, sig);
+
+  std::free(B);
+  std::free(T);
+  std::free(Tc);
+  std::free(h);
+  std::free(sig);
+  std::free(msg);
+
+  assert(verified);
+}
+
+// Benchmark tree-less ( dynamic ) Falcon{512, 1024} message signing algorithm,
+// which keeps only f, g, F and G resident in memory, recomputing matrix B and
+// whole falcon tree during each signing.
+template<const size_t N>
+void
+sign_dyn_fgFG(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto f = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto g = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto F = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto G = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  prng::prng_t rng;
+
+  ntru_gen::ntru_gen<N>(f, g, F, G, rng);
+  keygen::compute_public_key<N>(f, g, h);
+  rng.read(msg, mlen);
+
+  for (auto _ : state) {
+    falcon::sign_dyn<N>(f, g, F, G, msg, mlen, sig, rng);
+
+    benchmark::DoNotOptimize(f);
+    benchmark::DoNotOptimize(g);
+    benchmark::DoNotOptimize(F);
+    benchmark::DoNotOptimize(G);
+    benchmark::DoNotOptimize(msg);
+    benchmark::DoNotOptimize(mlen);
+    benchmark::DoNotOptimize(sig);
+    benchmark::DoNotOptimize(rng);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.counters["key_bytes"] = sizeof(int32_t) * 4 * N;
+
+  const bool verified = verification::verify<N, β2>(h, msg, mlen, sig);
+
+  std::free(f);
+  std::free(g);
+  std::free(F);
+  std::free(G);
   std::free(h);
   std::free(sig);
   std::free(msg);
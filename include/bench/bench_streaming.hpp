@@ -0,0 +1,116 @@
+#pragma once
+#include "streaming.hpp"
+#include <benchmark/benchmark.h>
+#include <cassert>
+
+// Benchmark Falcon PQC suite implementation
+namespace bench_falcon {
+
+// Byte length of large payload, which is signed/ verified in chunks.
+constexpr size_t STREAM_LEN = 1ul << 20;
+
+// Benchmark streaming Falcon{512, 1024} signer ( see `streaming::signer_t` ),
+// signing 1MB payload, which is fed in chunks of `state.range()` -bytes, using
+// precomputed matrix B and falcon tree T.
+template<const size_t N>
+void
+sign_stream(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t clen = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(STREAM_LEN));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  falcon::expand_skey<N>(skey, B, T);
+  rng.read(msg, STREAM_LEN);
+
+  streaming::signer_t<N> signer(B, T, rng);
+
+  for (auto _ : state) {
+    for (size_t off = 0; off < STREAM_LEN; off += clen) {
+      signer.update(msg + off, std::min(clen, STREAM_LEN - off));
+    }
+    signer.final(sig);
+
+    benchmark::DoNotOptimize(sig);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * STREAM_LEN));
+
+  const bool verified = falcon::verify<N>(pkey, msg, STREAM_LEN, sig);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+  std::free(msg);
+  std::free(B);
+  std::free(T);
+
+  assert(verified);
+}
+
+// Benchmark streaming Falcon{512, 1024} verifier ( see `streaming::verifier_t`
+// ), verifying signature over 1MB payload, which is fed in chunks of
+// `state.range()` -bytes.
+template<const size_t N>
+void
+verify_stream(benchmark::State& state)
+  requires((N == 512) || (N == 1024))
+{
+  const size_t clen = state.range();
+
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(STREAM_LEN));
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  rng.read(msg, STREAM_LEN);
+  const bool _signed = falcon::sign<N>(skey, msg, STREAM_LEN, sig);
+  assert(_signed);
+
+  streaming::verifier_t<N> verifier(pkey);
+
+  for (auto _ : state) {
+    verifier.init(sig);
+    for (size_t off = 0; off < STREAM_LEN; off += clen) {
+      verifier.update(msg + off, std::min(clen, STREAM_LEN - off));
+    }
+    const bool verified = verifier.final();
+
+    benchmark::DoNotOptimize(verified);
+    assert(verified);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations() * STREAM_LEN));
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+  std::free(msg);
+}
+
+}
@@ -54,4 +54,124 @@ verify(benchmark::State& state)
   std::free(msg);
 }
 
+// Benchmark hashing of salt and message to a point, for W messages, where W = 1
+// means one after another ( see `hashing::hash_to_point` ), otherwise all W at
+// once ( see `hashing::hash_to_point_xn` ). Items processed are # -of messages.
+template<const size_t N, const size_t W>
+void
+hash_to_point(benchmark::State& state)
+  requires(((N == 512) || (N == 1024)) && ((W == 1) || (W == 4) || (W == 8)))
+{
+  const size_t mlen = state.range();
+
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(mlen * W));
+  auto polys_ = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N * W));
+  uint8_t salt[W][40];
+  prng::prng_t rng;
+
+  const uint8_t* salts[W];
+  const uint8_t* msgs[W];
+  size_t mlens[W];
+  ff::ff_t* polys[W];
+
+  rng.read(msgs_, mlen * W);
+
+  for (size_t w = 0; w < W; w++) {
+    rng.read(salt[w], sizeof(salt[w]));
+
+    salts[w] = salt[w];
+    msgs[w] = msgs_ + w * mlen;
+    mlens[w] = mlen;
+    polys[w] = polys_ + w * N;
+  }
+
+  for (auto _ : state) {
+    if constexpr (W == 1) {
+      hashing::hash_to_point<N>(salts[0], 40, msgs[0], mlen, polys[0]);
+    } else {
+      hashing::hash_to_point_xn<N, W>(salts, 40, msgs, mlens, polys);
+    }
+
+    benchmark::DoNotOptimize(polys_);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * W));
+
+  std::free(msgs_);
+  std::free(polys_);
+}
+
+// Benchmark verification of W signatures at once, with public key already in
+// NTT form, see `verification::verify_ntt_xn`. Items processed are # -of
+// signatures.
+template<const size_t N, const size_t W>
+void
+verify_xn(benchmark::State& state)
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  const size_t mlen = state.range();
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t matblen = 2 * 2 * N; // 2x2 matrix B = [[g, -f], [G, -F]]
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>()); // 2^k * (k+1)
+  constexpr size_t sclen = verification::verify_ntt_xn_scratch_bytes<N, W>();
+
+  // see table 3.3 of falcon specification
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  // see table 3.3 of falcon specification
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * matblen));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto sigs_ = static_cast<uint8_t*>(std::malloc(siglen * W));
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(mlen * W));
+  auto scratch_ =
+    static_cast<uint8_t*>(std::aligned_alloc(scratch::ALIGNMENT, sclen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msgs_, mlen * W);
+
+  const ff::ff_t* hs[W];
+  const uint8_t* msgs[W];
+  const uint8_t* sigs[W];
+  size_t mlens[W];
+  bool ok[W];
+
+  for (size_t w = 0; w < W; w++) {
+    falcon::sign<N>(B, T, msgs_ + w * mlen, mlen, sigs_ + w * siglen, rng);
+
+    hs[w] = h;
+    msgs[w] = msgs_ + w * mlen;
+    sigs[w] = sigs_ + w * siglen;
+    mlens[w] = mlen;
+  }
+
+  ntt::ntt<log2<N>()>(h);
+
+  for (auto _ : state) {
+    const bool verified = verification::verify_ntt_xn<N, β2, W>(
+      hs, msgs, mlens, sigs, ok, scratch_);
+
+    benchmark::DoNotOptimize(verified);
+    assert(verified);
+    benchmark::DoNotOptimize(ok);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * W));
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(sigs_);
+  std::free(msgs_);
+  std::free(scratch_);
+}
+
 }
@@ -0,0 +1,240 @@
+#pragma once
+#include "ff.hpp"
+#include "isa.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__)
+#define FALCON_BITPACK_BMI2
+#include <immintrin.h>
+#endif
+
+// Packing and unpacking of fixed-width fields of Falcon{512, 1024} public and
+// secret keys, using BMI2 `pdep`/ `pext` instructions
+namespace bitpack {
+
+// Whether BMI2 packers are to be used, which is so when ISA variant in use (
+// see `isa::active` ) is AVX2 or higher, as both of them imply BMI2. Binaries
+// compiled for baseline x86_64 thus still use BMI2, when CPU has it, while
+// encoding/ decoding routines fall back to their portable code otherwise (
+// including on non-x86_64 targets ).
+//
+// Note, on AMD CPUs before Zen 3, `pdep`/ `pext` are microcoded and much
+// slower than shifts and masks. Set environment variable `FALCON_ISA` to
+// "scalar" to use portable code.
+inline bool
+has_bmi2()
+{
+#if defined FALCON_BITPACK_BMI2
+  return isa::active() >= isa::level_t::AVX2;
+#else
+  return false;
+#endif
+}
+
+#if defined FALCON_BITPACK_BMI2
+
+// Fields are packed little-endian, least significant bit first, so that n
+// consecutive W -bit fields form an (n * W) -bit little-endian integer, which
+// `pdep` spreads out into n lanes of 8 or 16 bits, while `pext` does reverse.
+
+// Loads `len` ( <= 8 ) -bytes as a little-endian 64 -bit integer.
+static inline uint64_t
+load_le(const uint8_t* const bytes, const size_t len)
+{
+  uint64_t word = 0;
+  std::memcpy(&word, bytes, len);
+  return word;
+}
+
+// Stores low `len` ( <= 8 ) -bytes of a 64 -bit integer, little-endian.
+static inline void
+store_le(uint8_t* const bytes, const uint64_t word, const size_t len)
+{
+  std::memcpy(bytes, &word, len);
+}
+
+// Unpacks n ( multiple of 4 ) 14 -bit fields, 4 of them from every 7 -bytes,
+// as elements of Fq, which is how public key stores them.
+__attribute__((target("bmi2"))) static inline void
+unpack14(const uint8_t* const __restrict in,
+         ff::ff_t* const __restrict out,
+         const size_t n)
+{
+  constexpr uint64_t mask = 0x3fff3fff3fff3ffful;
+
+  for (size_t i = 0, off = 0; i < n; i += 4, off += 7) {
+    // last 7 -bytes are loaded as is, to not read past end of input
+    const size_t len = (i + 4 < n) ? 8 : 7;
+    const uint64_t lanes = _pdep_u64(load_le(in + off, len), mask);
+
+    out[i + 0].v = static_cast<uint16_t>(lanes >> 0);
+    out[i + 1].v = static_cast<uint16_t>(lanes >> 16);
+    out[i + 2].v = static_cast<uint16_t>(lanes >> 32);
+    out[i + 3].v = static_cast<uint16_t>(lanes >> 48);
+  }
+}
+
+// Packs n ( multiple of 4 ) elements of Fq, as 14 -bit fields, 4 of them into
+// every 7 -bytes.
+__attribute__((target("bmi2"))) static inline void
+pack14(const ff::ff_t* const __restrict in,
+       uint8_t* const __restrict out,
+       const size_t n)
+{
+  constexpr uint64_t mask = 0x3fff3fff3fff3ffful;
+
+  for (size_t i = 0, off = 0; i < n; i += 4, off += 7) {
+    const uint64_t lanes = (static_cast<uint64_t>(in[i + 0].v) << 0) |
+                           (static_cast<uint64_t>(in[i + 1].v) << 16) |
+                           (static_cast<uint64_t>(in[i + 2].v) << 32) |
+                           (static_cast<uint64_t>(in[i + 3].v) << 48);
+
+    // last 7 -bytes are stored as is, to not write past end of output
+    const size_t len = (i + 4 < n) ? 8 : 7;
+    store_le(out + off, _pext_u64(lanes, mask), len);
+  }
+}
+
+// Unpacks n ( multiple of 8 ) W -bit fields, 8 of them from every W -bytes, as
+// W -bit two's complement integers, sign extending them to 32 -bits.
+template<const size_t W>
+__attribute__((target("bmi2"))) static inline void
+unpack_signed(const uint8_t* const __restrict in,
+              int32_t* const __restrict out,
+              const size_t n)
+  requires((W == 5) || (W == 6))
+{
+  constexpr uint64_t mask = 0x0101010101010101ul * ((1u << W) - 1);
+
+  for (size_t i = 0, off = 0; i < n; i += 8, off += W) {
+    // last W -bytes are loaded as is, to not read past end of input
+    const size_t len = (i + 8 < n) ? 8 : W;
+
+    // move sign bit of each field to top of its byte lane
+    const uint64_t lanes = _pdep_u64(load_le(in + off, len), mask) << (8 - W);
+
+    int8_t bytes[8];
+    std::memcpy(bytes, &lanes, sizeof(lanes));
+
+    for (size_t j = 0; j < 8; j++) {
+      out[i + j] = static_cast<int32_t>(bytes[j]) >> (8 - W);
+    }
+  }
+}
+
+// Packs n ( multiple of 8 ) signed integers, each ∈ [-2^(W-1), 2^(W-1)), as W
+// -bit two's complement fields, 8 of them into every W -bytes.
+template<const size_t W>
+__attribute__((target("bmi2"))) static inline void
+pack_signed(const int32_t* const __restrict in,
+            uint8_t* const __restrict out,
+            const size_t n)
+  requires((W == 5) || (W == 6))
+{
+  constexpr uint64_t mask = 0x0101010101010101ul * ((1u << W) - 1);
+
+  for (size_t i = 0, off = 0; i < n; i += 8, off += W) {
+    uint8_t bytes[8];
+    for (size_t j = 0; j < 8; j++) {
+      bytes[j] = static_cast<uint8_t>(in[i + j]);
+    }
+
+    uint64_t lanes = 0;
+    std::memcpy(&lanes, bytes, sizeof(lanes));
+
+    // last W -bytes are stored as is, to not write past end of output
+    const size_t len = (i + 8 < n) ? 8 : W;
+    store_le(out + off, _pext_u64(lanes, mask), len);
+  }
+}
+
+#endif
+
+// Packs public key polynomial h, returning false, without touching `out`, when
+// BMI2 packers can't be used, so that caller falls back to portable code.
+template<const size_t N>
+static inline bool
+try_pack_h(const ff::ff_t* const __restrict h, uint8_t* const __restrict out)
+  requires((N == 512) || (N == 1024))
+{
+#if defined FALCON_BITPACK_BMI2
+  if (has_bmi2()) {
+    pack14(h, out, N);
+    return true;
+  }
+#endif
+  (void)h;
+  (void)out;
+  return false;
+}
+
+// Unpacks public key polynomial h, returning false, without touching `h`, when
+// BMI2 unpackers can't be used.
+template<const size_t N>
+static inline bool
+try_unpack_h(const uint8_t* const __restrict in, ff::ff_t* const __restrict h)
+  requires((N == 512) || (N == 1024))
+{
+#if defined FALCON_BITPACK_BMI2
+  if (has_bmi2()) {
+    unpack14(in, h, N);
+    return true;
+  }
+#endif
+  (void)in;
+  (void)h;
+  return false;
+}
+
+// Packs secret key polynomials f and g, back to back, using 6 -bits ( N = 512 )
+// or 5 -bits ( N = 1024 ) per coefficient, returning false, without touching
+// `out`, when BMI2 packers can't be used.
+template<const size_t N>
+static inline bool
+try_pack_fg(const int32_t* const __restrict f,
+            const int32_t* const __restrict g,
+            uint8_t* const __restrict out)
+  requires((N == 512) || (N == 1024))
+{
+#if defined FALCON_BITPACK_BMI2
+  constexpr size_t W = N == 512 ? 6 : 5;
+
+  if (has_bmi2()) {
+    pack_signed<W>(f, out, N);
+    pack_signed<W>(g, out + (W * N) / 8, N);
+    return true;
+  }
+#endif
+  (void)f;
+  (void)g;
+  (void)out;
+  return false;
+}
+
+// Unpacks secret key polynomials f and g, returning false, without touching
+// them, when BMI2 unpackers can't be used.
+template<const size_t N>
+static inline bool
+try_unpack_fg(const uint8_t* const __restrict in,
+              int32_t* const __restrict f,
+              int32_t* const __restrict g)
+  requires((N == 512) || (N == 1024))
+{
+#if defined FALCON_BITPACK_BMI2
+  constexpr size_t W = N == 512 ? 6 : 5;
+
+  if (has_bmi2()) {
+    unpack_signed<W>(in, f, N);
+    unpack_signed<W>(in + (W * N) / 8, g, N);
+    return true;
+  }
+#endif
+  (void)in;
+  (void)f;
+  (void)g;
+  return false;
+}
+
+}
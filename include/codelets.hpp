@@ -0,0 +1,134 @@
+#pragma once
+#include "fft.hpp"
+#include <utility>
+
+// Fully unrolled, straight-line codelets for polynomials ( in FFT form ) of
+// small degree, used at bottom levels of ffSampling and ffLDL recursion, where
+// loop and call overhead of generic routines dominates actual arithmetic.
+//
+// Each codelet performs exactly same floating point operations, in same order,
+// as its generic counterpart ( see fft.hpp and polynomial.hpp ), so results
+// don't depend on which one is used. Complex multiplication is spelled out as
+// real arithmetic, see `fft::mul`.
+//
+// Codelets ( and lambdas unrolling them ) are forcibly inlined, as large
+// translation units otherwise exhaust compiler's inlining budget, emitting them
+// as out-of-line calls, which defeats their purpose.
+namespace codelets {
+
+// Maximum degree of polynomials, for which codelets are used in ffSampling
+constexpr size_t MAX_N = 8;
+
+// Maximum degree of polynomials, for which closed-form LDL* decomposition and
+// unrolled child Gram matrix computation are used in ffLDL
+constexpr size_t MAX_LDL_N = 4;
+
+// Unrolled `fft::split_fft`, for polynomials with 2^LOG2N coefficients.
+template<const size_t LOG2N, fft::complex_number C>
+[[gnu::always_inline]] static inline void
+split_fft(const C* const __restrict f,
+          C* const __restrict f0,
+          C* const __restrict f1)
+  requires((LOG2N > 0) && ((1ul << LOG2N) <= MAX_N))
+{
+  constexpr size_t hN = (1ul << LOG2N) >> 1;
+  constexpr fft::real_t<C> half{ 0.5 };
+
+  [&]<size_t... i>(std::index_sequence<i...>)
+    __attribute__((always_inline)) {
+    ((f0[i] = half * (f[2 * i] + f[2 * i + 1]),
+      f1[i] = fft::mul(half * (f[2 * i] - f[2 * i + 1]),
+                  conj(C{ fft::POWERS_OF_ζ[hN + i] }))),
+     ...);
+  }(std::make_index_sequence<hN>{});
+}
+
+// Unrolled `fft::merge_fft`, for polynomials with 2^LOG2N coefficients.
+template<const size_t LOG2N, fft::complex_number C>
+[[gnu::always_inline]] static inline void
+merge_fft(const C* const __restrict f0,
+          const C* const __restrict f1,
+          C* const __restrict f)
+  requires((LOG2N > 0) && ((1ul << LOG2N) <= MAX_N))
+{
+  constexpr size_t hN = (1ul << LOG2N) >> 1;
+
+  [&]<size_t... i>(std::index_sequence<i...>)
+    __attribute__((always_inline)) {
+    ((f[2 * i + 0] = f0[i] + fft::mul(f1[i], C{ fft::POWERS_OF_ζ[hN + i] }),
+      f[2 * i + 1] = f0[i] - fft::mul(f1[i], C{ fft::POWERS_OF_ζ[hN + i] })),
+     ...);
+  }(std::make_index_sequence<hN>{});
+}
+
+// Fused computation of t0' = t0 + (t1 - z1) * l, for polynomials with 2^LOG2N
+// coefficients, as done between sampling of right and left subtrees, in
+// ffSampling.
+template<const size_t LOG2N, fft::complex_number C>
+[[gnu::always_inline]] static inline void
+sub_mul_add(const C* const __restrict t0,
+            const C* const __restrict t1,
+            const C* const __restrict z1,
+            const C* const __restrict l,
+            C* const __restrict t0_)
+  requires((1ul << LOG2N) <= MAX_N)
+{
+  constexpr size_t N = 1ul << LOG2N;
+
+  [&]<size_t... i>(std::index_sequence<i...>)
+    __attribute__((always_inline)) {
+    ((t0_[i] = t0[i] + fft::mul(t1[i] - z1[i], l[i])), ...);
+  }(std::make_index_sequence<N>{});
+}
+
+// Closed-form LDL* decomposition of self-adjoint 2x2 Gram matrix G, for
+// polynomials with 2^LOG2N coefficients, s.t.
+//
+// l10 = g10 / g00
+// d00 = g00
+// d11 = g11 - (l10 * l10*) * g00
+//
+// See `falcon_tree::ldl` for generic counterpart.
+template<const size_t LOG2N, fft::complex_number C>
+[[gnu::always_inline]] static inline void
+ldl(const C* const __restrict G,
+    C* const __restrict l10,
+    C* const __restrict d00,
+    C* const __restrict d11)
+  requires((LOG2N > 0) && ((1ul << LOG2N) <= MAX_N))
+{
+  constexpr size_t N = 1ul << LOG2N;
+
+  const C* g00 = G;
+  const C* g10 = G + 2 * N;
+  const C* g11 = G + 3 * N;
+
+  [&]<size_t... i>(std::index_sequence<i...>)
+    __attribute__((always_inline)) {
+    ((d00[i] = g00[i],
+      l10[i] = g10[i] / g00[i],
+      d11[i] = g11[i] - fft::mul(fft::mul(l10[i], conj(l10[i])), g00[i])),
+     ...);
+  }(std::make_index_sequence<N>{});
+}
+
+// Unrolled `falcon_tree::child_gram`, computing 2x2 Gram matrix [[d0, d1],
+// [d1*, d0*]] of child node, from diagonal element D with 2^LOG2N
+// coefficients.
+template<const size_t LOG2N, fft::complex_number C>
+[[gnu::always_inline]] static inline void
+child_gram(const C* const __restrict D, C* const __restrict G)
+  requires((LOG2N > 0) && ((1ul << LOG2N) <= MAX_N))
+{
+  constexpr size_t N = 1ul << LOG2N;
+  constexpr size_t hN = N >> 1;
+
+  split_fft<LOG2N>(D, G, G + hN);
+
+  [&]<size_t... i>(std::index_sequence<i...>)
+    __attribute__((always_inline)) {
+    ((G[N + i] = conj(G[hN + i]), G[N + hN + i] = conj(G[i])), ...);
+  }(std::make_index_sequence<hN>{});
+}
+
+}
@@ -1,6 +1,8 @@
 #pragma once
+#include "bitpack.hpp"
 #include "common.hpp"
 #include "utils.hpp"
+#include <bit>
 #include <cstring>
 
 // Falcon KeyPair and Signature Decoding Routines
@@ -29,6 +31,10 @@ decode_pkey(const uint8_t* const __restrict pkey, ff::ff_t* const __restrict h)
     return false;
   }
 
+  if (bitpack::try_unpack_h<N>(pkey + 1, h)) {
+    return true;
+  }
+
   for (size_t pkoff = 1, hoff = 0; pkoff < pklen; pkoff += 7, hoff += 4) {
     h[hoff + 0].v = (static_cast<uint16_t>(pkey[pkoff + 1] & mask6) << 8) |
                     (static_cast<uint16_t>(pkey[pkoff + 0]) << 0);
@@ -72,7 +78,10 @@ decode_skey(const uint8_t* const __restrict skey,
 
   size_t skoff = 1;
 
-  if constexpr (N == 512) {
+  if (bitpack::try_unpack_fg<N>(skey + skoff, f, g)) {
+    // f and g use 6 -bits ( N = 512 ) or 5 -bits ( N = 1024 ) per coefficient
+    skoff += 2 * (N * (N == 512 ? 6 : 5)) / 8;
+  } else if constexpr (N == 512) {
     // force compile-time branch evaluation
     static_assert(N == 512, "N must be = 512 !");
 
@@ -170,84 +179,63 @@ decode_skey(const uint8_t* const __restrict skey,
   return true;
 }
 
-// Given a byte array, this routine extracts out 8 contiguous bits from given
-// bit index ( bitoff ).
-//
-// Imagine we've a byte array of length N (>=2) s.t. bits inside each byte are
-// enumerated as following
-//
-// b0,b1,b2,b3,b4,b5,b6,b7 | b0,b1,b2,b3,b4,b5,b6,b7 | ...
-// ---------------------- | ----------------------- | ...
-//      byte 0           |        byte 1           | ...
-//
-// b0 <- most significant bit
-// b7 <- least significant bit
+// Bit reader, over a byte array, which reads bits most significant first, out
+// of a left aligned 64 -bit accumulator, refilling it 8 -bytes at a time, while
+// that many are left, then a byte at a time, so that it never reads past end of
+// byte array.
 //
-// Now think we're asked to extract out 8 contiguous bits. starting from bit
-// index 5, then we'll figure
-//
-// - we're starting from byte index 0 ( = 5/ 8  )
-// - we should start accessing from bit index 5 ( = 5% 8 ) of byte index 0
-// - first we'll take 3 least significant bits of byte index 0
-// - finally we'll take 5 most significant bits of byte index 1
-// - that forms out uint8_t return value, holding 8 contiguous bits of interest
-//
-// If we're asked to extract 8 contigous bits, starting from bit index 11, then
-// we should figure
-//
-// - start from byte index 1 ( = 11/ 8 )
-// - start from bit index 3 ( = 11% 8 ) of byte index 1
-// - take 5 least significant bits of byte index 1
-// - and take 3 most significant bits of byte index 2
-//
-// Now notice, if we're working with a byte array of length 2 and we're asked to
-// extract 8 contiguous bits, starting from bit index 11, we will access memory
-// location which we're not supposed to be. So it's caller's responsibility to
-// ensure that atleast 2 consecutive memory locations ( i.e. bytes ) can be
-// accessed, starting from byte index (bitoff / 8).
-static inline constexpr uint8_t
-extract_8_contiguous_bits(const uint8_t* const __restrict bytes,
-                          const size_t bitoff)
+// Only top `cnt` -bits of `acc` are counted as being read into accumulator,
+// though bits below them may also be set, holding bits which follow them in
+// byte array, as they get OR-ed in again, with same value, on next refill.
+struct bit_reader_t
 {
-  const size_t byte_at = bitoff >> 3;
-  const size_t bit_at = bitoff & 7ul;
+  const uint8_t* const bytes;
+  const size_t len; // byte length of array
+  size_t off = 0;   // bytes read into accumulator, so far
+  uint64_t acc = 0;
+  size_t cnt = 0;
+
+  // Tops up accumulator, s.t. it holds at least 57 -bits, unless end of byte
+  // array is reached.
+  inline void refill()
+  {
+    if (off + 8 <= len) [[likely]] {
+      uint64_t word = 0;
+      for (size_t i = 0; i < 8; i++) {
+        word = (word << 8) | static_cast<uint64_t>(bytes[off + i]);
+      }
 
-  const uint16_t word = (static_cast<uint16_t>(bytes[byte_at]) << 8) |
-                        static_cast<uint16_t>(bytes[byte_at + 1]);
+      acc |= word >> cnt;
+      off += (63 - cnt) >> 3;
+      cnt |= 56;
+    } else {
+      while ((cnt <= 56) && (off < len)) {
+        acc |= static_cast<uint64_t>(bytes[off++]) << (56 - cnt);
+        cnt += 8;
+      }
+    }
+  }
 
-  return static_cast<uint8_t>(word >> (8 - bit_at));
-}
+  // Drops n ( < 64 ) -bits, from top of accumulator.
+  inline void skip(const size_t n)
+  {
+    acc <<= n;
+    cnt -= n;
+  }
 
-// Given a byte array and starting bit index, this routine extracts out next n
-// contiguous bits s.t. n <= 8 and no bits from next byte is ever touched i.e.
-// only bits living at starting byte index are extracted out.
-//
-// Lets take an example, say we've a byte array which looks like following, when
-// bits are enumerated
-//
-// b0,b1,b2,b3,b4,b5,b6,b7 | b0,b1,b2,b3,b4,b5,b6,b7 / ...
-// ---------------------- | ----------------------- / ...
-//      byte 0           |        byte 1           / ...
-//
-// b0 <- most significant bit
-// b7 <- least significant bit
-//
-// Now I want to extract all remaining bits starting from bit index 12, so I
-// figure
-//
-// - starting byte index = 12/ 8 = 1
-// - starting bit index inside byte index 1 = 12% 8 = 4
-// - remaining bits in byte index 1 = 7 - 4 + 1 = 4
-// - extracts out <b4,b5,b6,b7> of byte index 1 as <b4,b5,b6,b7,0,0,0,0>
-static inline constexpr uint8_t
-extract_rem_contiguous_bits_in_byte(const uint8_t* const __restrict bytes,
-                                    const size_t bitoff)
-{
-  const size_t byte_at = bitoff >> 3;
-  const size_t bit_at = bitoff & 7ul;
+  // Whether all bits, which are yet to be read, are 0.
+  inline bool rest_is_zero() const
+  {
+    bool zero = (cnt == 0) || ((acc >> (64 - cnt)) == 0);
+    for (size_t i = off; i < len; i++) {
+      zero &= bytes[i] == 0;
+    }
+    return zero;
+  }
 
-  return bytes[byte_at] << bit_at;
-}
+  // Number of bits, which are yet to be read.
+  inline size_t remaining() const { return cnt + 8 * (len - off); }
+};
 
 // Given compressed signature bytes, this routine attempts to decompress it back
 // to a degree N polynomial s.t. coefficients ∈ Z[x] and they are distributed
@@ -260,8 +248,16 @@ extract_rem_contiguous_bits_in_byte(const uint8_t* const __restrict bytes,
 //
 // This routine doesn't access first 41 -bytes of signature.
 //
+// Sign bit and low 7 -bits of a coefficient are taken off top of a 64 -bit bit
+// buffer ( see `bit_reader_t` ), with a single shift, while high bits, which
+// are encoded in unary, are found by counting leading zeros of whole buffer.
+// Encoding must be canonical i.e. 0 must not be encoded with sign bit set and
+// at least one bit must be left, after last coefficient, all of which must be
+// 0, otherwise decompression fails.
+//
 // In case of successful decompression, returns boolean truth value, otherwise
-// returns false, denoting decompression failure.
+// returns false, denoting decompression failure, in which case `poly_s` is
+// zeroed.
 template<const size_t N, const size_t sbytelen>
 static inline bool
 decompress_sig(const uint8_t* const __restrict sig,
@@ -269,90 +265,57 @@ decompress_sig(const uint8_t* const __restrict sig,
   requires(((N == 512) && (sbytelen == 666)) ||
            ((N == 1024) && (sbytelen == 1280)))
 {
-  constexpr size_t slen = 8 * sbytelen; // signature bit length
-
-  size_t bit_idx = 8 +  // header byte
-                   320; // salt bytes
-  size_t coeff_idx = 0;
+  bit_reader_t br{ sig + (1 + 40), sbytelen - (1 + 40) };
   bool failed = false;
 
-  while ((coeff_idx < N) && (bit_idx < slen)) {
-    int32_t coeff = 0;
-    uint8_t sign_bit = 0;
+  for (size_t coeff_idx = 0; (coeff_idx < N) && !failed; coeff_idx++) {
+    if (br.cnt < 32) {
+      br.refill();
+      if (br.cnt < 8) [[unlikely]] {
+        failed = true;
+        break;
+      }
+    }
 
     // extracts sign bit and low ( least significant ) 7 bits of coefficient
-    {
-      const uint8_t res = extract_8_contiguous_bits(sig, bit_idx);
-
-      sign_bit = res >> 7; // sign bit
-      coeff = res & 0x7f;  // low 7 bits of coefficient
-      bit_idx += 8;
-    }
+    const uint32_t head = static_cast<uint32_t>(br.acc >> 56);
+    br.skip(8);
 
     // extract high bits of coefficient, which was encoded using unary code
-    {
-      size_t k = std::countl_zero(extract_8_contiguous_bits(sig, bit_idx));
-      if (k < 8) [[likely]] {
-        coeff += (1 << 7) * k;
-        bit_idx += k;
-      } else {
-        bit_idx += k;
-        for (; bit_idx < slen;) {
-          const auto ebits = std::min(8ul, slen - bit_idx);
-
-          size_t v = 0;
-          if (ebits < 8) {
-            const auto t = extract_rem_contiguous_bits_in_byte(sig, bit_idx);
-            v = std::countl_zero(t);
-          } else {
-            const auto t = extract_8_contiguous_bits(sig, bit_idx);
-            v = std::countl_zero(t);
-          }
-          k += v;
-          bit_idx += ebits;
-
-          if (v < ebits) {
-            break;
-          }
-        }
+    uint32_t k = 0;
+    while (true) {
+      const size_t z = std::countl_zero(br.acc);
+      if (z < br.cnt) [[likely]] {
+        k += static_cast<uint32_t>(z);
+        br.skip(z);
+        br.skip(1);
+        break;
+      }
+
+      // all bits in accumulator are 0, keep counting after refilling it
+      k += static_cast<uint32_t>(br.cnt);
+      br.acc = 0;
+      br.cnt = 0;
+
+      br.refill();
+      if (br.cnt == 0) [[unlikely]] {
+        failed = true;
+        break;
       }
     }
 
-    // recompute coefficient s_i
-    coeff = sign_bit == 1 ? -coeff : coeff;
+    const bool sign_bit = (head >> 7) == 1;
+    const int32_t coeff = static_cast<int32_t>((head & 0x7fu) + (k << 7));
 
     // enforce unique encoding of 0
-    failed |= (coeff == 0) && (sign_bit == 1);
-    if (failed) {
-      break;
-    }
+    failed |= (coeff == 0) && sign_bit;
 
     // seems all good with decoding of this coefficient
-    poly_s[coeff_idx] = coeff;
-
-    bit_idx += 1;
-    coeff_idx += 1;
+    poly_s[coeff_idx] = sign_bit ? -coeff : coeff;
   }
 
   // enforce trailing bits are 0
-  failed |= (bit_idx >= slen) | (coeff_idx < N);
-  if (!failed) {
-    for (; bit_idx < slen;) {
-      const size_t ebits = std::min(8ul, slen - bit_idx);
-
-      size_t v = 0;
-      if (ebits == 8) [[likely]] {
-        const auto t = extract_8_contiguous_bits(sig, bit_idx);
-        v = std::countl_zero(t);
-      } else {
-        const auto t = extract_rem_contiguous_bits_in_byte(sig, bit_idx);
-        v = std::countl_zero(t);
-      }
-
-      bit_idx += ebits;
-      failed |= (v < ebits);
-    }
-  }
+  failed |= (br.remaining() == 0) || !br.rest_is_zero();
 
   std::memset(poly_s, 0, sizeof(int32_t) * N * failed);
   return !failed;
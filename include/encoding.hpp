@@ -1,5 +1,8 @@
 #pragma once
+#include "bitpack.hpp"
 #include "common.hpp"
+#include "fft.hpp"
+#include <cmath>
 #include <complex>
 #include <cstring>
 
@@ -20,6 +23,10 @@ encode_pkey(const ff::ff_t* const __restrict h, uint8_t* const __restrict pkey)
   constexpr uint16_t mask2 = 0x03;
 
   pkey[0] = header;
+  if (bitpack::try_pack_h<N>(h, pkey + 1)) {
+    return;
+  }
+
   for (size_t hoff = 0, pkoff = 1; hoff < N; hoff += 4, pkoff += 7) {
     pkey[pkoff + 0] = static_cast<uint8_t>(h[hoff + 0].v);
     pkey[pkoff + 1] = (static_cast<uint8_t>(h[hoff + 1].v & mask2) << 6) |
@@ -48,7 +55,10 @@ encode_skey(const int32_t* const __restrict f,
   size_t skoff = 0;
   skey[skoff++] = 0x50 | static_cast<uint8_t>(log2<N>());
 
-  if constexpr (N == 512) {
+  if (bitpack::try_pack_fg<N>(f, g, skey + skoff)) {
+    // f and g use 6 -bits ( N = 512 ) or 5 -bits ( N = 1024 ) per coefficient
+    skoff += 2 * (N * (N == 512 ? 6 : 5)) / 8;
+  } else if constexpr (N == 512) {
     // force compile-time branch evaluation
     static_assert(N == 512, "N must be = 512 !");
     constexpr int32_t wrap_at = 1 << 6;
@@ -152,81 +162,149 @@ encode_skey(const int32_t* const __restrict f,
   }
 }
 
-// Given a degree N polynomials with coefficients ∈ Z[x] s.t. they are
-// distributed around 0 according to a discrete Gaussian distribution, this
-// routine attempts to compress it using (sbytelen * 8 - 328) -bits, following
-// algorithm 17 of Falcon specification https://falcon-sign.info/falcon.pdf
-//
-// Layout of sig = <8 -bits of header> +
-//                 <320 -bits of salt> +
-//                 <{666, 1280} - 41 -bytes of compressed signature>
-//
-// This routine doesn't access first 41 -bytes of signature, setting those bytes
-// properly is not responsibility of this routine.
+// Appends `len` ( <= 32 ) low bits of `bits`, most significant bit first, to
+// 64 -bit accumulator `acc`, which holds `acc_len` ( < 32 ) pending bits. Once
+// 32 or more bits are pending, top 32 of them are flushed, as 4 bytes, to `out`
+// at byte offset `off`.
+static inline void
+put_bits(uint8_t* const __restrict out,
+         size_t& off,
+         uint64_t& acc,
+         size_t& acc_len,
+         const uint32_t bits,
+         const size_t len)
+{
+  acc = (acc << len) | bits;
+  acc_len += len;
+
+  if (acc_len >= 32) {
+    acc_len -= 32;
+    const uint32_t word = static_cast<uint32_t>(acc >> acc_len);
+
+    out[off + 0] = static_cast<uint8_t>(word >> 24);
+    out[off + 1] = static_cast<uint8_t>(word >> 16);
+    out[off + 2] = static_cast<uint8_t>(word >> 8);
+    out[off + 3] = static_cast<uint8_t>(word >> 0);
+    off += 4;
+  }
+}
+
+// Compresses N coefficients, i-th of which is returned by `coeff(i)`, following
+// algorithm 17 of Falcon specification https://falcon-sign.info/falcon.pdf, see
+// `compress_sig` below.
 //
-// In case of successful compression, returns boolean truth value, otherwise
-// returns false, denoting compression failure.
-template<const size_t N, const size_t sbytelen>
+// Each coefficient is encoded as sign bit, low 7 -bits and high bits in unary,
+// which is emitted as a single ( 9 + k ) -bit code, into a 64 -bit accumulator,
+// writing whole bytes straight into signature. Length of code is known before
+// it's emitted, so that compression gives up, as soon as signature would go
+// over (sbytelen * 8 - 328) -bits, never writing past end of signature.
+template<const size_t N, const size_t sbytelen, typename F>
 static inline bool
-compress_sig(const int32_t* const __restrict poly_s,
-             uint8_t* const __restrict sig)
+compress_coeffs(F&& coeff, uint8_t* const __restrict sig)
   requires(((N == 512) && (sbytelen == 666)) ||
            ((N == 1024) && (sbytelen == 1280)))
 {
   constexpr size_t slen = 8 * sbytelen - (8 + 320); // signature bit length
-  constexpr size_t max_sbytelen = (std::bit_width(ff::Q) * N) / 8;
+  constexpr size_t olen = sbytelen - (1 + 40);      // signature byte length
 
-  uint8_t sig_buf[max_sbytelen]{};
+  uint8_t* const out = sig + (1 + 40);
 
+  uint64_t acc = 0;
+  size_t acc_len = 0;
+  size_t off = 0;
   size_t bit_idx = 0;
-  size_t coeff_idx = 0;
 
-  while (coeff_idx < N) {
-    // encode sign bit
-    {
-      const size_t byte_idx = bit_idx >> 3;
-      const size_t from_bit = bit_idx & 7ul;
+  for (size_t i = 0; i < N; i++) {
+    const int32_t c = coeff(i);
+    const uint32_t a = static_cast<uint32_t>(std::abs(c));
+    const size_t k = a >> 7;
+    const size_t len = 9 + k;
 
-      sig_buf[byte_idx] |= ((poly_s[coeff_idx] < 0) * 1) << (7 - from_bit);
-      bit_idx += 1;
+    if (bit_idx + len >= slen) [[unlikely]] {
+      std::memset(out, 0, olen);
+      return false;
     }
+    bit_idx += len;
 
-    // encode low 7 -bits of coefficient
-    {
-      const int32_t coeff = std::abs(poly_s[coeff_idx]);
-      for (size_t i = bit_idx; i < bit_idx + 7; i++) {
-        const size_t byte_idx = i >> 3;
-        const size_t from_bit = i & 7ul;
-
-        const uint8_t bit = (coeff >> (6 - (i - bit_idx))) & 0b1;
-        sig_buf[byte_idx] |= bit << (7 - from_bit);
-      }
+    // sign bit and low 7 -bits of coefficient
+    const uint32_t lo = (static_cast<uint32_t>(c < 0) << 7) | (a & 0x7fu);
 
-      bit_idx += 7;
-    }
+    if (k < 24) [[likely]] {
+      // sign, low bits, k zeros and terminating one, in one go
+      put_bits(out, off, acc, acc_len, ((lo << k) << 1) | 1u, len);
+    } else {
+      put_bits(out, off, acc, acc_len, lo, 8);
 
-    // encode high bits of coefficient, in unary code
-    {
-      const size_t k = std::abs(poly_s[coeff_idx]) >> 7;
-      for (size_t i = bit_idx; i < bit_idx + k; i++) {
-        const size_t byte_idx = i >> 3;
-        const size_t from_bit = i & 7ul;
-
-        sig_buf[byte_idx] |= 0 << (7 - from_bit);
+      size_t zeros = k;
+      while (zeros >= 31) {
+        put_bits(out, off, acc, acc_len, 0u, 31);
+        zeros -= 31;
       }
-
-      bit_idx += k;
-      sig_buf[bit_idx >> 3] |= 1 << (7 - (bit_idx & 7ul));
-      bit_idx += 1;
+      put_bits(out, off, acc, acc_len, 1u, zeros + 1);
     }
+  }
 
-    coeff_idx += 1;
+  // flush pending bits, padding last byte with zero bits
+  while (acc_len >= 8) {
+    acc_len -= 8;
+    out[off++] = static_cast<uint8_t>(acc >> acc_len);
   }
+  if (acc_len > 0) {
+    out[off++] = static_cast<uint8_t>(acc << (8 - acc_len));
+  }
+
+  std::memset(out + off, 0, olen - off);
+  return true;
+}
 
-  std::memset(sig_buf, 0, max_sbytelen * (bit_idx >= slen));
-  std::memcpy(sig + (1 + 40), sig_buf, sbytelen - (1 + 40));
+// Given a degree N polynomials with coefficients ∈ Z[x] s.t. they are
+// distributed around 0 according to a discrete Gaussian distribution, this
+// routine attempts to compress it using (sbytelen * 8 - 328) -bits, following
+// algorithm 17 of Falcon specification https://falcon-sign.info/falcon.pdf
+//
+// Layout of sig = <8 -bits of header> +
+//                 <320 -bits of salt> +
+//                 <{666, 1280} - 41 -bytes of compressed signature>
+//
+// This routine doesn't access first 41 -bytes of signature, setting those bytes
+// properly is not responsibility of this routine.
+//
+// In case of successful compression, returns boolean truth value, otherwise
+// returns false, denoting compression failure, in which case compressed
+// signature bytes are zeroed.
+template<const size_t N, const size_t sbytelen>
+static inline bool
+compress_sig(const int32_t* const __restrict poly_s,
+             uint8_t* const __restrict sig)
+  requires(((N == 512) && (sbytelen == 666)) ||
+           ((N == 1024) && (sbytelen == 1280)))
+{
+  return compress_coeffs<N, sbytelen>(
+    [&](const size_t i) { return poly_s[i]; }, sig);
+}
 
-  return bit_idx < slen;
+// Same as above, but takes polynomial with real coefficients ( i.e. after
+// inverse FFT ), rounding each of them to nearest integer, while it's being
+// compressed, instead of in a separate pass. Rounded coefficients are also
+// written to `poly_r`, though on compression failure, only a prefix of it may
+// have been written.
+template<const size_t N, const size_t sbytelen, fft::complex_number C>
+static inline bool
+compress_sig(const C* const __restrict poly_s,
+             uint8_t* const __restrict sig,
+             int32_t* const __restrict poly_r)
+  requires(((N == 512) && (sbytelen == 666)) ||
+           ((N == 1024) && (sbytelen == 1280)))
+{
+  using std::round;
+
+  return compress_coeffs<N, sbytelen>(
+    [&](const size_t i) {
+      const int32_t c = static_cast<int32_t>(round(poly_s[i].real()));
+      poly_r[i] = c;
+      return c;
+    },
+    sig);
 }
 
 }
@@ -0,0 +1,139 @@
+#pragma once
+#include "forking.hpp"
+#include "prng.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Asynchronous entropy pipeline, which squeezes sampler randomness ahead of
+// time, off the signing thread
+namespace entropy {
+
+// Entropy producer, which keeps one ring buffer per signer ( see
+// `spsc_ring::ring_t` ) topped up with output of a PRNG, of its own, so that
+// Keccak work, which `ff_sampling`/ `samplerz` otherwise do inline, moves off
+// latency critical signing path. i-th signer attaches i-th ring to its PRNG (
+// see `prng::prng_t::attach` ), after which it reads bytes out of ring, falling
+// back to inline generation, whenever ring runs dry.
+//
+// Rings can be refilled either by a background thread ( see `start` ) or by
+// caller, during idle time ( see `refill` ), but not both at once, as each ring
+// has a single producer. Each ring is fed by a separately seeded PRNG, so that
+// no two signers ever consume same bytes.
+//
+// Producer is inert in a child process, forked after it was created, as its
+// rings and PRNGs are duplicates of parent's : rings hand out no bytes ( see
+// `spsc_ring::ring_t` ), refilling produces none and background thread can't
+// be started. Child, which wants to offload sampler randomness, must create a
+// producer of its own.
+class producer_t
+{
+private:
+  const uint64_t epoch = forking::epoch();
+  std::vector<std::unique_ptr<spsc_ring::ring_t>> rings;
+  std::vector<prng::prng_t> rngs;
+
+  std::atomic<bool> stopping{ false };
+  std::thread worker;
+
+public:
+  // How long background thread sleeps, when all rings are found full.
+  static constexpr std::chrono::microseconds IDLE{ 50 };
+
+  // Allocates `signers` -many rings, each of `capacity` -bytes ( rounded up to
+  // next power of 2 ), which are empty, till first refill. A signature takes
+  // ~20kB ( Falcon512 ) or ~40kB ( Falcon1024 ) of randomness, so that default
+  // capacity buffers a burst of 6 or 3 signatures.
+  explicit inline producer_t(const size_t signers,
+                             const size_t capacity = 1ul << 17)
+    : rngs(signers)
+  {
+    rings.reserve(signers);
+    for (size_t i = 0; i < signers; i++) {
+      rings.push_back(std::make_unique<spsc_ring::ring_t>(capacity));
+    }
+  }
+
+  producer_t(const producer_t&) = delete;
+  producer_t& operator=(const producer_t&) = delete;
+
+  // Stops background thread, if running. Signers must have detached their
+  // rings, before producer is destroyed.
+  inline ~producer_t() { stop(); }
+
+  // Number of rings, one per signer.
+  inline size_t size() const { return rings.size(); }
+
+  // Ring of i-th signer.
+  inline spsc_ring::ring_t& ring(const size_t i) { return *rings[i]; }
+
+  // Tops up all rings, one after another, returning how many bytes were
+  // produced, which is 0, when all of them were already full. Must not be
+  // called while background thread is running.
+  inline size_t refill()
+  {
+    size_t produced = 0;
+
+    for (size_t i = 0; i < rings.size(); i++) {
+      prng::prng_t& rng = rngs[i];
+
+      produced += rings[i]->fill(
+        [&](uint8_t* const bytes, const size_t len) { rng.read(bytes, len); });
+    }
+
+    return produced;
+  }
+
+  // Spawns background thread, which keeps refilling rings, as signers drain
+  // them, till `stop` is called. Returns false, if it's already running or in
+  // a forked child process.
+  inline bool start()
+  {
+    if (worker.joinable() || forked()) {
+      return false;
+    }
+
+    stopping.store(false, std::memory_order_relaxed);
+    worker = std::thread([this] {
+      while (!stopping.load(std::memory_order_relaxed)) {
+        if (refill() == 0) {
+          std::this_thread::sleep_for(IDLE);
+        }
+      }
+    });
+
+    return true;
+  }
+
+  // Stops background thread, if running, and waits for it to exit. In a forked
+  // child process, it only forgets thread, which parent started.
+  inline void stop()
+  {
+    stopping.store(true, std::memory_order_relaxed);
+    if (!worker.joinable()) {
+      return;
+    }
+
+    if (forked()) [[unlikely]] {
+      // thread was started by parent and doesn't exist in child, so that it
+      // can neither be joined nor detached, its handle is leaked instead
+      static_cast<void>(new std::thread(std::move(worker)));
+      return;
+    }
+
+    worker.join();
+  }
+
+  // Whether calling process was forked after producer was created.
+  inline bool forked() const
+  {
+    return forking::count.load(std::memory_order_relaxed) != epoch;
+  }
+};
+
+}
@@ -6,8 +6,12 @@
 #include "fft.hpp"
 #include "keygen.hpp"
 #include "prng.hpp"
+#include "scratch.hpp"
 #include "signing.hpp"
 #include "verification.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
 
 // Falcon{512, 1024} Key Generation, Signing and Verification Algorithm
@@ -25,6 +29,9 @@ namespace falcon {
 // keygen.hpp file's keygen() function implementation - that is an
 // implementation of algorithm 4 of Falcon specification, which does no byte
 // serialization for secret key or public key.
+//
+// Randomness is sampled from PRNG local to calling thread, see
+// `prng::thread_prng`.
 template<const size_t N>
 static inline void
 keygen(uint8_t* const __restrict pkey, uint8_t* const __restrict skey)
@@ -35,7 +42,7 @@ keygen(uint8_t* const __restrict pkey, uint8_t* const __restrict skey)
   int32_t F[N];
   int32_t G[N];
   ff::ff_t h[N];
-  prng::prng_t rng;
+  prng::prng_t& rng = prng::thread_prng();
 
   ntru_gen::ntru_gen<N>(f, g, F, G, rng);
   keygen::compute_public_key<N>(f, g, h);
@@ -50,22 +57,122 @@ keygen(uint8_t* const __restrict pkey, uint8_t* const __restrict skey)
 // byte encapsulated value of polynomials f, g and F ) and G needs to be
 // computed again because all of four polynomials f, g, F and G are required for
 // computing Falcon Tree T, which is used for signing messages.
+//
+// As fG = q + gF holds exactly over Z[x]/(φ), reducing it mod q gives G = gF/f
+// ( mod q ), which is computed using NTT over Z_q, while each coefficient of G
+// is recovered by lifting it to (-q/2, q/2], which is exact because
+// coefficients of G are much smaller than q/2, for any valid secret key. This
+// requires f to be invertible mod q, which is ensured by key generation.
+// Compared to `recompute_G_fft`, no rounding of floating point values is
+// involved and it's ~2x faster.
+//
+// Returns false, if f is not invertible mod q ( i.e. some coefficient of f, in
+// NTT form, is zero ) or some coefficient of recomputed G doesn't fit in 8
+// -bits, as it does for a valid secret key ( see `encoding::encode_skey` ), in
+// which case G must not be used. Both are possible only for a tampered or
+// corrupted secret key, which still decodes.
+//
+// Workspace `ws` must be able to hold 3 * N elements of Z_q.
 template<const size_t N>
-static inline void
+static inline bool
+recompute_G(const int32_t* const __restrict f,
+            const int32_t* const __restrict g,
+            const int32_t* const __restrict F,
+            int32_t* const __restrict G,
+            ff::ff_t* const __restrict ws)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr int32_t q = ff::Q;
+  constexpr uint16_t qby2 = ff::Q / 2;
+  constexpr int32_t G_max = 127;
+
+  ff::ff_t* const f_ = ws;
+  ff::ff_t* const g_ = ws + N;
+  ff::ff_t* const F_ = ws + 2 * N;
+
+  for (size_t i = 0; i < N; i++) {
+    f_[i].v = static_cast<uint16_t>((f[i] < 0) * q + f[i]);
+    g_[i].v = static_cast<uint16_t>((g[i] < 0) * q + g[i]);
+    F_[i].v = static_cast<uint16_t>((F[i] < 0) * q + F[i]);
+  }
+
+  ntt::ntt<log2<N>()>(f_);
+  ntt::ntt<log2<N>()>(g_);
+  ntt::ntt<log2<N>()>(F_);
+
+  // F_ <- gF ( mod q ) [NTT]
+  for (size_t i = 0; i < N; i++) {
+    F_[i] = g_[i] * F_[i];
+  }
+
+  // F_ <- F_ / f ( mod q ) [NTT], inverting all coefficients of f together,
+  // using a single field inversion ( Montgomery's trick ), with g_ reused for
+  // holding prefix products of f
+  g_[0] = f_[0];
+  for (size_t i = 1; i < N; i++) {
+    g_[i] = g_[i - 1] * f_[i];
+  }
+
+  // product of all coefficients is zero iff some coefficient is zero
+  bool ok = g_[N - 1].v != 0;
+
+  ff::ff_t acc = g_[N - 1].inv();
+  for (size_t i = N - 1; i > 0; i--) {
+    F_[i] = F_[i] * (acc * g_[i - 1]);
+    acc = acc * f_[i];
+  }
+  F_[0] = F_[0] * acc;
+
+  ntt::intt<log2<N>()>(F_);
+
+  for (size_t i = 0; i < N; i++) {
+    const bool flg = F_[i].v > qby2;
+    G[i] = static_cast<int32_t>(F_[i].v) - flg * q;
+
+    ok &= (G[i] >= -G_max) & (G[i] <= G_max);
+  }
+
+  return ok;
+}
+
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N>
+static inline bool
 recompute_G(const int32_t* const __restrict f,
             const int32_t* const __restrict g,
             const int32_t* const __restrict F,
             int32_t* const __restrict G)
   requires((N == 512) || (N == 1024))
+{
+  ff::ff_t ws[3 * N];
+  return recompute_G<N>(f, g, F, G, ws);
+}
+
+// Given three degree N polynomials f, g and F, this routine recomputes G using
+// NTRU equation fG - gF = q mod φ, over C, by computing G = (q + gF) / f in FFT
+// form and rounding its coefficients.
+//
+// This routine is kept around as reference, for cross-checking `recompute_G`,
+// which is exact and cheaper.
+//
+// Workspace `ws` must be able to hold 6 * N complex numbers.
+template<const size_t N>
+static inline void
+recompute_G_fft(const int32_t* const __restrict f,
+            const int32_t* const __restrict g,
+            const int32_t* const __restrict F,
+            int32_t* const __restrict G,
+            fft::cmplx* const __restrict ws)
+  requires((N == 512) || (N == 1024))
 {
   constexpr double Q = ff::Q;
 
-  fft::cmplx f_[N];
-  fft::cmplx g_[N];
-  fft::cmplx F_[N];
-  fft::cmplx G_[N];
-  fft::cmplx q[N];
-  fft::cmplx tmp[N];
+  fft::cmplx* const f_ = ws;
+  fft::cmplx* const g_ = ws + N;
+  fft::cmplx* const F_ = ws + 2 * N;
+  fft::cmplx* const G_ = ws + 3 * N;
+  fft::cmplx* const q = ws + 4 * N;
+  fft::cmplx* const tmp = ws + 5 * N;
 
   for (size_t i = 0; i < N; i++) {
     f_[i] = fft::cmplx{ static_cast<double>(f[i]) };
@@ -89,22 +196,37 @@ recompute_G(const int32_t* const __restrict f,
   }
 }
 
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N>
+static inline void
+recompute_G_fft(const int32_t* const __restrict f,
+            const int32_t* const __restrict g,
+            const int32_t* const __restrict F,
+            int32_t* const __restrict G)
+  requires((N == 512) || (N == 1024))
+{
+  fft::cmplx ws[6 * N];
+  recompute_G_fft<N>(f, g, F, G, ws);
+}
+
 // Given four degree N polynomials f, g, F and G, in coefficient form, this
 // routine computes a 2x2 matrix B, in its FFT form s.t. B = [[g, -f], [G, -F]]
-template<const size_t N>
+template<const size_t N, fft::complex_number C>
 static inline void
 compute_matrix_B(const int32_t* const __restrict f,
                  const int32_t* const __restrict g,
                  const int32_t* const __restrict F,
                  const int32_t* const __restrict G,
-                 fft::cmplx* const __restrict B)
+                 C* const __restrict B)
   requires((N == 512) || (N == 1024))
 {
+  using R = fft::real_t<C>;
+
   for (size_t i = 0; i < N; i++) {
-    B[i] = fft::cmplx{ static_cast<double>(g[i]) };
-    B[N + i] = fft::cmplx{ -static_cast<double>(f[i]) };
-    B[2 * N + i] = fft::cmplx{ static_cast<double>(G[i]) };
-    B[3 * N + i] = fft::cmplx{ -static_cast<double>(F[i]) };
+    B[i] = C{ R(g[i]) };
+    B[N + i] = C{ -R(f[i]) };
+    B[2 * N + i] = C{ R(G[i]) };
+    B[3 * N + i] = C{ -R(F[i]) };
   }
 
   fft::fft<log2<N>()>(B);
@@ -113,15 +235,38 @@ compute_matrix_B(const int32_t* const __restrict f,
   fft::fft<log2<N>()>(B + 3 * N);
 }
 
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `compute_falcon_tree`, which keeps Gram matrix of B, while
+// rest of it is reused by computation of Gram matrix and LDL tree.
+template<const size_t N>
+static inline constexpr size_t
+falcon_tree_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<fft::cmplx>(2 * 2 * N) +
+         std::max(keygen::gram_matrix_scratch_bytes<N>(),
+                  falcon_tree::ffldl_scratch_bytes<N>());
+}
+
 // Given a 2x2 matrix B ( in its FFT format ) s.t. B = [[g, -f], [G, -F]], this
 // routine computes a falcon tree T, in its FFT format s.t. it takes (k+1) * 2^k
 // -many complex numbers to store the full falcon tree when tree height is k =
 // log2(N)
-template<const size_t N>
+//
+// Falcon tree T is laid out following memory layout L, see
+// `falcon_tree::layout_t`, which must also be used when signing with it.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `falcon_tree_scratch_bytes<N>()`
+// -bytes.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline void
 compute_falcon_tree(
-  const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
-  fft::cmplx* const __restrict T        // Falcon Tree ( in FFT form )
+  const C* const __restrict B,      // 2x2 matrix [[g, -f], [G, -F]]
+  C* const __restrict T,            // Falcon Tree ( in FFT form )
+  uint8_t* const __restrict scratch // see `falcon_tree_scratch_bytes`
   )
   requires((N == 512) || (N == 1024))
 {
@@ -129,11 +274,210 @@ compute_falcon_tree(
   constexpr double σ_values[]{ 165.736617183, 168.388571447 };
   constexpr double σ = σ_values[N == 1024];
 
-  fft::cmplx gram_matrix[2 * 2 * N];
-  keygen::compute_gram_matrix<N>(B, gram_matrix);
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  C* const gram_matrix = scratch::take<C>(buf, 2 * 2 * N);
+  C* const ws = reinterpret_cast<C*>(buf);
+
+  keygen::compute_gram_matrix<N>(B, gram_matrix, ws);
+
+  falcon_tree::ffldl<N, 0, log2<N>(), L>(gram_matrix, T, ws);
+  falcon_tree::normalize_tree<N, 0, log2<N>(), L>(T, σ);
+}
+
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+compute_falcon_tree(
+  const C* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
+  C* const __restrict T        // Falcon Tree ( in FFT form )
+  )
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[falcon_tree_scratch_bytes<N>()];
+  compute_falcon_tree<N, L>(B, T, buf);
+}
+
+// Expands byte encoded secret key into 2x2 matrix B = [[g, -f], [G, -F]] and
+// Falcon tree T ( laid out following memory layout L ), both in FFT form, ready
+// for signing. Returns false if secret key can't be decoded or G can't be
+// recomputed from it ( see `recompute_G` ), in which case B and T must not be
+// used. Intermediate f, g, F, G are wiped before returning.
+//
+// B and T are made of complex numbers of type C, which decides how floating
+// point arithmetic is performed, see `fft::complex_number`. Signing must use
+// same type, i.e. emulated `fpr::cmplx_t` gives signatures which are same on
+// every target, independent of its FPU.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline bool
+expand_skey(const uint8_t* const __restrict skey,
+            C* const __restrict B, // [[g, -f], [G, -F]]
+            C* const __restrict T) // Falcon Tree
+  requires((N == 512) || (N == 1024))
+{
+  int32_t f[N];
+  int32_t g[N];
+  int32_t F[N];
+  int32_t G[N];
+
+  const bool expanded = decoding::decode_skey<N>(skey, f, g, F) &&
+                        recompute_G<N>(f, g, F, G);
+  if (expanded) [[likely]] {
+    compute_matrix_B<N>(f, g, F, G, B);
+    compute_falcon_tree<N, L>(B, T);
+  }
+
+  scratch::secure_wipe(f, sizeof(f));
+  scratch::secure_wipe(g, sizeof(g));
+  scratch::secure_wipe(F, sizeof(F));
+  scratch::secure_wipe(G, sizeof(G));
+
+  return expanded;
+}
+
+// Byte length of seed, from which a Falcon{512, 1024} keypair can be
+// deterministically regenerated, see `keygen_from_seed`.
+constexpr size_t SEED_LEN = 48;
+
+// Deterministically generates Falcon{512, 1024} keypair from 48 -bytes seed,
+// by driving NTRU equation solver with a PRNG seeded with it, so that same seed
+// always produces same keypair. This lets cold secret keys be kept around as
+// just their seed, instead of {1281, 2305} -bytes encoded secret key, while
+// secret key can be regenerated ( see `expand_seed` ), when needed.
+//
+// Seed must be sampled uniformly at random and kept as secret as secret key
+// itself. Note, regenerating a keypair costs as much as generating it afresh.
+template<const size_t N>
+static inline void
+keygen_from_seed(const uint8_t* const __restrict seed, // SEED_LEN -bytes
+                 uint8_t* const __restrict pkey,
+                 uint8_t* const __restrict skey)
+  requires((N == 512) || (N == 1024))
+{
+  int32_t f[N];
+  int32_t g[N];
+  int32_t F[N];
+  int32_t G[N];
+  ff::ff_t h[N];
+  prng::prng_t rng(seed, SEED_LEN);
+
+  ntru_gen::ntru_gen<N>(f, g, F, G, rng);
+  keygen::compute_public_key<N>(f, g, h);
+  encoding::encode_pkey<N>(h, pkey);
+  encoding::encode_skey<N>(f, g, F, skey);
+
+  scratch::secure_wipe(f, sizeof(f));
+  scratch::secure_wipe(g, sizeof(g));
+  scratch::secure_wipe(F, sizeof(F));
+  scratch::secure_wipe(G, sizeof(G));
+}
+
+// Regenerates secret key from 48 -bytes seed ( see `keygen_from_seed` ),
+// straight into its expanded form i.e. 2x2 matrix B = [[g, -f], [G, -F]] and
+// Falcon tree T ( laid out following memory layout L ), both in FFT form, ready
+// for signing, without going through byte encoded secret key. Intermediate f,
+// g, F, G are wiped before returning.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+expand_seed(const uint8_t* const __restrict seed, // SEED_LEN -bytes
+            C* const __restrict B,                // [[g, -f], [G, -F]]
+            C* const __restrict T)                // Falcon Tree
+  requires((N == 512) || (N == 1024))
+{
+  int32_t f[N];
+  int32_t g[N];
+  int32_t F[N];
+  int32_t G[N];
+  prng::prng_t rng(seed, SEED_LEN);
+
+  ntru_gen::ntru_gen<N>(f, g, F, G, rng);
+  compute_matrix_B<N>(f, g, F, G, B);
+  compute_falcon_tree<N, L>(B, T);
+
+  scratch::secure_wipe(f, sizeof(f));
+  scratch::secure_wipe(g, sizeof(g));
+  scratch::secure_wipe(F, sizeof(F));
+  scratch::secure_wipe(G, sizeof(G));
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `compute_cached_tree`, which keeps Gram matrix of B, while
+// rest of it is reused by computation of Gram matrix and top levels of LDL
+// tree. Nothing is required when CACHED = 0.
+template<const size_t N, const size_t CACHED>
+static inline constexpr size_t
+cached_tree_scratch_bytes()
+  requires(((N == 512) || (N == 1024)) && (CACHED < log2<N>()))
+{
+  if constexpr (CACHED > 0) {
+    return scratch::bytes<fft::cmplx>(2 * 2 * N) +
+           std::max(keygen::gram_matrix_scratch_bytes<N>(),
+                    falcon_tree::ffldl_cached_scratch_bytes<N, CACHED>());
+  } else {
+    return 0;
+  }
+}
+
+// Given a 2x2 matrix B ( in its FFT format ) s.t. B = [[g, -f], [G, -F]], this
+// routine computes top `CACHED` levels of falcon tree T, followed by Gram
+// matrices of nodes at level `CACHED`, requiring
+// `falcon_tree::cached_tree_len<N, CACHED>()` -many complex numbers. That's
+// what tree-less signing ( see `sign_dyn` ) expects, in place of full falcon
+// tree, s.t. lower levels are recomputed during signing.
+//
+// For Falcon1024, full falcon tree takes 11 * N complex numbers, while this
+// takes (CACHED + 2) * N of those, or nothing at all when CACHED = 0.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span
+// `cached_tree_scratch_bytes<N, CACHED>()` -bytes.
+template<const size_t N, const size_t CACHED>
+static inline void
+compute_cached_tree(
+  const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
+  fft::cmplx* const __restrict Tc,      // Top levels of Falcon Tree
+  uint8_t* const __restrict scratch     // see `cached_tree_scratch_bytes`
+  )
+  requires(((N == 512) || (N == 1024)) && (CACHED < log2<N>()))
+{
+  if constexpr (CACHED > 0) {
+    assert(scratch::is_aligned(scratch));
+
+    uint8_t* buf = scratch;
+
+    fft::cmplx* const gram_matrix = scratch::take<fft::cmplx>(buf, 2 * 2 * N);
+    fft::cmplx* const ws = reinterpret_cast<fft::cmplx*>(buf);
+
+    keygen::compute_gram_matrix<N>(B, gram_matrix, ws);
 
-  falcon_tree::ffldl<N, 0, log2<N>()>(gram_matrix, T);
-  falcon_tree::normalize_tree<N, 0, log2<N>()>(T, σ);
+    falcon_tree::ffldl_cached<N, 0, log2<N>(), CACHED>(
+      gram_matrix, Tc, Tc + CACHED * N, ws);
+  }
+}
+
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N, const size_t CACHED>
+static inline void
+compute_cached_tree(
+  const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
+  fft::cmplx* const __restrict Tc       // Top levels of Falcon Tree
+  )
+  requires(((N == 512) || (N == 1024)) && (CACHED < log2<N>()))
+{
+  if constexpr (CACHED > 0) {
+    constexpr size_t sclen = cached_tree_scratch_bytes<N, CACHED>();
+
+    alignas(scratch::ALIGNMENT) uint8_t buf[sclen];
+    compute_cached_tree<N, CACHED>(B, Tc, buf);
+  }
 }
 
 // Given a 2x2 matrix B ( in its FFT form ) s.t. B = [[g, -f], [G, -F]], falcon
@@ -152,13 +496,18 @@ compute_falcon_tree(
 // can be useful when you need to sign many messages one after another. If
 // you're interested in signing just a single message, it's better idea to use
 // sign function living just below this.
-template<const size_t N>
+//
+// Falcon tree T is expected to be laid out following memory layout L, same as
+// used when computing it, see `compute_falcon_tree`.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline void
-sign(const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
-     const fft::cmplx* const __restrict T, // Falcon Tree ( in FFT form )
-     const uint8_t* const __restrict msg,  // message to be signed
-     const size_t mlen,                    // = len(msg), in bytes
-     uint8_t* const __restrict sig,        // compressed falcon signature
+sign(const C* const __restrict B,         // 2x2 matrix [[g, -f], [G, -F]]
+     const C* const __restrict T,         // Falcon Tree ( in FFT form )
+     const uint8_t* const __restrict msg, // message to be signed
+     const size_t mlen,                   // = len(msg), in bytes
+     uint8_t* const __restrict sig,       // compressed falcon signature
      prng::prng_t& rng)
   requires((N == 512) || (N == 1024))
 {
@@ -170,9 +519,183 @@ sign(const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
   constexpr size_t slen = slen_values[N == 1024];
   constexpr double σ_min = σ_min_values[N == 1024];
 
-  signing::sign<N, β2, slen>(B, T, msg, mlen, sig, σ_min, rng);
+  signing::sign<N, β2, slen, L>(B, T, msg, mlen, sig, σ_min, rng);
+}
+
+// Same as above, but all temporaries live in caller-provided scratch buffer,
+// which must be aligned to `scratch::ALIGNMENT` and span
+// `signing::sign_scratch_bytes<N>()` -bytes. Useful when signing happens on a
+// small stack, while scratch buffers are pooled and reused across calls.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+sign(const C* const __restrict B,         // 2x2 matrix [[g, -f], [G, -F]]
+     const C* const __restrict T,         // Falcon Tree ( in FFT form )
+     const uint8_t* const __restrict msg, // message to be signed
+     const size_t mlen,                   // = len(msg), in bytes
+     uint8_t* const __restrict sig,       // compressed falcon signature
+     prng::prng_t& rng,
+     uint8_t* const __restrict scratch // see `signing::sign_scratch_bytes`
+     )
+  requires((N == 512) || (N == 1024))
+{
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr size_t slen_values[]{ 666, 1280 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+
+  constexpr int32_t β2 = β2_values[N == 1024];
+  constexpr size_t slen = slen_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  signing::sign<N, β2, slen, L>(B, T, msg, mlen, sig, σ_min, rng, scratch);
 }
 
+// Signs W ( = 4 or 8 ) messages with same secret key, in lockstep, so that
+// ffSampling walks falcon tree T once for all of them, improving throughput of
+// bulk signing, on a single core. Message msgs[w] of mlens[w] -bytes is signed
+// using PRNG rngs[w], while its compressed signature is written to sigs[w].
+//
+// Given same PRNG state, signature of each message is same as what `sign`
+// computes for it. See `signing::sign_xn` for more details.
+//
+// Scratch space is allocated on the heap, throwing `std::bad_alloc`, if that
+// fails, see variant below for avoiding allocation.
+template<const size_t N,
+         const size_t W,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+sign_xn(const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
+        const fft::cmplx* const __restrict T, // Falcon Tree ( in FFT form )
+        const uint8_t* const* const __restrict msgs, // W messages to be signed
+        const size_t* const __restrict mlens,        // = len(msgs[w]), in bytes
+        uint8_t* const* const __restrict sigs, // W compressed signatures
+        prng::prng_t* const __restrict rngs    // W independent PRNGs
+        )
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr size_t slen_values[]{ 666, 1280 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+
+  constexpr int32_t β2 = β2_values[N == 1024];
+  constexpr size_t slen = slen_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  signing::sign_xn<N, β2, slen, W, L>(B, T, msgs, mlens, sigs, σ_min, rngs);
+}
+
+// Same as above, but all temporaries live in caller-provided scratch buffer,
+// which must be aligned to `scratch::ALIGNMENT` and span
+// `signing::sign_xn_scratch_bytes<N, W>()` -bytes.
+template<const size_t N,
+         const size_t W,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+sign_xn(const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
+        const fft::cmplx* const __restrict T, // Falcon Tree ( in FFT form )
+        const uint8_t* const* const __restrict msgs, // W messages to be signed
+        const size_t* const __restrict mlens,        // = len(msgs[w]), in bytes
+        uint8_t* const* const __restrict sigs, // W compressed signatures
+        prng::prng_t* const __restrict rngs,   // W independent PRNGs
+        uint8_t* const __restrict scratch // see `signing::sign_xn_scratch_bytes`
+        )
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr size_t slen_values[]{ 666, 1280 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+
+  constexpr int32_t β2 = β2_values[N == 1024];
+  constexpr size_t slen = slen_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  signing::sign_xn<N, β2, slen, W, L>(
+    B, T, msgs, mlens, sigs, σ_min, rngs, scratch);
+}
+
+// Tree-less ( dynamic ) Falcon{512, 1024} signing algorithm, which takes 2x2
+// matrix B ( in its FFT form ) s.t. B = [[g, -f], [G, -F]] and top `CACHED`
+// levels of falcon tree ( see `compute_cached_tree` ), instead of full falcon
+// tree T, recomputing rest of the tree, during signing. Smaller value of
+// `CACHED` means less memory needs to be kept per secret key, but signing
+// becomes slower. When CACHED = 0, Tc is never accessed, so it can be nullptr.
+//
+// Given same PRNG state, this routine computes same signature as `sign` does,
+// when latter is supplied with full falcon tree.
+template<const size_t N, const size_t CACHED>
+static inline void
+sign_dyn(const fft::cmplx* const __restrict B,  // [[g, -f], [G, -F]]
+         const fft::cmplx* const __restrict Tc, // Top levels of Falcon Tree
+         const uint8_t* const __restrict msg,   // message to be signed
+         const size_t mlen,                     // = len(msg), in bytes
+         uint8_t* const __restrict sig,         // compressed falcon signature
+         prng::prng_t& rng)
+  requires(((N == 512) || (N == 1024)) && (CACHED < log2<N>()))
+{
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr size_t slen_values[]{ 666, 1280 };
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+
+  constexpr int32_t β2 = β2_values[N == 1024];
+  constexpr size_t slen = slen_values[N == 1024];
+  constexpr double σ = σ_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  signing::sign_dyn<N, β2, slen, CACHED>(B, Tc, msg, mlen, sig, σ, σ_min, rng);
+}
+
+// Tree-less ( dynamic ) Falcon{512, 1024} signing algorithm, which takes only
+// four polynomials f, g, F and G ( in coefficient form ) as secret key, which
+// is most compact form of expanded secret key, computing matrix B and whole
+// LDL tree during signing.
+template<const size_t N>
+static inline void
+sign_dyn(const int32_t* const __restrict f,
+         const int32_t* const __restrict g,
+         const int32_t* const __restrict F,
+         const int32_t* const __restrict G,
+         const uint8_t* const __restrict msg,
+         const size_t mlen,
+         uint8_t* const __restrict sig,
+         prng::prng_t& rng)
+  requires((N == 512) || (N == 1024))
+{
+  fft::cmplx B[2 * 2 * N];
+
+  compute_matrix_B<N>(f, g, F, G, B);
+  sign_dyn<N, 0>(B, nullptr, msg, mlen, sig, rng);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `sign`, which takes byte encoded secret key, keeping f, g,
+// F, G, matrix B and falcon tree T, while rest of it is reused by recomputation
+// of G, computation of falcon tree and signing.
+template<const size_t N>
+static inline constexpr size_t
+sign_skey_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+
+  constexpr size_t fgFG = 4 * scratch::bytes<int32_t>(N);
+  constexpr size_t BT = scratch::bytes<fft::cmplx>(2 * 2 * N) +
+                        scratch::bytes<fft::cmplx>(tlen);
+  constexpr size_t shared = std::max({ scratch::bytes<ff::ff_t>(3 * N),
+                                       falcon_tree_scratch_bytes<N>(),
+                                       signing::sign_scratch_bytes<N>() });
+
+  return fgFG + BT + shared;
+}
+
+// Signing routine, which when set, is invoked by `sign(skey, msg, mlen, sig)`,
+// in place of expanding secret key on every call. It's set by
+// `key_cache::enable`, see key_cache.hpp.
+template<const size_t N>
+inline std::atomic<bool (*)(const uint8_t*, const uint8_t*, size_t, uint8_t*)>
+  sign_skey_hook{ nullptr };
+
 // [User Friendly API] Falcon{512, 1024} message signing algorithm, takes
 // following inputs
 //
@@ -185,34 +708,82 @@ sign(const fft::cmplx* const __restrict B, // 2x2 matrix [[g, -f], [G, -F]]
 // underlying sign helper routine for signing message. That will be desirable
 // when one signs many messages - one after another say. But for single shot
 // usecases, where secret key is loaded into memory just to sign a single
-// message, one might prefer using this routine.
+// message, one might prefer using this routine. Randomness is sampled from
+// PRNG local to calling thread, see `prng::thread_prng`. Returns false if secret
+// key can't be decoded or G can't be recomputed from it, see `recompute_G`.
+//
+// All temporaries ( including expanded secret key ) live in caller-provided
+// scratch buffer, which must be aligned to `scratch::ALIGNMENT` and span
+// `sign_skey_scratch_bytes<N>()` -bytes. It's wiped before returning.
 template<const size_t N>
 static inline bool
 sign(const uint8_t* const __restrict skey,
      const uint8_t* const __restrict msg,
      const size_t mlen,
-     uint8_t* const __restrict sig)
+     uint8_t* const __restrict sig,
+     uint8_t* const __restrict scratch // see `sign_skey_scratch_bytes`
+     )
   requires((N == 512) || (N == 1024))
 {
-  int32_t f[N];
-  int32_t g[N];
-  int32_t F[N];
-  int32_t G[N];
-  fft::cmplx B[2 * 2 * N];
-  fft::cmplx T[(1ul << log2<N>()) * (log2<N>() + 1)];
-  prng::prng_t rng;
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
 
-  const bool decoded = decoding::decode_skey<N>(skey, f, g, F);
-  if (!decoded) [[unlikely]] {
-    return decoded;
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  int32_t* const f = scratch::take<int32_t>(buf, N);
+  int32_t* const g = scratch::take<int32_t>(buf, N);
+  int32_t* const F = scratch::take<int32_t>(buf, N);
+  int32_t* const G = scratch::take<int32_t>(buf, N);
+  fft::cmplx* const B = scratch::take<fft::cmplx>(buf, 2 * 2 * N);
+  fft::cmplx* const T = scratch::take<fft::cmplx>(buf, tlen);
+
+  prng::prng_t& rng = prng::thread_prng();
+
+  // rest of the scratch buffer is reused by each of following steps
+  bool ok = decoding::decode_skey<N>(skey, f, g, F);
+  ok = ok && recompute_G<N>(f, g, F, G, reinterpret_cast<ff::ff_t*>(buf));
+
+  if (ok) [[likely]] {
+    compute_matrix_B<N>(f, g, F, G, B);
+    compute_falcon_tree<N>(B, T, buf);
+    sign<N>(B, T, msg, mlen, sig, rng, buf);
   }
 
-  recompute_G<N>(f, g, F, G);
-  compute_matrix_B<N>(f, g, F, G, B);
-  compute_falcon_tree<N>(B, T);
-  sign<N>(B, T, msg, mlen, sig, rng);
+  // expanded secret key and everything derived from it is wiped, whether
+  // signing succeeded or not
+  scratch::secure_wipe(scratch, sign_skey_scratch_bytes<N>());
+  return ok;
+}
 
-  return true;
+// Same as above, but keeps required scratch space on the stack. When caching
+// of expanded secret keys is enabled ( see `key_cache::enable` ), secret key is
+// expanded only when it's not found in cache.
+template<const size_t N>
+static inline bool
+sign(const uint8_t* const __restrict skey,
+     const uint8_t* const __restrict msg,
+     const size_t mlen,
+     uint8_t* const __restrict sig)
+  requires((N == 512) || (N == 1024))
+{
+  const auto hook = sign_skey_hook<N>.load(std::memory_order_acquire);
+  if (hook != nullptr) {
+    return hook(skey, msg, mlen, sig);
+  }
+
+  alignas(scratch::ALIGNMENT) uint8_t buf[sign_skey_scratch_bytes<N>()];
+  return sign<N>(skey, msg, mlen, sig, buf);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `verify`, which takes byte encoded public key.
+template<const size_t N>
+static inline constexpr size_t
+verify_pkey_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<ff::ff_t>(N) + verification::verify_scratch_bytes<N>();
 }
 
 // [User Friendly API] Falcon{512, 1024} signature verification algorithm takes
@@ -227,15 +798,24 @@ sign(const uint8_t* const __restrict skey,
 // better idea to keep public key loaded into memory as degree N polynomial h (
 // over Z_q | q = 12289 ) and use underlying verify routine ( which is called
 // from this function ), living in verification.hpp header file.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `verify_pkey_scratch_bytes<N>()`
+// -bytes.
 template<const size_t N>
 static inline bool
 verify(const uint8_t* const __restrict pkey,
        const uint8_t* const __restrict msg,
        const size_t mlen,
-       uint8_t* const __restrict sig)
+       uint8_t* const __restrict sig,
+       uint8_t* const __restrict scratch // see `verify_pkey_scratch_bytes`
+       )
   requires((N == 512) || (N == 1024))
 {
-  ff::ff_t h[N];
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+  ff::ff_t* const h = scratch::take<ff::ff_t>(buf, N);
 
   const size_t decoded = decoding::decode_pkey<N>(pkey, h);
   if (!decoded) [[unlikely]] {
@@ -245,7 +825,20 @@ verify(const uint8_t* const __restrict pkey,
   constexpr int32_t β2_values[]{ 34034726, 70265242 };
   constexpr int32_t β2 = β2_values[N == 1024];
 
-  return verification::verify<N, β2>(h, msg, mlen, sig);
+  return verification::verify<N, β2>(h, msg, mlen, sig, buf);
+}
+
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N>
+static inline bool
+verify(const uint8_t* const __restrict pkey,
+       const uint8_t* const __restrict msg,
+       const size_t mlen,
+       uint8_t* const __restrict sig)
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[verify_pkey_scratch_bytes<N>()];
+  return verify<N>(pkey, msg, mlen, sig, buf);
 }
 
 }
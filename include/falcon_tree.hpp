@@ -1,40 +1,186 @@
 #pragma once
+#include "codelets.hpp"
 #include "common.hpp"
 #include "polynomial.hpp"
+#include "scratch.hpp"
 #include <cmath>
 #include <cstring>
 
 // Construction of Falcon Tree from f, g, F, G ∈ Z[x]/(x^n + 1)
 namespace falcon_tree {
 
+// Memory layout of Falcon tree of height k, taking (k + 1) * 2^k complex
+// numbers, in both cases.
+enum class layout_t : uint8_t
+{
+  // Nodes of each level are placed one after another, followed by nodes of
+  // next level s.t. children of a node ( of degree N, at level i ) live 2^i * N
+  // complex numbers apart from it. This is how Falcon tree has always been laid
+  // out.
+  LEVEL_MAJOR,
+  // Nodes are placed in order ffSampling visits them i.e. each node is followed
+  // by its right subtree, which is followed by its left subtree. Each subtree
+  // is contiguous in memory, so ffSampling reads the tree as a mostly linear
+  // stream.
+  PRE_ORDER,
+};
+
+// Compile-time compute how many complex numbers are required for storing a
+// Falcon (sub)tree, rooted at a node of degree N.
+template<const size_t N>
+static inline constexpr size_t
+subtree_len()
+  requires((N >= 1) && ((N & (N - 1)) == 0))
+{
+  return N * (log2<N>() + 1);
+}
+
+// Compile-time compute offset of left child of a node of degree N, living at
+// level `AT_LEVEL` of Falcon tree, w.r.t. start of that node.
+template<const size_t N, const size_t AT_LEVEL, const layout_t L>
+static inline constexpr size_t
+left_child()
+  requires((N > 1) && ((N & (N - 1)) == 0))
+{
+  if constexpr (L == layout_t::LEVEL_MAJOR) {
+    return (1ul << AT_LEVEL) * N;
+  } else {
+    return N + subtree_len<N / 2>();
+  }
+}
+
+// Compile-time compute offset of right child of a node of degree N, living at
+// level `AT_LEVEL` of Falcon tree, w.r.t. start of that node.
+template<const size_t N, const size_t AT_LEVEL, const layout_t L>
+static inline constexpr size_t
+right_child()
+  requires((N > 1) && ((N & (N - 1)) == 0))
+{
+  if constexpr (L == layout_t::LEVEL_MAJOR) {
+    return (1ul << AT_LEVEL) * N + N / 2;
+  } else {
+    return N;
+  }
+}
+
 // Given a full-rank self-adjoint matrix G = (G_ij) ∈ FFT(Q[x]/ φ)^(2×2), this
 // routine computes LDL* decomposition of G = LDL* over FFT(Q[x]/ φ), following
 // algorithm 8 of Falcon specification https://falcon-sign.info/falcon.pdf
-template<const size_t N>
+//
+// Workspace `tmp` must have space for 2 * N complex numbers.
+template<const size_t N, fft::complex_number C>
 static inline void
-ldl(const fft::cmplx* const __restrict G,
-    fft::cmplx* const __restrict l10,
-    fft::cmplx* const __restrict d00,
-    fft::cmplx* const __restrict d11)
+ldl(const C* const __restrict G,
+    C* const __restrict l10,
+    C* const __restrict d00,
+    C* const __restrict d11,
+    C* const __restrict tmp)
   requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
 {
-  const fft::cmplx* g00 = G;
-  const fft::cmplx* g10 = G + 2 * N;
-  const fft::cmplx* g11 = G + 3 * N;
+  const C* g00 = G;
+  const C* g10 = G + 2 * N;
+  const C* g11 = G + 3 * N;
 
-  std::memcpy(d00, g00, sizeof(fft::cmplx) * N);
-  polynomial::div<log2<N>()>(g10, g00, l10);
+  C* const tmp0 = tmp;
+  C* const tmp1 = tmp + N;
 
-  fft::cmplx tmp0[N];
-  fft::cmplx tmp1[N];
+  std::memcpy(d00, g00, sizeof(C) * N);
+  polynomial::div<log2<N>()>(g10, g00, l10);
 
-  std::memcpy(tmp0, l10, sizeof(tmp0));
+  std::memcpy(tmp0, l10, sizeof(C) * N);
   fft::adj_poly<log2<N>()>(tmp0);
   polynomial::mul<log2<N>()>(l10, tmp0, tmp1);
   polynomial::mul<log2<N>()>(tmp1, g00, tmp0);
   polynomial::sub<log2<N>()>(g11, tmp0, d11);
 }
 
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N, fft::complex_number C>
+static inline void
+ldl(const C* const __restrict G,
+    C* const __restrict l10,
+    C* const __restrict d00,
+    C* const __restrict d11)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  C tmp[2 * N];
+  ldl<N>(G, l10, d00, d11, tmp);
+}
+
+// Given a diagonal element D ( of degree N, in FFT form ) of LDL*
+// decomposition, this routine splits it into d0, d1 and computes 2x2 Gram
+// matrix [[d0, d1], [d1*, d0*]] ( each element of degree N/2 ), which is used
+// for building child node of LDL tree, see line 6, 7 of algorithm 9 of Falcon
+// specification https://falcon-sign.info/falcon.pdf
+//
+// Note, as D is self-adjoint, d0* = d0, but taking adjoint keeps this routine
+// bit-compatible with how LDL tree has always been computed.
+template<const size_t N, fft::complex_number C>
+static inline void
+child_gram(const C* const __restrict D, C* const __restrict G)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  constexpr size_t hN = N / 2;
+
+  fft::split_fft<log2<N>()>(D, G, G + hN);
+  std::memcpy(G + N, G + hN, sizeof(C) * hN);
+  std::memcpy(G + N + hN, G, sizeof(C) * hN);
+  fft::adj_poly<log2<N>()>(G + N);
+}
+
+// Fused ffLDL kernel for bottom levels of the tree i.e. when N <=
+// `codelets::MAX_LDL_N`, which uses closed-form LDL* decomposition and
+// unrolled child Gram matrix computation, keeping intermediates in few local
+// variables, writing nodes following memory layout L.
+//
+// Because codelets perform same arithmetic operations, in same order, it
+// computes same tree nodes as generic recursion does.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const layout_t L,
+         fft::complex_number C>
+static inline void
+ffldl_fused(const C* const __restrict G, C* const __restrict T)
+  requires((N > 1) && (N <= codelets::MAX_LDL_N) && ((N & (N - 1)) == 0) &&
+           (AT_LEVEL < T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  constexpr size_t loff = left_child<N, AT_LEVEL, L>();
+  constexpr size_t roff = right_child<N, AT_LEVEL, L>();
+
+  C D00[N];
+  C D11[N];
+
+  codelets::ldl<log2<N>()>(G, T, D00, D11);
+
+  if constexpr (N == 2) {
+    // deepest level of recursion !
+    T[loff] = D00[0];
+    T[roff] = D11[0];
+  } else {
+    C Gc[2 * N];
+
+    codelets::child_gram<log2<N>()>(D00, Gc);
+    ffldl_fused<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(Gc, T + loff);
+
+    codelets::child_gram<log2<N>()>(D11, Gc);
+    ffldl_fused<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(Gc, T + roff);
+  }
+}
+
+// Compile-time compute how many bytes of scratch space are required by
+// workspace taking variant of `ffldl`, when it's invoked on Gram matrix of
+// degree N polynomials. Each level of recursion keeps D00, D11 and Gram matrix
+// of child node ( or workspace of `ldl` ) i.e. 4 * N complex numbers, summing
+// up to 8 * (N - 1) complex numbers.
+template<const size_t N>
+static inline constexpr size_t
+ffldl_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  return scratch::bytes<fft::cmplx>(8 * (N - 1));
+}
+
 // Given a full-rank Gram matrix G ∈ FFT(Q[x]/ (x^N + 1))^(2×2), this routine
 // computes LDL tree T ( which is a binary tree ), by recursively splitting
 // diagonal elements of D, which is obtained by repeated LDL* decomposition of
@@ -51,86 +197,231 @@ ldl(const fft::cmplx* const __restrict G,
 // has enough space for storing those many complex numbers. Also note, at
 // deepest level of recursion i.e. when N = 2, only real part of complex number
 // matters i.e. imaginary part is negligibly small.
-template<const size_t N, const size_t AT_LEVEL, const size_t T_HEIGHT>
+//
+// Tree is written following memory layout L, see `layout_t`.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const layout_t L = layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline void
-ffldl(const fft::cmplx* const __restrict G, fft::cmplx* const __restrict T)
+ffldl(const C* const __restrict G,
+      C* const __restrict T,
+      C* const __restrict ws // see `ffldl_scratch_bytes`
+      )
   requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
            (AT_LEVEL < T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
 {
-  constexpr size_t node_cnt = 1ul << AT_LEVEL;
-  constexpr size_t tree_off = node_cnt * N;
+  constexpr size_t loff = left_child<N, AT_LEVEL, L>();
+  constexpr size_t roff = right_child<N, AT_LEVEL, L>();
 
-  fft::cmplx D00[N];
-  fft::cmplx D11[N];
-
-  ldl<N>(G, T, D00, D11);
-
-  if constexpr (N == 2) {
-    // deepest level of recursion !
-    static_assert(AT_LEVEL == (T_HEIGHT - 1),
-                  "Can't go below this level of tree !");
-
-    std::memcpy(T + tree_off, D00, sizeof(D00) / 2);
-    std::memcpy(T + tree_off + (N / 2), D11, sizeof(D11) / 2);
+  if constexpr (N <= codelets::MAX_LDL_N) {
+    // bottom levels of recursion are computed by unrolled, fused kernel
+    ffldl_fused<N, AT_LEVEL, T_HEIGHT, L>(G, T);
 
     return;
   } else {
-    fft::cmplx d00[N / 2];
-    fft::cmplx d01[N / 2];
-    fft::cmplx d10[N / 2];
-    fft::cmplx d11[N / 2];
+    C* const D00 = ws;
+    C* const D11 = ws + N;
 
-    fft::split_fft<log2<N>()>(D00, d00, d01);
-    fft::split_fft<log2<N>()>(D11, d10, d11);
+    ldl<N>(G, T, D00, D11, ws + 2 * N);
 
-    fft::cmplx G0[(N / 2) * 2 * 2];
-    fft::cmplx G1[(N / 2) * 2 * 2];
+    // Gram matrix of both children take same space, one after another
+    C* const Gc = ws + 2 * N;
 
-    std::memcpy(G0, d00, sizeof(d00));
-    std::memcpy(G0 + (N / 2), d01, sizeof(d01));
-    std::memcpy(G0 + N, d01, sizeof(d01));
-    std::memcpy(G0 + N + (N / 2), d00, sizeof(d00));
-    fft::adj_poly<log2<N>()>(G0 + N);
+    child_gram<N>(D00, Gc);
+    ffldl<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(Gc, T + loff, ws + 4 * N);
 
-    std::memcpy(G1, d10, sizeof(d10));
-    std::memcpy(G1 + (N / 2), d11, sizeof(d11));
-    std::memcpy(G1 + N, d11, sizeof(d11));
-    std::memcpy(G1 + N + (N / 2), d10, sizeof(d10));
-    fft::adj_poly<log2<N>()>(G1 + N);
-
-    ffldl<N / 2, AT_LEVEL + 1, T_HEIGHT>(G0, T + tree_off);
-    ffldl<N / 2, AT_LEVEL + 1, T_HEIGHT>(G1, T + tree_off + (N / 2));
+    child_gram<N>(D11, Gc);
+    ffldl<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(Gc, T + roff, ws + 4 * N);
 
     return;
   }
 }
 
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const layout_t L = layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+ffldl(const C* const __restrict G, C* const __restrict T)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (AT_LEVEL < T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  C ws[8 * (N - 1)];
+  ffldl<N, AT_LEVEL, T_HEIGHT, L>(G, T, ws);
+}
+
 // Normalizes LDL tree's leaf nodes computing a Falcon tree, following step 6, 7
 // of algorithm 4 of Falcon specification https://falcon-sign.info/falcon.pdf
-template<const size_t N, const size_t AT_LEVEL, const size_t T_HEIGHT>
+//
+// Tree is expected to be laid out following memory layout L, see `layout_t`.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const layout_t L = layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline constexpr void
-normalize_tree(fft::cmplx* const T, const double σ)
+normalize_tree(C* const T, const fft::real_t<C> σ)
   requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
            (AT_LEVEL < T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
 {
-  constexpr size_t node_cnt = 1ul << AT_LEVEL;
-  constexpr size_t tree_off = node_cnt * N;
+  constexpr size_t loff = left_child<N, AT_LEVEL, L>();
+  constexpr size_t roff = right_child<N, AT_LEVEL, L>();
 
   if constexpr (N == 2) {
     // deepest level of recursion !
     static_assert(AT_LEVEL == (T_HEIGHT - 1),
                   "Can't go below this level of tree !");
 
-    T[tree_off] = σ / std::sqrt(T[tree_off].real());
-    T[tree_off + (N / 2)] = σ / std::sqrt(T[tree_off + (N / 2)].real());
+    using std::sqrt;
+
+    T[loff] = C{ σ / sqrt(T[loff].real()) };
+    T[roff] = C{ σ / sqrt(T[roff].real()) };
 
     return;
   } else {
-    normalize_tree<N / 2, AT_LEVEL + 1, T_HEIGHT>(T + tree_off, σ);
-    normalize_tree<N / 2, AT_LEVEL + 1, T_HEIGHT>(T + tree_off + (N / 2), σ);
+    normalize_tree<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(T + loff, σ);
+    normalize_tree<N / 2, AT_LEVEL + 1, T_HEIGHT, L>(T + roff, σ);
 
     return;
   }
 }
 
+// Given a Falcon (sub)tree, rooted at a node of degree N, living at level
+// `AT_LEVEL`, laid out following memory layout `FROM`, this routine copies it
+// to `dst`, following memory layout `TO` ( see `layout_t` ). Useful for
+// converting already computed Falcon tree, without recomputing it.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const layout_t FROM,
+         const layout_t TO>
+static inline void
+relayout_tree(const fft::cmplx* const __restrict src,
+              fft::cmplx* const __restrict dst)
+  requires((N > 0) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (AT_LEVEL <= T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  std::memcpy(dst, src, sizeof(fft::cmplx) * N);
+
+  if constexpr (N > 1) {
+    constexpr size_t nlvl = AT_LEVEL + 1;
+
+    relayout_tree<N / 2, nlvl, T_HEIGHT, FROM, TO>(
+      src + left_child<N, AT_LEVEL, FROM>(),
+      dst + left_child<N, AT_LEVEL, TO>());
+    relayout_tree<N / 2, nlvl, T_HEIGHT, FROM, TO>(
+      src + right_child<N, AT_LEVEL, FROM>(),
+      dst + right_child<N, AT_LEVEL, TO>());
+  }
+}
+
+// Compile-time compute how many complex numbers are required for storing top
+// `CACHED` levels of Falcon tree of height log2(N) ( in level-major order, as
+// `ffldl` does ), followed by Gram matrices of all nodes living at level
+// `CACHED` s.t. only g00, g10 of each 2x2 Gram matrix are kept ( because g01 =
+// g10* and g11 = g00* ), taking 2 * N complex numbers for whole level.
+//
+// Lower levels of the tree are recomputed during ffSampling, see
+// `ffsampling::ff_sampling_cached`. When CACHED = 0, nothing is stored, because
+// Gram matrix of root node can be recomputed from matrix B.
+template<const size_t N, const size_t CACHED>
+static inline constexpr size_t
+cached_tree_len()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (CACHED < log2<N>()))
+{
+  return CACHED == 0 ? 0 : (CACHED + 2) * N;
+}
+
+// Compile-time compute how many bytes of scratch space are required by
+// workspace taking variant of `ffldl_cached`, when it's invoked on Gram matrix
+// of degree N polynomials i.e. at root node. Each of top `CACHED` levels of
+// recursion keeps D00, D11 and Gram matrix of child node ( or workspace of
+// `ldl` ) i.e. 4 * N complex numbers, summing up to 8 * (N - N / 2^CACHED)
+// complex numbers.
+template<const size_t N, const size_t CACHED>
+static inline constexpr size_t
+ffldl_cached_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (CACHED < log2<N>()))
+{
+  return scratch::bytes<fft::cmplx>(8 * (N - (N >> CACHED)));
+}
+
+// Given a full-rank Gram matrix G ∈ FFT(Q[x]/ (x^N + 1))^(2×2), this routine
+// computes only top `CACHED` levels of LDL tree ( exactly same as `ffldl` does
+// ), writing them to T, while Gram matrices of nodes at level `CACHED` are
+// written to Gb s.t. g00 of all nodes are placed one after another and so are
+// g10 ( starting at offset N of Gb ), mimicking how tree levels are laid out.
+//
+// T and Gb are expected to be adjacent regions of a buffer of length
+// `cached_tree_len<N, CACHED>()`, though this routine doesn't require so.
+// Note, leaf nodes are never cached, so no normalization is required.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const size_t CACHED>
+static inline void
+ffldl_cached(const fft::cmplx* const __restrict G,
+             fft::cmplx* const __restrict T,
+             fft::cmplx* const __restrict Gb,
+             fft::cmplx* const __restrict ws // see `ffldl_cached_scratch_bytes`
+             )
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (AT_LEVEL <= CACHED) && (CACHED < T_HEIGHT) &&
+           (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  constexpr size_t node_cnt = 1ul << AT_LEVEL;
+  constexpr size_t tree_off = node_cnt * N;
+
+  if constexpr (AT_LEVEL == CACHED) {
+    // don't go any further, only keep g00, g10 of this node's Gram matrix
+    std::memcpy(Gb, G, sizeof(fft::cmplx) * N);
+    std::memcpy(Gb + tree_off, G + 2 * N, sizeof(fft::cmplx) * N);
+
+    return;
+  } else {
+    fft::cmplx* const D00 = ws;
+    fft::cmplx* const D11 = ws + N;
+
+    ldl<N>(G, T, D00, D11, ws + 2 * N);
+
+    // Gram matrix of both children take same space, one after another
+    fft::cmplx* const Gc = ws + 2 * N;
+
+    constexpr size_t nlvl = AT_LEVEL + 1;
+
+    child_gram<N>(D00, Gc);
+    ffldl_cached<N / 2, nlvl, T_HEIGHT, CACHED>(
+      Gc, T + tree_off, Gb, ws + 4 * N);
+
+    child_gram<N>(D11, Gc);
+    ffldl_cached<N / 2, nlvl, T_HEIGHT, CACHED>(
+      Gc, T + tree_off + (N / 2), Gb + (N / 2), ws + 4 * N);
+
+    return;
+  }
+}
+
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const size_t CACHED>
+static inline void
+ffldl_cached(const fft::cmplx* const __restrict G,
+             fft::cmplx* const __restrict T,
+             fft::cmplx* const __restrict Gb)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (AT_LEVEL <= CACHED) && (CACHED < T_HEIGHT) &&
+           (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  fft::cmplx ws[8 * (N - 1)];
+  ffldl_cached<N, AT_LEVEL, T_HEIGHT, CACHED>(G, T, Gb, ws);
+}
+
 }
@@ -1,8 +1,11 @@
 #pragma once
+#include "codelets.hpp"
 #include "falcon_tree.hpp"
+#include "interleaved.hpp"
 #include "polynomial.hpp"
 #include "prng.hpp"
 #include "samplerz.hpp"
+#include "scratch.hpp"
 
 // Fast Fourier Sampling
 namespace ffsampling {
@@ -14,31 +17,35 @@ namespace ffsampling {
 // https://falcon-sign.info/falcon.pdf
 //
 // For understanding ffSampling, you should read section 3.9 of specification.
-template<const size_t N, const size_t AT_LEVEL, const size_t T_HEIGHT>
+//
+// Tree is expected to be laid out following memory layout L, see
+// `falcon_tree::layout_t`.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline void
-ff_sampling(const fft::cmplx* const __restrict t0,
-            const fft::cmplx* const __restrict t1,
-            const fft::cmplx* const __restrict T,
-            const double σ_min,
-            fft::cmplx* const __restrict z0,
-            fft::cmplx* const __restrict z1,
+ff_sampling(const C* const __restrict t0,
+            const C* const __restrict t1,
+            const C* const __restrict T,
+            const fft::real_t<C> σ_min,
+            C* const __restrict z0,
+            C* const __restrict z1,
             prng::prng_t& rng)
   requires((N > 0) && ((N & (N - 1)) == 0) && (N <= 1024) &&
            (AT_LEVEL <= T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
 {
-  constexpr size_t node_cnt = 1ul << AT_LEVEL;
-  constexpr size_t tree_off = node_cnt * N;
-
   if constexpr (N == 1) {
     // deepest level of recursion !
     static_assert(AT_LEVEL == T_HEIGHT, "Can't go below leaf level of tree !");
 
-    const double σ_prime = T[0].real();
+    const auto σ_prime = T[0].real();
     const auto z0_ = samplerz::samplerz(t0[0].real(), σ_prime, σ_min, rng);
     const auto z1_ = samplerz::samplerz(t1[0].real(), σ_prime, σ_min, rng);
 
-    z0[0] = fft::cmplx{ static_cast<double>(z0_) };
-    z1[0] = fft::cmplx{ static_cast<double>(z1_) };
+    z0[0] = C{ fft::real_t<C>(z0_) };
+    z1[0] = C{ fft::real_t<C>(z1_) };
 
     return;
   } else {
@@ -48,37 +55,39 @@ ff_sampling(const fft::cmplx* const __restrict t0,
     constexpr auto nlvl = AT_LEVEL + 1; // next level of tree
 
     const auto l = T;
-    const auto Tl = T + tree_off;
-    const auto Tr = Tl + (N / 2);
+    const auto Tl = T + falcon_tree::left_child<N, AT_LEVEL, L>();
+    const auto Tr = T + falcon_tree::right_child<N, AT_LEVEL, L>();
     const auto z0l = z0;
     const auto z1l = z1;
     const auto z0r = z0l + (N / 2);
     const auto z1r = z1l + (N / 2);
 
-    fft::cmplx t1_0[N / 2];
-    fft::cmplx t1_1[N / 2];
+    C t1_0[N / 2];
+    C t1_1[N / 2];
 
     fft::split_fft<log2<N>()>(t1, t1_0, t1_1);
-    ff_sampling<nby2, nlvl, T_HEIGHT>(t1_0, t1_1, Tr, σ_min, z0r, z1r, rng);
+    ff_sampling<nby2, nlvl, T_HEIGHT, L>(
+      t1_0, t1_1, Tr, σ_min, z0r, z1r, rng);
 
-    fft::cmplx merged_z1[N];
+    C merged_z1[N];
     fft::merge_fft<log2<N>()>(z0r, z1r, merged_z1);
 
-    fft::cmplx tmp0[N];
-    fft::cmplx tmp1[N];
+    C tmp0[N];
+    C tmp1[N];
     polynomial::sub<log2<N>()>(t1, merged_z1, tmp0);
     polynomial::mul<log2<N>()>(tmp0, l, tmp1);
     polynomial::add<log2<N>()>(t0, tmp1, tmp0);
 
     // t0' = tmp0
 
-    fft::cmplx t0_0[N / 2];
-    fft::cmplx t0_1[N / 2];
+    C t0_0[N / 2];
+    C t0_1[N / 2];
 
     fft::split_fft<log2<N>()>(tmp0, t0_0, t0_1);
-    ff_sampling<nby2, nlvl, T_HEIGHT>(t0_0, t0_1, Tl, σ_min, z0l, z1l, rng);
+    ff_sampling<nby2, nlvl, T_HEIGHT, L>(
+      t0_0, t0_1, Tl, σ_min, z0l, z1l, rng);
 
-    fft::cmplx merged_z0[N];
+    C merged_z0[N];
     fft::merge_fft<log2<N>()>(z0l, z1l, merged_z0);
 
     std::memcpy(z0, merged_z0, sizeof(merged_z0));
@@ -88,4 +97,447 @@ ff_sampling(const fft::cmplx* const __restrict t0,
   }
 }
 
+// Fused ffSampling kernel for bottom levels of the Falcon tree i.e. when N <=
+// `codelets::MAX_N`, which splits, samples and merges using fully unrolled
+// codelets, keeping all intermediate polynomials in few local variables. After
+// inlining, whole subtree is sampled by straight-line code.
+//
+// Given same PRNG state, this routine samples same integer polynomials z0, z1
+// as `ff_sampling` does, because codelets perform same arithmetic operations,
+// in same order.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const falcon_tree::layout_t L,
+         fft::complex_number C>
+static inline void
+ff_sampling_fused(const C* const __restrict t0,
+                  const C* const __restrict t1,
+                  const C* const __restrict T,
+                  const fft::real_t<C> σ_min,
+                  C* const __restrict z0,
+                  C* const __restrict z1,
+                  prng::prng_t& rng)
+  requires((N > 0) && (N <= codelets::MAX_N) && ((N & (N - 1)) == 0) &&
+           (AT_LEVEL <= T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  if constexpr (N == 1) {
+    // deepest level of recursion !
+    const auto σ_prime = T[0].real();
+    const auto z0_ = samplerz::samplerz(t0[0].real(), σ_prime, σ_min, rng);
+    const auto z1_ = samplerz::samplerz(t1[0].real(), σ_prime, σ_min, rng);
+
+    z0[0] = C{ fft::real_t<C>(z0_) };
+    z1[0] = C{ fft::real_t<C>(z1_) };
+  } else {
+    constexpr auto nby2 = N / 2;
+    constexpr auto nlvl = AT_LEVEL + 1; // next level of tree
+
+    const auto l = T;
+    const auto Tl = T + falcon_tree::left_child<N, AT_LEVEL, L>();
+    const auto Tr = T + falcon_tree::right_child<N, AT_LEVEL, L>();
+
+    C t[N];
+    C z[N];
+    C t0_[N];
+
+    // right subtree
+    codelets::split_fft<log2<N>()>(t1, t, t + nby2);
+    ff_sampling_fused<nby2, nlvl, T_HEIGHT, L>(
+      t, t + nby2, Tr, σ_min, z, z + nby2, rng);
+    codelets::merge_fft<log2<N>()>(z, z + nby2, z1);
+
+    // t0' = t0 + (t1 - z1) * l
+    codelets::sub_mul_add<log2<N>()>(t0, t1, z1, l, t0_);
+
+    // left subtree
+    codelets::split_fft<log2<N>()>(t0_, t, t + nby2);
+    ff_sampling_fused<nby2, nlvl, T_HEIGHT, L>(
+      t, t + nby2, Tl, σ_min, z, z + nby2, rng);
+    codelets::merge_fft<log2<N>()>(z, z + nby2, z0);
+  }
+}
+
+// Compile-time compute how many bytes of scratch space are required as
+// workspace of `ff_sampling_inplace`, when sampling degree N polynomials.
+template<const size_t N>
+static inline constexpr size_t
+ff_sampling_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  return scratch::bytes<fft::cmplx>(2 * N);
+}
+
+// In-place variant of above ffSampling routine, following `ffSampling_fft` of
+// Falcon reference implementation, which keeps no per-level temporaries on the
+// stack. Split halves of t1 ( and later of t0' ) are placed in z1 ( and z0 ),
+// while child outputs and intermediate products live in caller-provided
+// workspace `tmp`, which must be able to hold at least 2 * N complex numbers.
+//
+// Given same PRNG state, this routine samples exactly same integer polynomials
+// z0, z1 as `ff_sampling`, because it performs same arithmetic operations, in
+// same order. Note, none of t0, t1, z0, z1 and tmp are allowed to overlap.
+// Subtrees rooted at nodes of degree <= `codelets::MAX_N` are sampled using
+// `ff_sampling_fused`.
+//
+// Tree is expected to be laid out following memory layout L, see
+// `falcon_tree::layout_t`. With pre-order layout, left subtree immediately
+// follows right subtree, so the only backward jump is in reading l of this node
+// after right subtree is sampled, which is why it's prefetched while sampled z1
+// is being merged.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+ff_sampling_inplace(const C* const __restrict t0,
+                    const C* const __restrict t1,
+                    const C* const __restrict T,
+                    const fft::real_t<C> σ_min,
+                    C* const __restrict z0,
+                    C* const __restrict z1,
+                    C* const __restrict tmp,
+                    prng::prng_t& rng)
+  requires((N > 0) && ((N & (N - 1)) == 0) && (N <= 1024) &&
+           (AT_LEVEL <= T_HEIGHT) && (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  if constexpr (N == 1) {
+    // deepest level of recursion !
+    static_assert(AT_LEVEL == T_HEIGHT, "Can't go below leaf level of tree !");
+
+    const auto σ_prime = T[0].real();
+    const auto z0_ = samplerz::samplerz(t0[0].real(), σ_prime, σ_min, rng);
+    const auto z1_ = samplerz::samplerz(t1[0].real(), σ_prime, σ_min, rng);
+
+    z0[0] = C{ fft::real_t<C>(z0_) };
+    z1[0] = C{ fft::real_t<C>(z1_) };
+
+    return;
+  } else if constexpr (N <= codelets::MAX_N) {
+    // bottom levels of recursion are sampled by unrolled, fused kernel
+    ff_sampling_fused<N, AT_LEVEL, T_HEIGHT, L>(t0, t1, T, σ_min, z0, z1, rng);
+
+    return;
+  } else {
+    static_assert(AT_LEVEL < T_HEIGHT, "Can go to leaf level !");
+
+    constexpr auto nby2 = N / 2;
+    constexpr auto nlvl = AT_LEVEL + 1; // next level of tree
+
+    const auto l = T;
+    const auto Tl = T + falcon_tree::left_child<N, AT_LEVEL, L>();
+    const auto Tr = T + falcon_tree::right_child<N, AT_LEVEL, L>();
+
+    // right subtree : z1 holds split t1, sampled halves are put in tmp
+    fft::split_fft<log2<N>()>(t1, z1, z1 + nby2);
+    ff_sampling_inplace<nby2, nlvl, T_HEIGHT, L>(
+      z1, z1 + nby2, Tr, σ_min, tmp, tmp + nby2, tmp + N, rng);
+
+    if constexpr (L == falcon_tree::layout_t::PRE_ORDER) {
+      __builtin_prefetch(l);
+    }
+
+    fft::merge_fft<log2<N>()>(tmp, tmp + nby2, z1);
+
+    // t0' = t0 + (t1 - z1) * l, computed in tmp
+    polynomial::sub<log2<N>()>(t1, z1, tmp);
+    polynomial::mul<log2<N>()>(tmp, l, tmp + N);
+    polynomial::add<log2<N>()>(t0, tmp + N, tmp);
+
+    // left subtree : z0 holds split t0', sampled halves are put in tmp
+    fft::split_fft<log2<N>()>(tmp, z0, z0 + nby2);
+    ff_sampling_inplace<nby2, nlvl, T_HEIGHT, L>(
+      z0, z0 + nby2, Tl, σ_min, tmp, tmp + nby2, tmp + N, rng);
+    fft::merge_fft<log2<N>()>(tmp, tmp + nby2, z0);
+
+    return;
+  }
+}
+
+// Lane-interleaved ffSampling, which samples W pairs of polynomials (z0, z1) at
+// once, for W targets (t0, t1), all using same Falcon tree T, so that every
+// split, merge, polynomial multiplication and tree node load serves all lanes,
+// while at leaves, integers of all lanes are sampled together, see
+// `samplerz::samplerz_xn`. Polynomials t0, t1, z0, z1 are stored
+// lane-interleaved, see `interleaved::`.
+//
+// Each lane samples from its own PRNG i.e. rngs[w], while lanes not set in
+// `active` bitmask don't sample at all, leaving their PRNG untouched. Given same
+// PRNG state, each active lane samples same z0, z1 as `ff_sampling_inplace`
+// does, when invoked with that lane's target.
+//
+// Workspace `tmp` must be able to hold 2 * N * W complex numbers.
+template<const size_t N,
+         const size_t W,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+ff_sampling_xn(const fft::cmplx* const __restrict t0,
+               const fft::cmplx* const __restrict t1,
+               const fft::cmplx* const __restrict T,
+               const double σ_min,
+               fft::cmplx* const __restrict z0,
+               fft::cmplx* const __restrict z1,
+               fft::cmplx* const __restrict tmp,
+               prng::prng_t* const __restrict rngs,
+               const uint32_t active)
+  requires((N > 0) && ((N & (N - 1)) == 0) && (N <= 1024) && (W > 0) &&
+           (W <= 32) && (AT_LEVEL <= T_HEIGHT) &&
+           (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  if constexpr (N == 1) {
+    // deepest level of recursion, all lanes share same leaf !
+    const double σ_prime = T[0].real();
+
+    double μ0[W];
+    double μ1[W];
+
+    for (size_t w = 0; w < W; w++) {
+      μ0[w] = t0[w].real();
+      μ1[w] = t1[w].real();
+    }
+
+    // each lane samples z0 before z1, from its own PRNG, as in `ff_sampling`
+    int32_t z0_[W];
+    int32_t z1_[W];
+
+    samplerz::samplerz_xn<W>(μ0, σ_prime, σ_min, rngs, active, z0_);
+    samplerz::samplerz_xn<W>(μ1, σ_prime, σ_min, rngs, active, z1_);
+
+    for (size_t w = 0; w < W; w++) {
+      z0[w] = fft::cmplx{ static_cast<double>(z0_[w]) };
+      z1[w] = fft::cmplx{ static_cast<double>(z1_[w]) };
+    }
+
+    return;
+  } else {
+    constexpr auto nby2 = N / 2;
+    constexpr auto nlvl = AT_LEVEL + 1; // next level of tree
+
+    constexpr auto hoff = nby2 * W; // offset of second half of interleaved poly
+    constexpr auto foff = N * W;    // offset past an interleaved poly
+
+    const auto l = T;
+    const auto Tl = T + falcon_tree::left_child<N, AT_LEVEL, L>();
+    const auto Tr = T + falcon_tree::right_child<N, AT_LEVEL, L>();
+
+    // right subtree : z1 holds split t1, sampled halves are put in tmp
+    interleaved::split_fft<log2<N>(), W>(t1, z1, z1 + hoff);
+    ff_sampling_xn<nby2, W, nlvl, T_HEIGHT, L>(
+      z1, z1 + hoff, Tr, σ_min, tmp, tmp + hoff, tmp + foff, rngs, active);
+    interleaved::merge_fft<log2<N>(), W>(tmp, tmp + hoff, z1);
+
+    // t0' = t0 + (t1 - z1) * l, computed in tmp
+    interleaved::sub_mul_add<log2<N>(), W>(t0, t1, z1, l, tmp);
+
+    // left subtree : z0 holds split t0', sampled halves are put in tmp
+    interleaved::split_fft<log2<N>(), W>(tmp, z0, z0 + hoff);
+    ff_sampling_xn<nby2, W, nlvl, T_HEIGHT, L>(
+      z0, z0 + hoff, Tl, σ_min, tmp, tmp + hoff, tmp + foff, rngs, active);
+    interleaved::merge_fft<log2<N>(), W>(tmp, tmp + hoff, z0);
+
+    return;
+  }
+}
+
+// Compile-time compute how many bytes of scratch space are required as
+// workspace of `ff_sampling_dyn`, when sampling degree N polynomials.
+template<const size_t N>
+static inline constexpr size_t
+ff_sampling_dyn_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  return scratch::bytes<fft::cmplx>(4 * N);
+}
+
+// Tree-less variant of ffSampling, following `ffSampling_fft_dyntree` of Falcon
+// reference implementation s.t. instead of reading nodes of a precomputed
+// Falcon tree, LDL* decomposition of 2x2 Gram matrix G = [[g00, g10*], [g10,
+// g11]] of this node is computed on-the-fly, level by level, while leaves are
+// normalized using standard deviation σ ( see table 3.3 of specification ).
+//
+// Note, Gram matrix is destroyed by this routine, as its storage is reused
+// for holding decomposed form and Gram matrices of child nodes. Caller-provided
+// workspace `tmp` must be able to hold at least 4 * N complex numbers.
+//
+// Because it performs same arithmetic operations, in same order, as `ffldl`,
+// `normalize_tree` and `ff_sampling_inplace` do, given same PRNG state, this
+// routine samples same integer polynomials z0, z1 as tree-based ffSampling.
+template<const size_t N>
+static inline void
+ff_sampling_dyn(const fft::cmplx* const __restrict t0,
+                const fft::cmplx* const __restrict t1,
+                fft::cmplx* const __restrict g00,
+                fft::cmplx* const __restrict g10,
+                fft::cmplx* const __restrict g11,
+                const double σ,
+                const double σ_min,
+                fft::cmplx* const __restrict z0,
+                fft::cmplx* const __restrict z1,
+                fft::cmplx* const __restrict tmp,
+                prng::prng_t& rng)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  constexpr size_t nby2 = N / 2;
+
+  const auto l10 = tmp;
+  const auto t = tmp + N;
+
+  // LDL* decomposition, see `falcon_tree::ldl`; D00 = g00 and D11 is kept in
+  // g10, after which both g10, g11 are free to be reused
+  polynomial::div<log2<N>()>(g10, g00, l10);
+  std::memcpy(t, l10, sizeof(fft::cmplx) * N);
+  fft::adj_poly<log2<N>()>(t);
+  polynomial::mul<log2<N>()>(l10, t, g10);
+  polynomial::mul<log2<N>()>(g10, g00, t);
+  polynomial::sub<log2<N>()>(g11, t, g10);
+
+  const auto d00 = g00;
+  const auto d11 = g10;
+
+  if constexpr (N == 2) {
+    // children are leaves, normalize them, see `falcon_tree::normalize_tree`
+    const double σ_r = σ / std::sqrt(d11[0].real());
+    const double σ_l = σ / std::sqrt(d00[0].real());
+
+    fft::split_fft<log2<N>()>(t1, z1, z1 + nby2);
+    const auto z10 = samplerz::samplerz(z1[0].real(), σ_r, σ_min, rng);
+    const auto z11 = samplerz::samplerz(z1[1].real(), σ_r, σ_min, rng);
+    t[0] = fft::cmplx{ static_cast<double>(z10) };
+    t[1] = fft::cmplx{ static_cast<double>(z11) };
+    fft::merge_fft<log2<N>()>(t, t + nby2, z1);
+
+    polynomial::sub<log2<N>()>(t1, z1, t);
+    polynomial::mul<log2<N>()>(t, l10, g11);
+    polynomial::add<log2<N>()>(t0, g11, t);
+
+    fft::split_fft<log2<N>()>(t, z0, z0 + nby2);
+    const auto z00 = samplerz::samplerz(z0[0].real(), σ_l, σ_min, rng);
+    const auto z01 = samplerz::samplerz(z0[1].real(), σ_l, σ_min, rng);
+    t[0] = fft::cmplx{ static_cast<double>(z00) };
+    t[1] = fft::cmplx{ static_cast<double>(z01) };
+    fft::merge_fft<log2<N>()>(t, t + nby2, z0);
+
+    return;
+  } else {
+    const auto w = tmp + 2 * N; // workspace of child nodes
+
+    // Gram matrix of right child, from D11 : g00, g10 in g11 and g11 in g10
+    fft::split_fft<log2<N>()>(d11, g11, g11 + nby2);
+    std::memcpy(g10, g11, sizeof(fft::cmplx) * nby2);
+    fft::adj_poly<log2<nby2>()>(g11 + nby2);
+    fft::adj_poly<log2<nby2>()>(g10);
+
+    fft::split_fft<log2<N>()>(t1, z1, z1 + nby2);
+    ff_sampling_dyn<nby2>(
+      z1, z1 + nby2, g11, g11 + nby2, g10, σ, σ_min, t, t + nby2, w, rng);
+    fft::merge_fft<log2<N>()>(t, t + nby2, z1);
+
+    // t0' = t0 + (t1 - z1) * l10, computed in t
+    polynomial::sub<log2<N>()>(t1, z1, t);
+    polynomial::mul<log2<N>()>(t, l10, g11);
+    polynomial::add<log2<N>()>(t0, g11, t);
+
+    // Gram matrix of left child, from D00 : g00, g10 in g11 and g11 in g10
+    fft::split_fft<log2<N>()>(d00, g11, g11 + nby2);
+    std::memcpy(g10, g11, sizeof(fft::cmplx) * nby2);
+    fft::adj_poly<log2<nby2>()>(g11 + nby2);
+    fft::adj_poly<log2<nby2>()>(g10);
+
+    fft::split_fft<log2<N>()>(t, z0, z0 + nby2);
+    ff_sampling_dyn<nby2>(
+      z0, z0 + nby2, g11, g11 + nby2, g10, σ, σ_min, t, t + nby2, w, rng);
+    fft::merge_fft<log2<N>()>(t, t + nby2, z0);
+
+    return;
+  }
+}
+
+// Compile-time compute how many bytes of scratch space are required as
+// workspace of `ff_sampling_cached`, when sampling degree N polynomials.
+template<const size_t N>
+static inline constexpr size_t
+ff_sampling_cached_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  return scratch::bytes<fft::cmplx>(7 * N);
+}
+
+// ffSampling routine which reads top `CACHED` levels of Falcon tree from T and
+// Gram matrices of nodes living at level `CACHED` from Gb, as computed by
+// `falcon_tree::ffldl_cached`, from where on, rest of the tree is recomputed
+// on-the-fly, using `ff_sampling_dyn`. This lets one trade memory required for
+// keeping expanded secret key, for CPU time, see
+// `falcon_tree::cached_tree_len`.
+//
+// Caller-provided workspace `tmp` must be able to hold at least 7 * N complex
+// numbers. Note, CACHED must be >= 1, for CACHED = 0, Gram matrix of root node
+// should be computed from B and `ff_sampling_dyn` should be used directly.
+template<const size_t N,
+         const size_t AT_LEVEL,
+         const size_t T_HEIGHT,
+         const size_t CACHED>
+static inline void
+ff_sampling_cached(const fft::cmplx* const __restrict t0,
+                   const fft::cmplx* const __restrict t1,
+                   const fft::cmplx* const __restrict T,
+                   const fft::cmplx* const __restrict Gb,
+                   const double σ,
+                   const double σ_min,
+                   fft::cmplx* const __restrict z0,
+                   fft::cmplx* const __restrict z1,
+                   fft::cmplx* const __restrict tmp,
+                   prng::prng_t& rng)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024) && (CACHED > 0) &&
+           (AT_LEVEL <= CACHED) && (CACHED < T_HEIGHT) &&
+           (N == (1ul << (T_HEIGHT - AT_LEVEL))))
+{
+  constexpr size_t node_cnt = 1ul << AT_LEVEL;
+  constexpr size_t tree_off = node_cnt * N;
+
+  if constexpr (AT_LEVEL == CACHED) {
+    // load Gram matrix of this node, recompute rest of the subtree dynamically
+    const auto g00 = tmp;
+    const auto g10 = tmp + N;
+    const auto g11 = tmp + 2 * N;
+
+    std::memcpy(g00, Gb, sizeof(fft::cmplx) * N);
+    std::memcpy(g10, Gb + tree_off, sizeof(fft::cmplx) * N);
+    std::memcpy(g11, Gb, sizeof(fft::cmplx) * N);
+    fft::adj_poly<log2<N>()>(g11);
+
+    ff_sampling_dyn<N>(
+      t0, t1, g00, g10, g11, σ, σ_min, z0, z1, tmp + 3 * N, rng);
+
+    return;
+  } else {
+    constexpr auto nby2 = N / 2;
+    constexpr auto nlvl = AT_LEVEL + 1; // next level of tree
+
+    const auto l = T;
+    const auto Tl = T + tree_off;
+    const auto Tr = Tl + nby2;
+    const auto Gbl = Gb;
+    const auto Gbr = Gb + nby2;
+
+    fft::split_fft<log2<N>()>(t1, z1, z1 + nby2);
+    ff_sampling_cached<nby2, nlvl, T_HEIGHT, CACHED>(
+      z1, z1 + nby2, Tr, Gbr, σ, σ_min, tmp, tmp + nby2, tmp + N, rng);
+    fft::merge_fft<log2<N>()>(tmp, tmp + nby2, z1);
+
+    polynomial::sub<log2<N>()>(t1, z1, tmp);
+    polynomial::mul<log2<N>()>(tmp, l, tmp + N);
+    polynomial::add<log2<N>()>(t0, tmp + N, tmp);
+
+    fft::split_fft<log2<N>()>(tmp, z0, z0 + nby2);
+    ff_sampling_cached<nby2, nlvl, T_HEIGHT, CACHED>(
+      z0, z0 + nby2, Tl, Gbl, σ, σ_min, tmp, tmp + nby2, tmp + N, rng);
+    fft::merge_fft<log2<N>()>(tmp, tmp + nby2, z0);
+
+    return;
+  }
+}
+
 }
@@ -1,6 +1,9 @@
 #pragma once
+#include "fpr.hpp"
+#include "isa.hpp"
 #include <cmath>
 #include <complex>
+#include <concepts>
 #include <numbers>
 
 // (inverse) Fast Fourier Transform of degree-{511, 1023} polynomial f ∈
@@ -9,6 +12,50 @@ namespace fft {
 
 using cmplx = std::complex<double>;
 
+// Complex number types, which FFT and everything built on top of it ( i.e. LDL
+// tree, ffSampling and signing ) are templated over, acting as policy, which
+// decides how floating point arithmetic is performed.
+//
+// - `cmplx` uses hardware double, which is fastest.
+// - `fpr::cmplx_t` emulates double using integer arithmetic, so that results
+// are bit-identical on every target, independent of its FPU and compiler flags.
+template<typename C>
+concept complex_number =
+  std::same_as<C, cmplx> || std::same_as<C, fpr::cmplx_t>;
+
+// Real number type, complex number type C is made of.
+template<complex_number C>
+using real_t = typename C::value_type;
+
+// Both complex number types occupy same memory, so that scratch space and
+// buffers, sized for `cmplx`, can hold either of them.
+static_assert(sizeof(fpr::cmplx_t) == sizeof(cmplx));
+static_assert(alignof(fpr::cmplx_t) == alignof(cmplx));
+
+// Multiplies two complex numbers, computing ( ac - bd ) + i( ad + bc ).
+//
+// Spelled out as real arithmetic, with products behind association barriers,
+// as GCC's vectorizer otherwise lowers complex multiplication ( be it C++
+// complex one or spelled out ) to fused multiply-add/subtract, whenever target
+// has FMA, even with -ffp-contract=off, making results depend on which ISA
+// variant ( see isa.hpp ) of a kernel runs. Barriers don't keep loops from
+// being vectorized. This also avoids overflow/ NaN recovery path of C++
+// complex multiplication, which is never hit with finite operands.
+template<complex_number C>
+[[gnu::always_inline]] static inline constexpr C
+mul(const C a, const C b)
+{
+  if constexpr (std::same_as<C, cmplx>) {
+    return { __builtin_assoc_barrier(a.real() * b.real()) -
+               __builtin_assoc_barrier(a.imag() * b.imag()),
+             __builtin_assoc_barrier(a.real() * b.imag()) +
+               __builtin_assoc_barrier(a.imag() * b.real()) };
+  } else {
+    return { a.real() * b.real() - a.imag() * b.imag(),
+             a.real() * b.imag() + a.imag() * b.real() };
+  }
+}
+
 // Given a 64 -bit unsigned integer, this routine extracts specified many
 // contiguous bits from ( least significant bit ) LSB side & reverses their bit
 // order, returning bit reversed `mbw` -bit wide number
@@ -1087,31 +1134,33 @@ constexpr fft::cmplx POWERS_OF_ζ[1024]{
 //
 // Implementation inspired from
 // https://github.com/itzmeanjan/falcon/blob/4ab9f60/include/ntt.hpp#L59-L98
-template<const size_t LOG2N>
+template<const size_t LOG2N, complex_number C>
 inline void
-fft(cmplx* const __restrict vec)
+fft(C* const __restrict vec)
   requires((LOG2N > 0) && (LOG2N <= 10))
 {
-  constexpr size_t N = 1ul << LOG2N;
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
 
-  for (int64_t l = LOG2N - 1; l >= 0; l--) {
-    const size_t len = 1ul << l;
-    const size_t lenx2 = len << 1;
-    const size_t k_beg = N >> (l + 1);
+    for (int64_t l = LOG2N - 1; l >= 0; l--) {
+      const size_t len = 1ul << l;
+      const size_t lenx2 = len << 1;
+      const size_t k_beg = N >> (l + 1);
 
-    for (size_t start = 0; start < N; start += lenx2) {
-      const size_t k_now = k_beg + (start >> (l + 1));
-      // Can also be computed using computeζ<N>(bit_rev<LOG2N>(k_now))
-      const auto ζ_exp = POWERS_OF_ζ[k_now];
+      for (size_t start = 0; start < N; start += lenx2) {
+        const size_t k_now = k_beg + (start >> (l + 1));
+        // Can also be computed using computeζ<N>(bit_rev<LOG2N>(k_now))
+        const C ζ_exp{ POWERS_OF_ζ[k_now] };
 
-      for (size_t i = start; i < start + len; i++) {
-        const auto tmp = ζ_exp * vec[i + len];
+        for (size_t i = start; i < start + len; i++) {
+          const auto tmp = mul(ζ_exp, vec[i + len]);
 
-        vec[i + len] = vec[i] - tmp;
-        vec[i] = vec[i] + tmp;
+          vec[i + len] = vec[i] - tmp;
+          vec[i] = vec[i] + tmp;
+        }
       }
     }
-  }
+  });
 }
 
 // Given {512, 1024} evaluations of polynomial f ∈ Q[x]/(φ) s.t. each evaluation
@@ -1123,37 +1172,39 @@ fft(cmplx* const __restrict vec)
 //
 // Implementation inspired from
 // https://github.com/itzmeanjan/falcon/blob/4ab9f60/include/ntt.hpp#L59-L98
-template<const size_t LOG2N>
+template<const size_t LOG2N, complex_number C>
 inline void
-ifft(cmplx* const __restrict vec)
+ifft(C* const __restrict vec)
   requires((LOG2N > 0) && (LOG2N <= 10))
 {
-  constexpr size_t N = 1ul << LOG2N;
-  constexpr double INV_N = 1. / static_cast<double>(N);
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
+    constexpr real_t<C> INV_N = 1. / static_cast<double>(N);
 
-  for (size_t l = 0; l < LOG2N; l++) {
-    const size_t len = 1ul << l;
-    const size_t lenx2 = len << 1;
-    const size_t k_beg = (N >> l) - 1;
+    for (size_t l = 0; l < LOG2N; l++) {
+      const size_t len = 1ul << l;
+      const size_t lenx2 = len << 1;
+      const size_t k_beg = (N >> l) - 1;
 
-    for (size_t start = 0; start < N; start += lenx2) {
-      const size_t k_now = k_beg - (start >> (l + 1));
-      // Can also be computed using -computeζ<N>(bit_rev<LOG2N>(k_now))
-      const auto neg_ζ_exp = -POWERS_OF_ζ[k_now];
+      for (size_t start = 0; start < N; start += lenx2) {
+        const size_t k_now = k_beg - (start >> (l + 1));
+        // Can also be computed using -computeζ<N>(bit_rev<LOG2N>(k_now))
+        const C neg_ζ_exp = -C{ POWERS_OF_ζ[k_now] };
 
-      for (size_t i = start; i < start + len; i++) {
-        const auto tmp = vec[i];
+        for (size_t i = start; i < start + len; i++) {
+          const auto tmp = vec[i];
 
-        vec[i] = vec[i] + vec[i + len];
-        vec[i + len] = tmp - vec[i + len];
-        vec[i + len] = vec[i + len] * neg_ζ_exp;
+          vec[i] = vec[i] + vec[i + len];
+          vec[i + len] = tmp - vec[i + len];
+          vec[i + len] = mul(vec[i + len], neg_ζ_exp);
+        }
       }
     }
-  }
 
-  for (size_t i = 0; i < N; i++) {
-    vec[i] = vec[i] * INV_N;
-  }
+    for (size_t i = 0; i < N; i++) {
+      vec[i] = vec[i] * INV_N;
+    }
+  });
 }
 
 // Splits a polynomial f into two polynomials f0, f1 s.t. all the polynomials
@@ -1161,23 +1212,25 @@ ifft(cmplx* const __restrict vec)
 //
 // This routine is an implementation of the algorithm 1, described on page 29 of
 // Falcon specification https://falcon-sign.info/falcon.pdf
-template<const size_t LOG2N>
+template<const size_t LOG2N, complex_number C>
 inline void
-split_fft(const cmplx* const __restrict f,
-          cmplx* const __restrict f0,
-          cmplx* const __restrict f1)
+split_fft(const C* const __restrict f,
+          C* const __restrict f0,
+          C* const __restrict f1)
   requires((LOG2N > 0) && (LOG2N <= 10))
 {
-  constexpr size_t N = 1ul << LOG2N;
-  constexpr size_t hN = N >> 1;
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
+    constexpr size_t hN = N >> 1;
 
-  for (size_t i = 0; i < hN; i++) {
-    // Can also be computed using computeζ<N>(bit_rev<LOG2N>(hN + i))
-    const auto ζ_exp = POWERS_OF_ζ[hN + i];
+    for (size_t i = 0; i < hN; i++) {
+      // Can also be computed using computeζ<N>(bit_rev<LOG2N>(hN + i))
+      const C ζ_exp{ POWERS_OF_ζ[hN + i] };
 
-    f0[i] = 0.5 * (f[2 * i] + f[2 * i + 1]);
-    f1[i] = 0.5 * (f[2 * i] - f[2 * i + 1]) * std::conj(ζ_exp);
-  }
+      f0[i] = real_t<C>{ 0.5 } * (f[2 * i] + f[2 * i + 1]);
+      f1[i] = mul(real_t<C>{ 0.5 } * (f[2 * i] - f[2 * i + 1]), conj(ζ_exp));
+    }
+  });
 }
 
 // Merges two polynomials f0, f1 into a single one f s.t. all of these
@@ -1185,37 +1238,39 @@ split_fft(const cmplx* const __restrict f,
 //
 // This routine is an implementation of the algorithm 2, described on page 29 of
 // Falcon specification https://falcon-sign.info/falcon.pdf
-template<const size_t LOG2N>
+template<const size_t LOG2N, complex_number C>
 inline void
-merge_fft(const cmplx* const __restrict f0,
-          const cmplx* const __restrict f1,
-          cmplx* const __restrict f)
+merge_fft(const C* const __restrict f0,
+          const C* const __restrict f1,
+          C* const __restrict f)
   requires((LOG2N > 0) && (LOG2N <= 10))
 {
-  constexpr size_t N = 1ul << LOG2N;
-  constexpr size_t hN = N >> 1;
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
+    constexpr size_t hN = N >> 1;
 
-  for (size_t i = 0; i < hN; i++) {
-    // Can also be computed using computeζ<N>(bit_rev<LOG2N>(hN + i))
-    const auto ζ_exp = POWERS_OF_ζ[hN + i];
+    for (size_t i = 0; i < hN; i++) {
+      // Can also be computed using computeζ<N>(bit_rev<LOG2N>(hN + i))
+      const C ζ_exp{ POWERS_OF_ζ[hN + i] };
 
-    f[2 * i + 0] = f0[i] + f1[i] * ζ_exp;
-    f[2 * i + 1] = f0[i] - f1[i] * ζ_exp;
-  }
+      f[2 * i + 0] = f0[i] + mul(f1[i], ζ_exp);
+      f[2 * i + 1] = f0[i] - mul(f1[i], ζ_exp);
+    }
+  });
 }
 
 // Given a polynomial f of degree (n - 1), in its FFT representation, this
 // routine computes Hermitian Adjoint f*, following section 3.3 ( see bottom of
 // page 23 ) of the Falcon specification https://falcon-sign.info/falcon.pdf
-template<const size_t LOG2N>
+template<const size_t LOG2N, complex_number C>
 static inline void
-adj_poly(cmplx* const poly)
+adj_poly(C* const poly)
   requires((LOG2N > 0) && (LOG2N <= 10))
 {
   constexpr size_t N = 1ul << LOG2N;
 
   for (size_t i = 0; i < N; i++) {
-    poly[i] = std::conj(poly[i]);
+    poly[i] = conj(poly[i]);
   }
 }
 
@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+
+// Tracking of fork(2)s, so that state, which must not be shared by parent and
+// child process ( say PRNG state or ring of random bytes ), can tell whether it
+// was duplicated by fork
+namespace forking {
+
+// Number of fork(2)s, this process has gone through, as observed by child
+// process. Only bumped once `epoch` has been called, at least once.
+inline std::atomic<uint64_t> count{ 0 };
+
+static inline void
+on_child()
+{
+  count.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Returns current fork epoch, registering fork handler, which bumps it in child
+// process, on first call. State, which records epoch when it's created, can
+// later compare it against `count`, which is cheaper, to tell whether it now
+// lives in a forked child.
+static inline uint64_t
+epoch()
+{
+  [[maybe_unused]] static const bool registered =
+    pthread_atfork(nullptr, nullptr, on_child) == 0;
+
+  return count.load(std::memory_order_relaxed);
+}
+
+}
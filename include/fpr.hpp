@@ -0,0 +1,561 @@
+#pragma once
+#include <bit>
+#include <compare>
+#include <complex>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Emulated floating point arithmetic, using integer operations only
+namespace fpr {
+
+constexpr uint64_t SIGN = 1ul << 63;
+constexpr uint64_t MANT = (1ul << 52) - 1ul;
+constexpr uint64_t EXP = 0x7fful << 52;
+
+// IEEE-754 binary64 number, kept as its bit pattern, which is operated on using
+// 64 -bit integer arithmetic only, following `fpr` emulation of Falcon
+// reference implementation. Addition, subtraction, multiplication, division and
+// square root are correctly rounded ( to nearest, ties to even ), so results
+// are exactly what hardware double computes, with FP contraction disabled,
+// except that they don't depend on target's FPU, compiler flags or
+// floating point environment.
+//
+// Note, as Falcon never gets near them, subnormals are flushed to zero and
+// overflow results in infinity, while infinities and NaNs aren't handled as
+// operands.
+struct fpr_t
+{
+  uint64_t v = 0ul;
+
+  constexpr fpr_t() = default;
+
+  // Takes bit pattern of double as is, which is exact, so that constants can be
+  // written as double literals.
+  constexpr fpr_t(const double d)
+    : v(std::bit_cast<uint64_t>(d))
+  {
+  }
+
+  // Converts an integer, rounding it when it doesn't fit in 53 -bits.
+  template<std::integral I>
+  explicit constexpr fpr_t(const I i);
+
+  static inline constexpr fpr_t from_bits(const uint64_t v)
+  {
+    fpr_t x;
+    x.v = v;
+    return x;
+  }
+
+  explicit constexpr operator double() const
+  {
+    return std::bit_cast<double>(v);
+  }
+
+  // Converts to an integer, truncating towards zero, same as casting a double.
+  template<std::integral I>
+  explicit constexpr operator I() const;
+};
+
+// Given an unsigned integer m ∈ [2^54, 2^55), whose lowest two bits are round
+// and sticky bit, this routine rounds (-1)^s * m * 2^e to nearest binary64
+// number, with ties to even.
+static inline constexpr fpr_t
+pack(const uint64_t s, int32_t e, uint64_t m)
+{
+  const uint64_t up = (m >> 1) & (m | (m >> 2)) & 1ul;
+
+  m = (m >> 2) + up;
+  e += 2;
+
+  // rounding up carried into 54th bit
+  if (m >> 53) {
+    m >>= 1;
+    e += 1;
+  }
+
+  const int32_t E = e + 1075;
+  if (E <= 0) {
+    return fpr_t::from_bits(s << 63);
+  }
+  if (E >= 2047) {
+    return fpr_t::from_bits((s << 63) | EXP);
+  }
+
+  return fpr_t::from_bits((s << 63) | (static_cast<uint64_t>(E) << 52) |
+                          (m & MANT));
+}
+
+// Same as above, but takes any m, which is first shifted into [2^54, 2^55),
+// while bits shifted out are folded into sticky bit. Note, m must be exact (
+// i.e. without a sticky bit ), when it's below 2^54.
+static inline constexpr fpr_t
+norm_pack(const uint64_t s, int32_t e, uint64_t m)
+{
+  if (m == 0ul) {
+    return fpr_t::from_bits(s << 63);
+  }
+
+  const int32_t top = 63 - std::countl_zero(m);
+  if (top > 54) {
+    const int32_t sh = top - 54;
+    const uint64_t sticky = (m & ((1ul << sh) - 1ul)) != 0ul;
+
+    m = (m >> sh) | sticky;
+    e += sh;
+  } else {
+    m <<= (54 - top);
+    e -= (54 - top);
+  }
+
+  return pack(s, e, m);
+}
+
+// Splits x into sign, exponent and 53 -bit significand m s.t. |x| = m * 2^e,
+// where m = 0, for zero ( or subnormal, which is flushed to zero ).
+static inline constexpr void
+unpack(const fpr_t x, uint64_t& s, int32_t& e, uint64_t& m)
+{
+  const uint64_t E = (x.v >> 52) & 0x7fful;
+
+  s = x.v >> 63;
+  e = static_cast<int32_t>(E) - 1075;
+  m = (E == 0ul) ? 0ul : ((x.v & MANT) | (1ul << 52));
+}
+
+// Multiplies two 64 -bit unsigned integers, returning high and low 64 -bits of
+// 128 -bit product.
+static inline constexpr std::pair<uint64_t, uint64_t>
+mul_u64(const uint64_t a, const uint64_t b)
+{
+  constexpr uint64_t M32 = 0xfffffffful;
+
+  const uint64_t p00 = (a & M32) * (b & M32);
+  const uint64_t p01 = (a & M32) * (b >> 32);
+  const uint64_t p10 = (a >> 32) * (b & M32);
+  const uint64_t p11 = (a >> 32) * (b >> 32);
+
+  const uint64_t mid = (p00 >> 32) + (p01 & M32) + (p10 & M32);
+
+  const uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  const uint64_t lo = (mid << 32) | (p00 & M32);
+
+  return std::make_pair(hi, lo);
+}
+
+template<std::integral I>
+constexpr fpr_t::fpr_t(const I i)
+{
+  uint64_t s = 0ul;
+  uint64_t m = static_cast<uint64_t>(i);
+
+  if constexpr (std::is_signed_v<I>) {
+    s = i < 0;
+    m = s ? (0ul - m) : m;
+  }
+
+  v = norm_pack(s, 0, m).v;
+}
+
+template<std::integral I>
+constexpr fpr_t::operator I() const
+{
+  const int32_t E = static_cast<int32_t>((v >> 52) & 0x7fful);
+  if (E < 1023) {
+    return I{ 0 };
+  }
+
+  const uint64_t m = (v & MANT) | (1ul << 52);
+  const int32_t sh = E - 1075;
+  const uint64_t u = (sh >= 0) ? (sh < 12 ? (m << sh) : 0ul) : (m >> -sh);
+
+  if (v >> 63) {
+    return static_cast<I>(-static_cast<int64_t>(u));
+  }
+  return static_cast<I>(u);
+}
+
+inline constexpr fpr_t
+operator-(const fpr_t x)
+{
+  return fpr_t::from_bits(x.v ^ SIGN);
+}
+
+inline constexpr fpr_t
+operator+(fpr_t x, fpr_t y)
+{
+  // make sure that |x| >= |y|, so that y is the one to be aligned
+  if ((x.v & ~SIGN) < (y.v & ~SIGN)) {
+    std::swap(x, y);
+  }
+
+  uint64_t sx, mx, sy, my;
+  int32_t ex, ey;
+
+  unpack(x, sx, ex, mx);
+  unpack(y, sy, ey, my);
+
+  if (my == 0ul) {
+    // sum of two zeros is -0, only when both of them are -0
+    return (mx == 0ul) ? fpr_t::from_bits((sx & sy) << 63) : x;
+  }
+
+  // three extra bits i.e. guard, round and sticky bit
+  mx <<= 3;
+  my <<= 3;
+
+  const int32_t d = ex - ey;
+  if (d >= 64) {
+    my = 1ul;
+  } else if (d > 0) {
+    const uint64_t sticky = (my & ((1ul << d) - 1ul)) != 0ul;
+    my = (my >> d) | sticky;
+  }
+
+  // exact cancellation results in +0
+  const uint64_t m = (sx == sy) ? (mx + my) : (mx - my);
+  return norm_pack(m == 0ul ? 0ul : sx, ex - 3, m);
+}
+
+inline constexpr fpr_t
+operator-(const fpr_t x, const fpr_t y)
+{
+  return x + (-y);
+}
+
+inline constexpr fpr_t
+operator*(const fpr_t x, const fpr_t y)
+{
+  uint64_t sx, mx, sy, my;
+  int32_t ex, ey;
+
+  unpack(x, sx, ex, mx);
+  unpack(y, sy, ey, my);
+
+  const uint64_t s = sx ^ sy;
+  if ((mx == 0ul) || (my == 0ul)) {
+    return fpr_t::from_bits(s << 63);
+  }
+
+  // 106 -bit product, whose top 56 -bits are kept, along with a sticky bit
+  const auto [hi, lo] = mul_u64(mx, my);
+  const uint64_t sticky = (lo & ((1ul << 50) - 1ul)) != 0ul;
+  const uint64_t m = (hi << 14) | (lo >> 50) | sticky;
+
+  return norm_pack(s, ex + ey + 50, m);
+}
+
+inline constexpr fpr_t
+operator/(const fpr_t x, const fpr_t y)
+{
+  uint64_t sx, mx, sy, my;
+  int32_t ex, ey;
+
+  unpack(x, sx, ex, mx);
+  unpack(y, sy, ey, my);
+
+  const uint64_t s = sx ^ sy;
+  if (my == 0ul) {
+    return fpr_t::from_bits((s << 63) | EXP);
+  }
+  if (mx == 0ul) {
+    return fpr_t::from_bits(s << 63);
+  }
+
+  // bit-by-bit long division, computing 56 quotient bits, which are
+  // followed by a sticky bit, set when remainder is non-zero
+  uint64_t q = 0ul;
+  uint64_t r = mx;
+
+  for (size_t i = 0; i < 56; i++) {
+    const uint64_t b = r >= my;
+
+    r -= my & (0ul - b);
+    q = (q << 1) | b;
+    r <<= 1;
+  }
+  q |= r != 0ul;
+
+  return norm_pack(s, ex - ey - 55, q);
+}
+
+inline constexpr fpr_t&
+operator+=(fpr_t& x, const fpr_t y)
+{
+  return x = x + y;
+}
+
+inline constexpr fpr_t&
+operator-=(fpr_t& x, const fpr_t y)
+{
+  return x = x - y;
+}
+
+inline constexpr fpr_t&
+operator*=(fpr_t& x, const fpr_t y)
+{
+  return x = x * y;
+}
+
+inline constexpr fpr_t&
+operator/=(fpr_t& x, const fpr_t y)
+{
+  return x = x / y;
+}
+
+// Maps x to a signed integer s.t. integer ordering matches ordering of reals,
+// while +0 and -0 compare equal.
+static inline constexpr int64_t
+order_key(const fpr_t x)
+{
+  const auto mag = static_cast<int64_t>(x.v & ~SIGN);
+  return (x.v >> 63) ? -mag : mag;
+}
+
+inline constexpr bool
+operator==(const fpr_t x, const fpr_t y)
+{
+  return order_key(x) == order_key(y);
+}
+
+inline constexpr std::strong_ordering
+operator<=>(const fpr_t x, const fpr_t y)
+{
+  return order_key(x) <=> order_key(y);
+}
+
+inline constexpr fpr_t
+abs(const fpr_t x)
+{
+  return fpr_t::from_bits(x.v & ~SIGN);
+}
+
+// Square root, computed bit-by-bit, following `fpr_sqrt` of Falcon reference
+// implementation. Square root of a negative number is taken as zero.
+inline constexpr fpr_t
+sqrt(const fpr_t x)
+{
+  uint64_t s, m;
+  int32_t e;
+
+  unpack(x, s, e, m);
+  if ((m == 0ul) || (s == 1ul)) {
+    return fpr_t::from_bits(x.v & SIGN & (0ul - (m == 0ul)));
+  }
+
+  // x = m * 2^(e - 52) | m ∈ [2^52, 2^53), exponent is made even, so that
+  // m / 2^53 ∈ [1, 4) and sqrt(x) = sqrt(m / 2^53) * 2^(e / 2)
+  e += 52;
+  m <<= (e & 1) + 1;
+  e >>= 1;
+
+  uint64_t q = 0ul;
+  uint64_t acc = 0ul;
+  uint64_t r = 1ul << 53;
+
+  for (size_t i = 0; i < 54; i++) {
+    const uint64_t t = acc + r;
+    const uint64_t b = m >= t;
+
+    acc += (r << 1) & (0ul - b);
+    m -= t & (0ul - b);
+    q += r & (0ul - b);
+
+    m <<= 1;
+    r >>= 1;
+  }
+
+  // q ∈ [2^53, 2^54), followed by a sticky bit
+  q = (q << 1) | (m != 0ul);
+  return pack(0ul, e - 54, q);
+}
+
+// Largest integer not greater than x.
+inline constexpr fpr_t
+floor(const fpr_t x)
+{
+  const uint64_t E = (x.v >> 52) & 0x7fful;
+
+  if (E >= 1075ul) {
+    return x;
+  }
+  if (E < 1023ul) {
+    // |x| < 1
+    if ((E == 0ul) || ((x.v >> 63) == 0ul)) {
+      return fpr_t::from_bits(x.v & SIGN);
+    }
+    return fpr_t{ -1. };
+  }
+
+  const uint64_t mask = (1ul << (1075ul - E)) - 1ul;
+  if ((x.v & mask) == 0ul) {
+    return x;
+  }
+
+  const fpr_t t = fpr_t::from_bits(x.v & ~mask);
+  return (x.v >> 63) ? t - fpr_t{ 1. } : t;
+}
+
+// Nearest integer to x, rounding halfway cases away from zero, same as
+// std::round.
+inline constexpr fpr_t
+round(const fpr_t x)
+{
+  const uint64_t E = (x.v >> 52) & 0x7fful;
+
+  if (E >= 1075ul) {
+    return x;
+  }
+  if (E < 1022ul) {
+    return fpr_t::from_bits(x.v & SIGN);
+  }
+  if (E == 1022ul) {
+    return fpr_t::from_bits((x.v & SIGN) | fpr_t{ 1. }.v);
+  }
+
+  // adding half to magnitude carries into integral part, when fractional part
+  // is >= 1/2, even into exponent
+  const uint64_t f = 1075ul - E;
+  const uint64_t mask = (1ul << f) - 1ul;
+  const uint64_t mag = ((x.v & ~SIGN) + (1ul << (f - 1))) & ~mask;
+
+  return fpr_t::from_bits(mag | (x.v & SIGN));
+}
+
+// Complex number, made of two emulated reals, mirroring as much of interface
+// and arithmetic of std::complex<double> as Falcon uses, so that FFT, ffLDL and
+// ffSampling routines can be instantiated with it, see `fft::complex_number`.
+struct cmplx_t
+{
+  using value_type = fpr_t;
+
+  fpr_t re{};
+  fpr_t im{};
+
+  constexpr cmplx_t() = default;
+
+  constexpr cmplx_t(const fpr_t r, const fpr_t i = fpr_t{})
+    : re(r)
+    , im(i)
+  {
+  }
+
+  // Takes bit patterns of both components as is, which is exact.
+  explicit constexpr cmplx_t(const std::complex<double> c)
+    : re(c.real())
+    , im(c.imag())
+  {
+  }
+
+  constexpr fpr_t real() const { return re; }
+  constexpr fpr_t imag() const { return im; }
+};
+
+inline constexpr cmplx_t
+conj(const cmplx_t a)
+{
+  return { a.re, -a.im };
+}
+
+inline constexpr cmplx_t
+operator-(const cmplx_t a)
+{
+  return { -a.re, -a.im };
+}
+
+inline constexpr cmplx_t
+operator+(const cmplx_t a, const cmplx_t b)
+{
+  return { a.re + b.re, a.im + b.im };
+}
+
+inline constexpr cmplx_t
+operator-(const cmplx_t a, const cmplx_t b)
+{
+  return { a.re - b.re, a.im - b.im };
+}
+
+// Computes ( ac - bd ) + i( ad + bc ), same as C++ complex multiplication does,
+// with finite operands.
+inline constexpr cmplx_t
+operator*(const cmplx_t a, const cmplx_t b)
+{
+  return { a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re };
+}
+
+inline constexpr cmplx_t
+operator*(const cmplx_t a, const fpr_t b)
+{
+  return { a.re * b, a.im * b };
+}
+
+inline constexpr cmplx_t
+operator*(const fpr_t a, const cmplx_t b)
+{
+  return { a * b.re, a * b.im };
+}
+
+// Divides a + ib by c + id, using Smith's algorithm, with operations ordered
+// same as libgcc's `__divdc3`, which is what C++ complex division calls, so
+// that both compute same quotient, with finite, normal operands.
+inline constexpr cmplx_t
+operator/(const cmplx_t x, const cmplx_t y)
+{
+  constexpr fpr_t RMIN = fpr_t::from_bits(1ul << 52); // = DBL_MIN
+
+  const fpr_t a = x.re, b = x.im;
+  const fpr_t c = y.re, d = y.im;
+
+  if (abs(c) < abs(d)) {
+    const fpr_t ratio = c / d;
+    const fpr_t denom = (c * ratio) + d;
+
+    if (abs(ratio) > RMIN) {
+      return { ((a * ratio) + b) / denom, ((b * ratio) - a) / denom };
+    }
+    return { ((c * (a / d)) + b) / denom, ((c * (b / d)) - a) / denom };
+  }
+
+  const fpr_t ratio = d / c;
+  const fpr_t denom = (d * ratio) + c;
+
+  if (abs(ratio) > RMIN) {
+    return { ((b * ratio) + a) / denom, (b - (a * ratio)) / denom };
+  }
+  return { (a + (d * (b / c))) / denom, (b - (d * (a / c))) / denom };
+}
+
+inline constexpr cmplx_t
+operator/(const cmplx_t a, const fpr_t b)
+{
+  return { a.re / b, a.im / b };
+}
+
+inline constexpr cmplx_t&
+operator+=(cmplx_t& a, const cmplx_t b)
+{
+  return a = a + b;
+}
+
+inline constexpr cmplx_t&
+operator-=(cmplx_t& a, const cmplx_t b)
+{
+  return a = a - b;
+}
+
+inline constexpr cmplx_t&
+operator*=(cmplx_t& a, const cmplx_t b)
+{
+  return a = a * b;
+}
+
+inline constexpr cmplx_t&
+operator/=(cmplx_t& a, const cmplx_t b)
+{
+  return a = a / b;
+}
+
+}
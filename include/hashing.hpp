@@ -1,10 +1,50 @@
 #pragma once
 #include "ff.hpp"
+#include "keccak_xn.hpp"
 #include "shake256.hpp"
+#include "xof.hpp"
+#include <algorithm>
+#include <cstring>
 
 // Message Hashing for Falcon-{512, 1024}
 namespace hashing {
 
+// Given SHAKE256 XOF state, which has already absorbed salt and message ( in
+// order ) and has been finalized, this function computes a degree-(n-1)
+// polynomial over Z_q | q = 12289, by squeezing bytes out of keccak sponge
+// state and rejection sampling.
+//
+// Splitting it out of `hash_to_point` lets a caller absorb message in chunks (
+// see streaming.hpp ), as they become available, instead of requiring it as
+// one contiguous buffer.
+template<const size_t n>
+inline void
+squeeze_to_point(xof::shake256_t& hasher,
+                 ff::ff_t* const __restrict poly)
+  requires((n == 512) || (n == 1024))
+{
+  constexpr size_t m = 1ul << 16;
+  constexpr size_t q = ff::Q;
+  constexpr size_t k = m / q;
+  constexpr uint16_t kq = k * q;
+
+  size_t coeff_idx = 0;
+  uint8_t buf[shake256::rate >> 3];
+
+  while (coeff_idx < n) {
+    hasher.read(buf, sizeof(buf));
+
+    for (size_t off = 0; (off < sizeof(buf)) && (coeff_idx < n); off += 2) {
+      const uint16_t t = (static_cast<uint16_t>(buf[off + 0]) << 8) |
+                         (static_cast<uint16_t>(buf[off + 1]) << 0);
+      if (t < kq) {
+        poly[coeff_idx] = ff::ff_t{ t };
+        coeff_idx++;
+      }
+    }
+  }
+}
+
 // Given uniform random sampled salt bytes ( of length `slen` ) and message of
 // length `mlen` bytes, this function first absorbs salt and message ( in order
 // ) into SHAKE256 XOF state and then computes a degree-(n-1) polynomial over
@@ -21,32 +61,137 @@ hash_to_point(const uint8_t* const __restrict salt,
               const size_t mlen,
               ff::ff_t* const __restrict poly)
   requires((n == 512) || (n == 1024))
+{
+  xof::shake256_t hasher{};
+  hasher.absorb(salt, slen);
+  hasher.absorb(msg, mlen);
+  hasher.finalize();
+
+  squeeze_to_point<n>(hasher, poly);
+}
+
+// Given W uniform random sampled salts ( each of length `slen` ) and W messages
+// s.t. w-th message is of length mlens[w] -bytes, this function computes W
+// degree-(n-1) polynomials over Z_q, writing w-th of them to polys[w], exactly
+// same as W calls to `hash_to_point` would do.
+//
+// Rather than hashing one message after another, all W SHAKE256 states are
+// permuted at once, lane-interleaved ( see `keccak_xn::permute` ). A state,
+// whose padded salt and message is absorbed before others are, gets
+// snapshotted right after its last absorb permutation, so that extra
+// permutations, spent on rest of absorb phase, don't affect it. Squeeze phase
+// runs in lockstep, till every polynomial is filled, so that it costs as many
+// permutations as slowest state needs. Hence, this works best when messages
+// are of ( nearly ) same length.
+template<const size_t n, const size_t W>
+inline void
+hash_to_point_xn(const uint8_t* const* const __restrict salts,
+                 const size_t slen,
+                 const uint8_t* const* const __restrict msgs,
+                 const size_t* const __restrict mlens,
+                 ff::ff_t* const* const __restrict polys)
+  requires(((n == 512) || (n == 1024)) && ((W == 4) || (W == 8)))
 {
   constexpr size_t m = 1ul << 16;
   constexpr size_t q = ff::Q;
   constexpr size_t k = m / q;
   constexpr uint16_t kq = k * q;
 
-  shake256::shake256<true> hasher{};
-  hasher.absorb(salt, slen);
-  hasher.absorb(msg, mlen);
-  hasher.finalize();
+  constexpr size_t rbytes = shake256::rate >> 3;
+  constexpr size_t rwords = rbytes >> 3;
 
-  size_t coeff_idx = 0;
-  uint8_t buf[shake256::rate >> 3];
+  uint64_t state[25 * W]{};
+  uint64_t squeezed[25 * W]{};
+  uint8_t blk[rbytes];
 
-  while (coeff_idx < n) {
-    hasher.read(buf, sizeof(buf));
+  size_t blk_cnt[W];
+  size_t max_blk_cnt = 0;
 
-    for (size_t off = 0; (off < sizeof(buf)) && (coeff_idx < n); off += 2) {
-      const uint16_t t = (static_cast<uint16_t>(buf[off + 0]) << 8) |
-                         (static_cast<uint16_t>(buf[off + 1]) << 0);
-      if (t < kq) {
-        poly[coeff_idx] = ff::ff_t{ t };
-        coeff_idx++;
+  for (size_t w = 0; w < W; w++) {
+    // padding always takes at least a byte, so there's one more block
+    blk_cnt[w] = (slen + mlens[w]) / rbytes + 1;
+    max_blk_cnt = std::max(max_blk_cnt, blk_cnt[w]);
+  }
+
+  // absorb salt and message, one block of each state at a time
+  for (size_t b = 0; b < max_blk_cnt; b++) {
+    for (size_t w = 0; w < W; w++) {
+      if (b >= blk_cnt[w]) {
+        continue;
+      }
+
+      const size_t beg = b * rbytes;
+      const size_t end = std::min(beg + rbytes, slen + mlens[w]);
+
+      std::memset(blk, 0, sizeof(blk));
+
+      if (beg < slen) {
+        std::memcpy(blk, salts[w] + beg, std::min(end, slen) - beg);
+      }
+      if (end > slen) {
+        const size_t mbeg = std::max(beg, slen);
+        std::memcpy(blk + (mbeg - beg), msgs[w] + (mbeg - slen), end - mbeg);
+      }
+      if (b == blk_cnt[w] - 1) {
+        blk[end - beg] ^= 0x1f;
+        blk[rbytes - 1] ^= 0x80;
+      }
+
+      for (size_t i = 0; i < rwords; i++) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 8; j++) {
+          word |= static_cast<uint64_t>(blk[i * 8 + j]) << (j * 8);
+        }
+
+        state[i * W + w] ^= word;
+      }
+    }
+
+    keccak_xn::permute<W>(state);
+
+    for (size_t w = 0; w < W; w++) {
+      if (b == blk_cnt[w] - 1) {
+        for (size_t i = 0; i < 25; i++) {
+          squeezed[i * W + w] = state[i * W + w];
+        }
       }
     }
   }
+
+  // squeeze, till all polynomials are filled
+  size_t coeff_idx[W]{};
+
+  while (1) {
+    bool pending = false;
+
+    for (size_t w = 0; w < W; w++) {
+      ff::ff_t* const poly = polys[w];
+      size_t idx = coeff_idx[w];
+
+      for (size_t i = 0; (i < rwords) && (idx < n); i++) {
+        const uint64_t word = squeezed[i * W + w];
+
+        for (size_t off = 0; off < 64; off += 16) {
+          const uint16_t t = static_cast<uint16_t>(
+            (((word >> off) & 0xff) << 8) | ((word >> (off + 8)) & 0xff));
+
+          if ((t < kq) && (idx < n)) {
+            poly[idx] = ff::ff_t{ t };
+            idx++;
+          }
+        }
+      }
+
+      coeff_idx[w] = idx;
+      pending |= idx < n;
+    }
+
+    if (!pending) {
+      break;
+    }
+
+    keccak_xn::permute<W>(squeezed);
+  }
 }
 
 }
@@ -0,0 +1,109 @@
+#pragma once
+#include "codelets.hpp"
+#include "fft.hpp"
+
+// Routines operating on W polynomials ( in FFT form ) at once, which are stored
+// lane-interleaved s.t. i-th coefficient of polynomial of lane w lives at index
+// i * W + w. This lets all lanes share every twiddle factor and every Falcon tree
+// node load, while innermost loop, running over lanes, is easily vectorized.
+//
+// Each routine performs exactly same floating point operations, in same order,
+// as its single lane counterpart ( see fft.hpp, polynomial.hpp ), so results of
+// any lane don't depend on whether it's computed alone or along with others.
+namespace interleaved {
+
+// Writes N coefficients of polynomial f into lane w of interleaved polynomial.
+template<const size_t N, const size_t W>
+static inline void
+interleave(const fft::cmplx* const __restrict f,
+           const size_t w,
+           fft::cmplx* const __restrict fx)
+{
+  for (size_t i = 0; i < N; i++) {
+    fx[i * W + w] = f[i];
+  }
+}
+
+// Reads N coefficients of polynomial f from lane w of interleaved polynomial.
+template<const size_t N, const size_t W>
+static inline void
+deinterleave(const fft::cmplx* const __restrict fx,
+             const size_t w,
+             fft::cmplx* const __restrict f)
+{
+  for (size_t i = 0; i < N; i++) {
+    f[i] = fx[i * W + w];
+  }
+}
+
+// Lane-interleaved `fft::split_fft`, for W polynomials, each with 2^LOG2N
+// coefficients.
+template<const size_t LOG2N, const size_t W>
+static inline void
+split_fft(const fft::cmplx* const __restrict f,
+          fft::cmplx* const __restrict f0,
+          fft::cmplx* const __restrict f1)
+  requires((LOG2N > 0) && (LOG2N <= 10))
+{
+  constexpr size_t hN = (1ul << LOG2N) >> 1;
+
+  for (size_t i = 0; i < hN; i++) {
+    const auto ζ_exp = std::conj(fft::POWERS_OF_ζ[hN + i]);
+
+    for (size_t w = 0; w < W; w++) {
+      const auto a = f[(2 * i + 0) * W + w];
+      const auto b = f[(2 * i + 1) * W + w];
+
+      f0[i * W + w] = 0.5 * (a + b);
+      f1[i * W + w] = fft::mul(0.5 * (a - b), ζ_exp);
+    }
+  }
+}
+
+// Lane-interleaved `fft::merge_fft`, for W polynomials, each with 2^LOG2N
+// coefficients.
+template<const size_t LOG2N, const size_t W>
+static inline void
+merge_fft(const fft::cmplx* const __restrict f0,
+          const fft::cmplx* const __restrict f1,
+          fft::cmplx* const __restrict f)
+  requires((LOG2N > 0) && (LOG2N <= 10))
+{
+  constexpr size_t hN = (1ul << LOG2N) >> 1;
+
+  for (size_t i = 0; i < hN; i++) {
+    const auto ζ_exp = fft::POWERS_OF_ζ[hN + i];
+
+    for (size_t w = 0; w < W; w++) {
+      const auto t = fft::mul(f1[i * W + w], ζ_exp);
+
+      f[(2 * i + 0) * W + w] = f0[i * W + w] + t;
+      f[(2 * i + 1) * W + w] = f0[i * W + w] - t;
+    }
+  }
+}
+
+// Computes t0' = t0 + (t1 - z1) * l, for W lanes, each with 2^LOG2N
+// coefficients, where l ( not interleaved ) is shared by all lanes.
+template<const size_t LOG2N, const size_t W>
+static inline void
+sub_mul_add(const fft::cmplx* const __restrict t0,
+            const fft::cmplx* const __restrict t1,
+            const fft::cmplx* const __restrict z1,
+            const fft::cmplx* const __restrict l,
+            fft::cmplx* const __restrict t0_)
+  requires(LOG2N <= 10)
+{
+  constexpr size_t N = 1ul << LOG2N;
+
+  for (size_t i = 0; i < N; i++) {
+    const auto l_ = l[i];
+
+    for (size_t w = 0; w < W; w++) {
+      const size_t j = i * W + w;
+      t0_[j] = t0[j] + fft::mul(t1[j] - z1[j], l_);
+    }
+  }
+}
+
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__)
+#define FALCON_ISA_DISPATCH
+#endif
+
+// Run time selection of ISA variant ( scalar, AVX2 or AVX-512 ) of hot kernels
+namespace isa {
+
+// ISA variants, each hot kernel is compiled for, in increasing order.
+enum class level_t : uint8_t
+{
+  SCALAR = 0, // whatever target, library is compiled for, supports
+  AVX2 = 1,   // AVX2 + BMI1 + BMI2
+  AVX512 = 2  // AVX-512 F/ DQ/ BW/ VL + AVX2 + BMI1 + BMI2
+};
+
+// Human readable name of an ISA variant.
+inline constexpr const char*
+name(const level_t lvl)
+{
+  switch (lvl) {
+    case level_t::AVX512:
+      return "avx512";
+    case level_t::AVX2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+// Highest ISA variant, which can run on this CPU.
+inline level_t
+detect()
+{
+#if defined FALCON_ISA_DISPATCH
+  __builtin_cpu_init();
+
+  const bool avx2 = __builtin_cpu_supports("avx2") &&
+                    __builtin_cpu_supports("bmi") &&
+                    __builtin_cpu_supports("bmi2");
+  const bool avx512 = avx2 && __builtin_cpu_supports("avx512f") &&
+                      __builtin_cpu_supports("avx512dq") &&
+                      __builtin_cpu_supports("avx512bw") &&
+                      __builtin_cpu_supports("avx512vl");
+
+  if (avx512) {
+    return level_t::AVX512;
+  }
+  if (avx2) {
+    return level_t::AVX2;
+  }
+#endif
+  return level_t::SCALAR;
+}
+
+// ISA variant, to be used on this CPU, which is highest one CPU supports, unless
+// environment variable `FALCON_ISA` is set to one of "scalar", "avx2" or
+// "avx512", asking for a lower one. Asking for a variant CPU doesn't support
+// falls back to highest supported one, while unknown values are ignored.
+inline level_t
+from_env()
+{
+  const level_t supported = detect();
+  const char* const env = std::getenv("FALCON_ISA");
+
+  if (env == nullptr) {
+    return supported;
+  }
+
+  const std::string_view req{ env };
+  for (const level_t lvl : { level_t::SCALAR, level_t::AVX2, level_t::AVX512 }) {
+    if (req == name(lvl)) {
+      return std::min(lvl, supported);
+    }
+  }
+
+  return supported;
+}
+
+// ISA variant in use, selected once, at program startup.
+inline std::atomic<level_t> active_level{ from_env() };
+
+// ISA variant in use, which is what each dispatched kernel runs.
+inline level_t
+active()
+{
+  return active_level.load(std::memory_order_relaxed);
+}
+
+// Switches ISA variant in use, at run time, clamping it to highest one CPU
+// supports, returning variant which got selected. Meant for tests and
+// benchmarks, comparing variants, so it must not be called while other threads
+// are running dispatched kernels.
+inline level_t
+select(const level_t lvl)
+{
+  const level_t selected = std::min(lvl, detect());
+  active_level.store(selected, std::memory_order_relaxed);
+  return selected;
+}
+
+#if defined FALCON_ISA_DISPATCH
+
+// Invokes `f`, compiled for AVX2, after inlining every call it makes, so that
+// portable kernel code, inside `f`, gets vectorized with 256 -bit registers.
+template<typename F>
+__attribute__((target("avx2,bmi,bmi2"), flatten)) inline auto
+run_avx2(F& f)
+{
+  return f();
+}
+
+// Invokes `f`, compiled for AVX-512, after inlining every call it makes.
+template<typename F>
+__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,bmi,bmi2"),
+               flatten)) inline auto
+run_avx512(F& f)
+{
+  return f();
+}
+
+#endif
+
+// Runs kernel `f`, compiled for ISA variant in use ( see `active` ), returning
+// whatever it returns. Without dispatch support ( i.e. on non-x86_64 targets ),
+// `f` is just invoked.
+template<typename F>
+inline auto
+dispatch(F&& f)
+{
+#if defined FALCON_ISA_DISPATCH
+  switch (active()) {
+    case level_t::AVX512:
+      return run_avx512(f);
+    case level_t::AVX2:
+      return run_avx2(f);
+    default:
+      break;
+  }
+#endif
+  return f();
+}
+
+// Polynomials of degree below 2^MIN_LOG2N, which recursive ffSampling splits
+// down to, are too small for a wider ISA to pay for the call it takes to reach
+// it, so kernels run them inline, see `dispatch_n`.
+constexpr size_t MIN_LOG2N = 6;
+
+// Runs kernel `f`, over polynomials of degree 2^LOG2N, compiled for ISA
+// variant in use, when they are large enough, otherwise inline.
+template<const size_t LOG2N, typename F>
+inline auto
+dispatch_n(F&& f)
+{
+  if constexpr (LOG2N < MIN_LOG2N) {
+    return f();
+  } else {
+    return dispatch(f);
+  }
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "isa.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// W -way Keccak-f[1600] permutation, over W independent, lane-interleaved
+// states, for hashing many messages at once
+namespace keccak_xn {
+
+// Round constants, see section 3.2.5 of FIPS 202
+// https://doi.org/10.6028/NIST.FIPS.202
+constexpr uint64_t RC[24]{
+  0x0000000000000001ul, 0x0000000000008082ul, 0x800000000000808aul,
+  0x8000000080008000ul, 0x000000000000808bul, 0x0000000080000001ul,
+  0x8000000080008081ul, 0x8000000000008009ul, 0x000000000000008aul,
+  0x0000000000000088ul, 0x0000000080008009ul, 0x000000008000000aul,
+  0x000000008000808bul, 0x800000000000008bul, 0x8000000000008089ul,
+  0x8000000000008003ul, 0x8000000000008002ul, 0x8000000000000080ul,
+  0x000000000000800aul, 0x800000008000000aul, 0x8000000080008081ul,
+  0x8000000000008080ul, 0x0000000080000001ul, 0x8000000080008008ul
+};
+
+// Rotation offsets of ρ step, indexed by x + 5 * y
+constexpr int ROT[25]{ 0,  1,  62, 28, 27, 36, 44, 6,  55, 20, 3,  10, 43,
+                       25, 39, 41, 45, 15, 21, 8,  18, 2,  61, 56, 14 };
+
+// Destination of each lane, under π step, indexed by x + 5 * y
+constexpr size_t PI[25]{ 0,  10, 20, 5,  15, 16, 1,  11, 21, 6,  7,  17, 2,
+                         12, 22, 23, 8,  18, 3,  13, 14, 24, 9,  19, 4 };
+
+// Word i of all W states, packed in a single SIMD register, using GCC/ Clang
+// vector extension, which lowers to AVX2 ( W = 4 ) or AVX-512 ( W = 8 ), when
+// target supports it, otherwise to scalar instructions.
+template<const size_t W>
+struct lanes_t
+{
+  typedef uint64_t type __attribute__((vector_size(W * sizeof(uint64_t))));
+};
+
+// Rotates each 64 -bit lane of v left by r -bits, where r is known at
+// compile-time, once loops calling it are unrolled, writing result to dst.
+//
+// Vectors are passed by reference, because ABI of passing or returning them by
+// value depends on whether target has AVX, which baseline x86_64 doesn't.
+template<typename V>
+static inline void
+rotl(const V& v, const int r, V& dst)
+{
+  dst = r == 0 ? v : ((v << r) | (v >> (64 - r)));
+}
+
+// Applies Keccak-f[1600] permutation on W independent states, stored
+// lane-interleaved s.t. i-th 64 -bit word of state w lives at index i * W + w,
+// so that i-th word of all W states is loaded into a single SIMD register.
+// Each state is permuted exactly same as a standalone Keccak-f[1600] would do.
+//
+// Loops over state words are fully unrolled, so that whole state stays in
+// registers, throughout all 24 rounds.
+template<const size_t W>
+static inline void
+permute(uint64_t* const __restrict state)
+  requires((W == 4) || (W == 8))
+{
+  isa::dispatch([&] {
+    using vec_t = typename lanes_t<W>::type;
+
+    vec_t a[25];
+
+  #pragma GCC unroll 25
+    for (size_t i = 0; i < 25; i++) {
+      std::memcpy(&a[i], state + i * W, sizeof(vec_t));
+    }
+
+    for (size_t r = 0; r < 24; r++) {
+      vec_t c[5];
+      vec_t d[5];
+      vec_t b[25];
+
+      // θ
+  #pragma GCC unroll 5
+      for (size_t x = 0; x < 5; x++) {
+        c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+      }
+
+  #pragma GCC unroll 5
+      for (size_t x = 0; x < 5; x++) {
+        rotl(c[(x + 1) % 5], 1, d[x]);
+        d[x] ^= c[(x + 4) % 5];
+      }
+
+      // θ, ρ and π
+  #pragma GCC unroll 25
+      for (size_t i = 0; i < 25; i++) {
+        const vec_t t = a[i] ^ d[i % 5];
+        rotl(t, ROT[i], b[PI[i]]);
+      }
+
+      // χ
+  #pragma GCC unroll 5
+      for (size_t y = 0; y < 25; y += 5) {
+  #pragma GCC unroll 5
+        for (size_t x = 0; x < 5; x++) {
+          a[y + x] = b[y + x] ^ (~b[y + (x + 1) % 5] & b[y + (x + 2) % 5]);
+        }
+      }
+
+      // ι
+      a[0] ^= RC[r];
+    }
+
+  #pragma GCC unroll 25
+    for (size_t i = 0; i < 25; i++) {
+      std::memcpy(state + i * W, &a[i], sizeof(vec_t));
+    }
+  });
+}
+
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include "falcon.hpp"
+#include "prng.hpp"
+#include "scratch.hpp"
+#include "shake256.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+// Thread-safe cache of expanded Falcon{512, 1024} secret keys, for speeding up
+// signing through byte encoded secret key
+namespace key_cache {
+
+// Cached entries are keyed by SHAKE256 digest of byte encoded secret key.
+constexpr size_t DIGEST_LEN = 32;
+using digest_t = std::array<uint8_t, DIGEST_LEN>;
+
+// Computes digest of byte encoded Falcon{512, 1024} secret key.
+template<const size_t N>
+static inline digest_t
+digest(const uint8_t* const skey)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  digest_t dig;
+  shake256::shake256<false> hasher;
+
+  hasher.hash(skey, sklen);
+  hasher.read(dig.data(), dig.size());
+
+  return dig;
+}
+
+// Expanded Falcon{512, 1024} secret key i.e. 2x2 matrix B = [[g, -f], [G, -F]]
+// and Falcon tree T, both in FFT form, living in a single 64 -bytes aligned
+// allocation, which is securely wiped when entry is destroyed. Constructor
+// throws `std::bad_alloc`, if that allocation fails.
+template<const size_t N>
+  requires((N == 512) || (N == 1024))
+struct entry_t
+{
+  static constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+
+  // Compile-time compute how many bytes are taken by an entry, which is what
+  // is accounted against memory cap of cache.
+  static constexpr size_t bytes()
+  {
+    return scratch::bytes<fft::cmplx>(2 * 2 * N) +
+           scratch::bytes<fft::cmplx>(tlen);
+  }
+
+  uint8_t* const mem;
+  fft::cmplx* const B;
+  fft::cmplx* const T;
+
+  // Allocates memory backing an entry, throwing if it can't be allocated.
+  static inline uint8_t* allocate()
+  {
+    auto ptr = std::aligned_alloc(scratch::ALIGNMENT, bytes());
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    return static_cast<uint8_t*>(ptr);
+  }
+
+  inline entry_t()
+    : mem(allocate())
+    , B(reinterpret_cast<fft::cmplx*>(mem))
+    , T(reinterpret_cast<fft::cmplx*>(
+        mem + scratch::bytes<fft::cmplx>(2 * 2 * N)))
+  {
+  }
+
+  entry_t(const entry_t&) = delete;
+  entry_t& operator=(const entry_t&) = delete;
+
+  inline ~entry_t()
+  {
+    scratch::secure_wipe(mem, bytes());
+    std::free(mem);
+  }
+
+  // Decodes secret key and computes B and T, returning false if secret key
+  // can't be decoded, see `falcon::expand_skey`.
+  inline bool expand(const uint8_t* const __restrict skey)
+  {
+    return falcon::expand_skey<N>(skey, B, T);
+  }
+};
+
+// Cache of expanded Falcon{512, 1024} secret keys, keyed by digest of byte
+// encoded secret key, holding as many entries as fit within `max_bytes`, while
+// least recently used entry is evicted first.
+//
+// Entries are handed out as shared pointers, so an entry which gets evicted,
+// while some thread is still signing with it, is wiped and released only once
+// that thread is done. Expansion of a missing key happens outside of the lock,
+// so that one slow miss doesn't stall signing with already cached keys.
+template<const size_t N>
+  requires((N == 512) || (N == 1024))
+class key_cache_t
+{
+private:
+  using entry_ptr = std::shared_ptr<const entry_t<N>>;
+  using lru_t = std::list<std::pair<digest_t, entry_ptr>>;
+
+  struct digest_hash_t
+  {
+    size_t operator()(const digest_t& dig) const
+    {
+      size_t h;
+      std::memcpy(&h, dig.data(), sizeof(h));
+      return h;
+    }
+  };
+
+  mutable std::mutex lock;
+  size_t max_bytes;
+  lru_t lru; // most recently used entry at front
+  std::unordered_map<digest_t, typename lru_t::iterator, digest_hash_t> index;
+
+  std::atomic<size_t> hit_cnt{ 0 };
+  std::atomic<size_t> miss_cnt{ 0 };
+
+  // Evicts least recently used entries, until cache fits within memory cap.
+  // Must be called while holding the lock.
+  inline void evict()
+  {
+    while (lru.size() * entry_t<N>::bytes() > max_bytes) {
+      index.erase(lru.back().first);
+      lru.pop_back();
+    }
+  }
+
+public:
+  // Creates an empty cache, which can hold expanded keys of at max
+  // `max_bytes` -bytes, see `entry_t::bytes()`.
+  explicit inline key_cache_t(const size_t max_bytes)
+    : max_bytes(max_bytes)
+  {
+  }
+
+  key_cache_t(const key_cache_t&) = delete;
+  key_cache_t& operator=(const key_cache_t&) = delete;
+
+  // Changes memory cap of cache, evicting entries if required.
+  inline void set_capacity(const size_t max_bytes_)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+
+    max_bytes = max_bytes_;
+    evict();
+  }
+
+  // Evicts all entries.
+  inline void clear()
+  {
+    std::lock_guard<std::mutex> guard(lock);
+
+    index.clear();
+    lru.clear();
+  }
+
+  // Number of cached entries.
+  inline size_t size() const
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    return lru.size();
+  }
+
+  // Number of lookups, which found ( or didn't find ) expanded key in cache.
+  inline size_t hits() const { return hit_cnt.load(std::memory_order_relaxed); }
+  inline size_t misses() const
+  {
+    return miss_cnt.load(std::memory_order_relaxed);
+  }
+
+  // Looks up expanded secret key, expanding and caching it on miss. Returns
+  // nullptr if secret key can't be decoded. Throws `std::bad_alloc`, if memory
+  // for a missing entry can't be allocated.
+  inline entry_ptr get(const uint8_t* const __restrict skey)
+  {
+    const digest_t dig = digest<N>(skey);
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+
+      const auto it = index.find(dig);
+      if (it != index.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+        hit_cnt.fetch_add(1, std::memory_order_relaxed);
+
+        return it->second->second;
+      }
+    }
+
+    miss_cnt.fetch_add(1, std::memory_order_relaxed);
+
+    auto entry = std::make_shared<entry_t<N>>();
+    if (!entry->expand(skey)) [[unlikely]] {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    // some other thread may have cached same key, in the meantime
+    const auto it = index.find(dig);
+    if (it != index.end()) {
+      lru.splice(lru.begin(), lru, it->second);
+      return it->second->second;
+    }
+
+    if (entry_t<N>::bytes() <= max_bytes) {
+      lru.emplace_front(dig, entry);
+      index.emplace(dig, lru.begin());
+      evict();
+    }
+
+    return entry;
+  }
+
+  // Signs message using expanded secret key, obtained from cache, while
+  // randomness is sampled from a PRNG, local to calling thread. Returns false
+  // if secret key can't be decoded.
+  inline bool sign(const uint8_t* const __restrict skey,
+                   const uint8_t* const __restrict msg,
+                   const size_t mlen,
+                   uint8_t* const __restrict sig)
+  {
+    prng::prng_t& rng = prng::thread_prng();
+
+    const auto entry = get(skey);
+    if (entry == nullptr) [[unlikely]] {
+      return false;
+    }
+
+    falcon::sign<N>(entry->B, entry->T, msg, mlen, sig, rng);
+    return true;
+  }
+};
+
+// Process-wide cache, consulted by `falcon::sign(skey, msg, mlen, sig)`, once
+// enabled, see `enable`.
+template<const size_t N>
+static inline key_cache_t<N>&
+global()
+  requires((N == 512) || (N == 1024))
+{
+  static key_cache_t<N> cache(0);
+  return cache;
+}
+
+// Signs using process-wide cache, installed as `falcon::sign_skey_hook`.
+template<const size_t N>
+static inline bool
+global_sign(const uint8_t* const __restrict skey,
+            const uint8_t* const __restrict msg,
+            const size_t mlen,
+            uint8_t* const __restrict sig)
+  requires((N == 512) || (N == 1024))
+{
+  return global<N>().sign(skey, msg, mlen, sig);
+}
+
+// Opts in to caching expanded secret keys, of at max `max_bytes` -bytes, behind
+// `falcon::sign(skey, msg, mlen, sig)`, so that repeatedly signing with same
+// secret key doesn't expand it every time.
+template<const size_t N>
+static inline void
+enable(const size_t max_bytes)
+  requires((N == 512) || (N == 1024))
+{
+  global<N>().set_capacity(max_bytes);
+  falcon::sign_skey_hook<N>.store(&global_sign<N>, std::memory_order_release);
+}
+
+// Opts out of caching expanded secret keys, wiping all cached entries.
+template<const size_t N>
+static inline void
+disable()
+  requires((N == 512) || (N == 1024))
+{
+  falcon::sign_skey_hook<N>.store(nullptr, std::memory_order_release);
+  global<N>().clear();
+}
+
+}
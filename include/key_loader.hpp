@@ -0,0 +1,198 @@
+#pragma once
+#include "falcon.hpp"
+#include "scratch.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+
+// Parallel, bulk expansion of Falcon{512, 1024} secret keys, at service boot
+namespace key_loader {
+
+// Expansion status of a key, held by bulk loader.
+enum class status_t : uint8_t
+{
+  PENDING = 0, // not yet expanded
+  READY = 1,   // B and T can be used for signing
+  FAILED = 2,  // secret key can't be decoded
+};
+
+// Bulk loader of byte encoded secret keys, which expands each of them ( see
+// `falcon::expand_skey` ) into 2x2 matrix B and Falcon tree T, over a pool of
+// worker threads, writing into a single preallocated, 64 -bytes aligned region,
+// holding all expanded keys, one after another.
+//
+// Loading happens in background, so that a node can start serving, as soon as
+// `load` returns, signing with keys which are already READY, while rest of them
+// are still being expanded. Per-key status is published with release semantics,
+// after B and T are fully written, so that a thread which observes READY also
+// observes complete B and T. Keys are handed out to workers dynamically, so
+// time-to-ready scales with # -of worker threads.
+//
+// Expanded keys are wiped when loader is destroyed. Falcon tree T is laid out
+// following memory layout L, see `falcon_tree::layout_t`.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+  requires((N == 512) || (N == 1024))
+class loader_t
+{
+public:
+  // Invoked, from a worker thread, once for each key, as soon as it's either
+  // READY or FAILED, with its index and whether it was expanded. Must not throw.
+  using callback_t = std::function<void(size_t, bool)>;
+
+private:
+  static constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  static constexpr size_t blen = scratch::bytes<fft::cmplx>(2 * 2 * N);
+  static constexpr size_t rlen = blen + scratch::bytes<fft::cmplx>(tlen);
+
+  struct free_t
+  {
+    void operator()(uint8_t* const ptr) const { std::free(ptr); }
+  };
+
+  size_t count;
+  std::unique_ptr<uint8_t, free_t> mem;
+  std::unique_ptr<std::atomic<status_t>[]> status_;
+
+  std::atomic<size_t> done_cnt{ 0 };
+  std::atomic<size_t> fail_cnt{ 0 };
+
+  thread_pool::thread_pool_t pool;
+  std::thread driver; // posts expansion job to pool, without blocking caller
+  bool started = false;
+
+  // Where B and T of i-th key live, in preallocated region.
+  inline fft::cmplx* B_(const size_t i) const
+  {
+    return reinterpret_cast<fft::cmplx*>(mem.get() + i * rlen);
+  }
+
+  inline fft::cmplx* T_(const size_t i) const
+  {
+    return reinterpret_cast<fft::cmplx*>(mem.get() + i * rlen + blen);
+  }
+
+  // Allocates region holding `count` -many expanded keys, throwing if its size
+  // overflows or it can't be allocated.
+  static inline uint8_t* allocate(const size_t count)
+  {
+    if (count > std::numeric_limits<size_t>::max() / rlen) {
+      throw std::bad_alloc();
+    }
+
+    const size_t len = std::max<size_t>(count, 1) * rlen;
+    auto ptr = std::aligned_alloc(scratch::ALIGNMENT, len);
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    return static_cast<uint8_t*>(ptr);
+  }
+
+public:
+  // Preallocates storage for `count` -many expanded keys and spawns `threads`
+  // -many worker threads ( by default, as many as there are hardware threads ).
+  //
+  // Throws `std::bad_alloc`, if storage for expanded keys can't be allocated.
+  explicit inline loader_t(
+    const size_t count,
+    const size_t threads = std::thread::hardware_concurrency())
+    : count(count)
+    , mem(allocate(count))
+    , status_(new std::atomic<status_t>[count])
+    , pool(threads)
+  {
+    for (size_t i = 0; i < count; i++) {
+      status_[i].store(status_t::PENDING, std::memory_order_relaxed);
+    }
+  }
+
+  loader_t(const loader_t&) = delete;
+  loader_t& operator=(const loader_t&) = delete;
+
+  // Waits for ongoing load ( if any ) and wipes all expanded keys.
+  inline ~loader_t()
+  {
+    wait();
+    scratch::secure_wipe(mem.get(), count * rlen);
+  }
+
+  // Starts expanding `count` -many byte encoded secret keys, living one after
+  // another, in background, returning immediately. Secret keys must stay alive
+  // till loading is done, see `wait`. Optional callback is invoked as each key
+  // gets expanded. Returns false if a load was already started, as a loader
+  // loads only once.
+  inline bool load(const uint8_t* const skeys, callback_t cb = nullptr)
+  {
+    if (started) {
+      return false;
+    }
+    started = true;
+
+    driver = std::thread([this, skeys, cb = std::move(cb)] {
+      constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+      const std::function<void(size_t, size_t)> job = [&](const size_t,
+                                                          const size_t tidx) {
+        const bool ok = falcon::expand_skey<N, L>(
+          skeys + tidx * sklen, B_(tidx), T_(tidx));
+
+        status_[tidx].store(ok ? status_t::READY : status_t::FAILED,
+                            std::memory_order_release);
+
+        fail_cnt.fetch_add(!ok, std::memory_order_relaxed);
+        done_cnt.fetch_add(1, std::memory_order_release);
+
+        if (cb) {
+          cb(tidx, ok);
+        }
+      };
+
+      pool.run(count, job);
+    });
+
+    return true;
+  }
+
+  // Blocks caller until all keys are either READY or FAILED.
+  inline void wait()
+  {
+    if (driver.joinable()) {
+      driver.join();
+    }
+  }
+
+  // Number of keys, held by loader.
+  inline size_t size() const { return count; }
+
+  // Number of keys which are already either READY or FAILED.
+  inline size_t done() const { return done_cnt.load(std::memory_order_acquire); }
+
+  // Number of keys which couldn't be decoded.
+  inline size_t failed() const
+  {
+    return fail_cnt.load(std::memory_order_relaxed);
+  }
+
+  // Expansion status of i-th key.
+  inline status_t status(const size_t i) const
+  {
+    return status_[i].load(std::memory_order_acquire);
+  }
+
+  // Whether i-th key is READY for signing.
+  inline bool ready(const size_t i) const { return status(i) == status_t::READY; }
+
+  // Matrix B = [[g, -f], [G, -F]] of i-th key, only meaningful once READY.
+  inline const fft::cmplx* B(const size_t i) const { return B_(i); }
+
+  // Falcon tree T of i-th key, only meaningful once READY.
+  inline const fft::cmplx* T(const size_t i) const { return T_(i); }
+};
+
+}
@@ -0,0 +1,561 @@
+#pragma once
+#include "falcon.hpp"
+#include "scratch.hpp"
+#include "shake256.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Persistent, memory-mappable store of expanded Falcon{512, 1024} secret keys
+namespace key_store {
+
+// Expanded secret key store is a single file, laid out as
+//
+// <64 -bytes header> +
+// <zero padding, till PAGE_SIZE boundary> +
+// <count -many records, each of `record_bytes<N>()` -bytes> +
+// <count -many directory entries, each of 64 -bytes, sorted by key id>
+//
+// s.t. each record holds 2x2 matrix B = [[g, -f], [G, -F]] followed by Falcon
+// tree T ( in FFT form, laid out following memory layout recorded in header ),
+// both starting at 64 -bytes boundary, so that signing routines can be handed
+// pointers, straight into memory mapped file. Floating point numbers are kept
+// in native byte order, which is recorded in header, so a store is not
+// portable across machines of different endianness.
+constexpr uint8_t MAGIC[8]{ 'F', 'A', 'L', 'C', 'O', 'N', 'X', 'K' };
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t ENDIANNESS = 0x01020304;
+constexpr size_t PAGE_SIZE = 4096;
+
+// Keys are identified by SHAKE256 digest of their byte encoded public key.
+constexpr size_t ID_LEN = 32;
+constexpr size_t CHECKSUM_LEN = 16;
+
+struct header_t
+{
+  uint8_t magic[8];
+  uint32_t version;
+  uint32_t endianness;
+  uint32_t n;      // Falcon{512, 1024}
+  uint32_t layout; // see `falcon_tree::layout_t`
+  uint64_t count;  // # -of records
+  uint64_t record_bytes;
+  uint64_t data_offset; // offset of first record
+  uint64_t dir_offset;  // offset of first directory entry
+  uint64_t reserved;
+};
+
+struct dir_entry_t
+{
+  uint8_t key_id[ID_LEN];
+  uint64_t offset;                 // offset of record, from start of file
+  uint8_t checksum[CHECKSUM_LEN]; // SHAKE256 digest of record
+  uint64_t reserved;
+};
+
+static_assert(sizeof(header_t) == 64, "Header must be 64 -bytes !");
+static_assert(sizeof(dir_entry_t) == 64, "Directory entry must be 64 -bytes !");
+
+// Compile-time compute byte length of a record, holding B and T.
+template<const size_t N>
+static inline constexpr size_t
+record_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  return scratch::bytes<fft::cmplx>(2 * 2 * N) +
+         scratch::bytes<fft::cmplx>(tlen);
+}
+
+// Computes key id i.e. SHAKE256 digest of byte encoded public key.
+template<const size_t N>
+static inline void
+key_id(const uint8_t* const __restrict pkey, uint8_t* const __restrict id)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+
+  shake256::shake256<false> hasher;
+  hasher.hash(pkey, pklen);
+  hasher.read(id, ID_LEN);
+}
+
+// Computes checksum of `len` -bytes record.
+static inline void
+checksum(const uint8_t* const __restrict rec,
+         const size_t len,
+         uint8_t* const __restrict cs)
+{
+  shake256::shake256<false> hasher;
+  hasher.hash(rec, len);
+  hasher.read(cs, CHECKSUM_LEN);
+}
+
+// Decodes byte encoded secret key, computing B, T ( following memory layout L )
+// and key id ( from recomputed public key ). Returns false if secret key can't
+// be decoded or G can't be recomputed from it, see `falcon::recompute_G`.
+// Intermediate f, g, F, G are wiped before returning.
+template<const size_t N, const falcon_tree::layout_t L>
+static inline bool
+expand_skey(const uint8_t* const __restrict skey,
+            fft::cmplx* const __restrict B,
+            fft::cmplx* const __restrict T,
+            uint8_t* const __restrict id)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+
+  int32_t f[N];
+  int32_t g[N];
+  int32_t F[N];
+  int32_t G[N];
+  ff::ff_t h[N];
+  uint8_t pkey[pklen];
+
+  const bool expanded = decoding::decode_skey<N>(skey, f, g, F) &&
+                        falcon::recompute_G<N>(f, g, F, G);
+  if (expanded) [[likely]] {
+    falcon::compute_matrix_B<N>(f, g, F, G, B);
+    falcon::compute_falcon_tree<N, L>(B, T);
+
+    keygen::compute_public_key<N>(f, g, h);
+    encoding::encode_pkey<N>(h, pkey);
+    key_id<N>(pkey, id);
+  }
+
+  scratch::secure_wipe(f, sizeof(f));
+  scratch::secure_wipe(g, sizeof(g));
+  scratch::secure_wipe(F, sizeof(F));
+  scratch::secure_wipe(G, sizeof(G));
+
+  return expanded;
+}
+
+// Writes all `len` -bytes to file descriptor, starting at offset `off`.
+static inline bool
+pwrite_all(const int fd, const void* const buf, const size_t len, off_t off)
+{
+  const uint8_t* ptr = static_cast<const uint8_t*>(buf);
+  size_t left = len;
+
+  while (left > 0) {
+    const ssize_t n = ::pwrite(fd, ptr, left, off);
+    if (n <= 0) {
+      return false;
+    }
+
+    ptr += n;
+    left -= static_cast<size_t>(n);
+    off += n;
+  }
+
+  return true;
+}
+
+// Streaming writer of expanded secret key store, which writes each record as
+// soon as it's added, keeping only directory in memory, so that a store of any
+// size can be built, offline, without holding all expanded keys in memory.
+// Directory and header are written by `finish`.
+//
+// A record is staged in a heap buffer, owned by writer, which is wiped as soon
+// as record is written. If that buffer can't be allocated, every `add` fails.
+//
+// Writer doesn't own file descriptor, caller is responsible for closing it.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+  requires((N == 512) || (N == 1024))
+class writer_t
+{
+private:
+  static constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  static constexpr size_t toff = scratch::bytes<fft::cmplx>(2 * 2 * N);
+
+  struct free_t
+  {
+    void operator()(uint8_t* const ptr) const { std::free(ptr); }
+  };
+
+  int fd;
+  bool ok = true;
+  std::vector<dir_entry_t> dir;
+  std::unique_ptr<uint8_t, free_t> rec;
+
+  // Checksums staged record and writes it, identified by key id, wiping it
+  // afterwards.
+  inline bool put(const uint8_t* const __restrict id)
+  {
+    dir_entry_t entry{};
+    std::memcpy(entry.key_id, id, ID_LEN);
+    entry.offset = PAGE_SIZE + dir.size() * record_bytes<N>();
+    checksum(rec.get(), record_bytes<N>(), entry.checksum);
+
+    ok &= pwrite_all(
+      fd, rec.get(), record_bytes<N>(), static_cast<off_t>(entry.offset));
+    scratch::secure_wipe(rec.get(), record_bytes<N>());
+
+    dir.push_back(entry);
+    return ok;
+  }
+
+public:
+  explicit inline writer_t(const int fd)
+    : fd(fd)
+    , rec(static_cast<uint8_t*>(
+        std::aligned_alloc(scratch::ALIGNMENT, record_bytes<N>())))
+  {
+    if (rec == nullptr) {
+      ok = false;
+      return;
+    }
+
+    // padding, if any, following B and T, is written as zeros
+    std::memset(rec.get(), 0, record_bytes<N>());
+  }
+
+  writer_t(const writer_t&) = delete;
+  writer_t& operator=(const writer_t&) = delete;
+
+  // Appends a record, holding B and T, identified by key id.
+  inline bool add(const uint8_t* const __restrict id,
+                  const fft::cmplx* const __restrict B,
+                  const fft::cmplx* const __restrict T)
+  {
+    if (rec == nullptr) [[unlikely]] {
+      return false;
+    }
+
+    std::memcpy(rec.get(), B, sizeof(fft::cmplx) * 2 * 2 * N);
+    std::memcpy(rec.get() + toff, T, sizeof(fft::cmplx) * tlen);
+
+    return put(id);
+  }
+
+  // Expands byte encoded secret key, straight into staged record, and appends
+  // it, identified by digest of its public key, see `expand_skey`.
+  inline bool add(const uint8_t* const __restrict skey)
+  {
+    if (rec == nullptr) [[unlikely]] {
+      return false;
+    }
+
+    auto B = reinterpret_cast<fft::cmplx*>(rec.get());
+    auto T = reinterpret_cast<fft::cmplx*>(rec.get() + toff);
+    uint8_t id[ID_LEN];
+
+    if (!expand_skey<N, L>(skey, B, T, id)) [[unlikely]] {
+      scratch::secure_wipe(rec.get(), record_bytes<N>());
+      return false;
+    }
+
+    return put(id);
+  }
+
+  // Writes directory ( sorted by key id ) and header, completing the store.
+  // Returns false if any write failed or same key id was added more than once.
+  inline bool finish()
+  {
+    std::sort(dir.begin(), dir.end(), [](const auto& a, const auto& b) {
+      return std::memcmp(a.key_id, b.key_id, ID_LEN) < 0;
+    });
+
+    for (size_t i = 1; i < dir.size(); i++) {
+      ok &= std::memcmp(dir[i - 1].key_id, dir[i].key_id, ID_LEN) != 0;
+    }
+
+    header_t hdr{};
+    std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.version = VERSION;
+    hdr.endianness = ENDIANNESS;
+    hdr.n = N;
+    hdr.layout = static_cast<uint32_t>(L);
+    hdr.count = dir.size();
+    hdr.record_bytes = record_bytes<N>();
+    hdr.data_offset = PAGE_SIZE;
+    hdr.dir_offset = PAGE_SIZE + dir.size() * record_bytes<N>();
+
+    const size_t dlen = sizeof(dir_entry_t) * dir.size();
+    const off_t doff = static_cast<off_t>(hdr.dir_offset);
+
+    ok &= (dlen == 0) || pwrite_all(fd, dir.data(), dlen, doff);
+    ok &= pwrite_all(fd, &hdr, sizeof(hdr), 0);
+
+    // zero padding, following header
+    uint8_t pad[PAGE_SIZE - sizeof(hdr)]{};
+    ok &= pwrite_all(fd, pad, sizeof(pad), sizeof(hdr));
+
+    return ok;
+  }
+};
+
+// Builds expanded secret key store at `path`, from `count` -many byte encoded
+// secret keys, living one after another. This is meant to be run once,
+// offline. Returns false if any secret key can't be decoded or store can't be
+// written.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline bool
+build(const char* const path,
+      const uint8_t* const __restrict skeys,
+      const size_t count)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  const int fd = ::open(path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    return false;
+  }
+
+  writer_t<N, L> writer(fd);
+
+  bool ok = true;
+  for (size_t i = 0; (i < count) && ok; i++) {
+    ok &= writer.add(skeys + i * sklen);
+  }
+
+  ok = ok && writer.finish();
+  ok &= ::fsync(fd) == 0;
+  ok &= ::close(fd) == 0;
+
+  return ok;
+}
+
+// Seals, which make a memory file immutable, see `create_segment`.
+constexpr int SEALS = F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+// Builds expanded secret key store, from `count` -many byte encoded secret
+// keys, in an anonymous memory file ( see memfd_create(2) ), which is sealed
+// against any further modification, once written. Returns file descriptor of
+// memory file, or -1 if any secret key can't be decoded or memory file can't be
+// created.
+//
+// This is meant for a daemon which pre-forks its worker processes : keys are
+// expanded only once, by parent process, before forking, while each worker
+// maps inherited file descriptor read-only ( see `mapped_t::attach` ), so that
+// all workers share same physical pages, instead of holding private copies of
+// every expanded key. As segment is sealed, a compromised worker can't tamper
+// with keys used by others. File descriptor can also be handed to unrelated
+// processes, over a unix domain socket.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline int
+create_segment(const uint8_t* const __restrict skeys, const size_t count)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+
+  const int fd = ::memfd_create("falcon-keys", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return -1;
+  }
+
+  writer_t<N, L> writer(fd);
+
+  bool ok = true;
+  for (size_t i = 0; (i < count) && ok; i++) {
+    ok &= writer.add(skeys + i * sklen);
+  }
+
+  ok = ok && writer.finish();
+  ok = ok && (::fcntl(fd, F_ADD_SEALS, SEALS) == 0);
+
+  if (!ok) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Checks whether file descriptor refers to a memory file, sealed by
+// `create_segment`, which a worker can attach to, knowing that nobody can
+// modify it underneath.
+static inline bool
+is_sealed(const int fd)
+{
+  const int seals = ::fcntl(fd, F_GET_SEALS);
+  return (seals >= 0) && ((seals & SEALS) == SEALS);
+}
+
+// Read-only, zero-copy view of expanded secret key store, memory mapped from a
+// file ( or any other mappable file descriptor ). Matrix B and Falcon tree T of
+// each key point straight into the mapping, so opening a store costs only as
+// much as validating its header and directory, while pages holding expanded
+// keys are faulted in, on first use.
+//
+// Store must have been written for same N and Falcon tree layout L.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+  requires((N == 512) || (N == 1024))
+class mapped_t
+{
+private:
+  const uint8_t* base = nullptr;
+  size_t len = 0;
+  const header_t* hdr = nullptr;
+  const dir_entry_t* dir = nullptr;
+
+  // Checks that mapped bytes hold a well-formed store, touching only header
+  // and directory.
+  inline bool validate() const
+  {
+    if (len < PAGE_SIZE) {
+      return false;
+    }
+
+    bool ok = std::memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) == 0;
+    ok &= hdr->version == VERSION;
+    ok &= hdr->endianness == ENDIANNESS;
+    ok &= hdr->n == N;
+    ok &= hdr->layout == static_cast<uint32_t>(L);
+    ok &= hdr->record_bytes == record_bytes<N>();
+    ok &= hdr->data_offset == PAGE_SIZE;
+
+    // bounds are checked s.t. arithmetic can't overflow
+    ok = ok && (hdr->count <= (len - PAGE_SIZE) / record_bytes<N>());
+    ok = ok && (hdr->dir_offset <= len) &&
+         (hdr->dir_offset % alignof(dir_entry_t) == 0) &&
+         (hdr->count <= (len - hdr->dir_offset) / sizeof(dir_entry_t));
+    if (!ok) {
+      return false;
+    }
+
+    const auto dir_ = reinterpret_cast<const dir_entry_t*>(base + hdr->dir_offset);
+
+    for (size_t i = 0; i < hdr->count; i++) {
+      const uint64_t off = dir_[i].offset;
+
+      ok &= (off >= PAGE_SIZE) && (off % scratch::ALIGNMENT == 0) &&
+            (off <= len - record_bytes<N>());
+      ok &= (i == 0) ||
+            (std::memcmp(dir_[i - 1].key_id, dir_[i].key_id, ID_LEN) < 0);
+    }
+
+    return ok;
+  }
+
+public:
+  // Index returned by `find`, when key is not found.
+  static constexpr size_t npos = ~0ul;
+
+  inline mapped_t() = default;
+  mapped_t(const mapped_t&) = delete;
+  mapped_t& operator=(const mapped_t&) = delete;
+
+  inline ~mapped_t() { close(); }
+
+  // Maps store, backed by file descriptor, read-only. File descriptor can be
+  // closed as soon as this returns. With `populate` set, all pages are faulted
+  // in, right away. Returns false if store is malformed or can't be mapped.
+  inline bool attach(const int fd, const bool populate = false)
+  {
+    close();
+
+    struct stat st;
+    if ((::fstat(fd, &st) != 0) || (st.st_size < 0)) {
+      return false;
+    }
+
+    len = static_cast<size_t>(st.st_size);
+    if (len < PAGE_SIZE) {
+      len = 0;
+      return false;
+    }
+
+    const int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+    void* const ptr = ::mmap(nullptr, len, PROT_READ, flags, fd, 0);
+    if (ptr == MAP_FAILED) {
+      len = 0;
+      return false;
+    }
+
+    base = static_cast<const uint8_t*>(ptr);
+    hdr = reinterpret_cast<const header_t*>(base);
+
+    if (!validate()) {
+      close();
+      return false;
+    }
+
+    dir = reinterpret_cast<const dir_entry_t*>(base + hdr->dir_offset);
+    return true;
+  }
+
+  // Opens and maps store, living at `path`, see `attach`.
+  inline bool open(const char* const path, const bool populate = false)
+  {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+
+    const bool ok = attach(fd, populate);
+    ::close(fd);
+
+    return ok;
+  }
+
+  // Unmaps store, if mapped.
+  inline void close()
+  {
+    if (base != nullptr) {
+      ::munmap(const_cast<uint8_t*>(base), len);
+    }
+
+    base = nullptr;
+    len = 0;
+    hdr = nullptr;
+    dir = nullptr;
+  }
+
+  // Number of expanded keys in store.
+  inline size_t size() const { return hdr == nullptr ? 0 : hdr->count; }
+
+  // Key id of i-th expanded key, in sorted order.
+  inline const uint8_t* key_id(const size_t i) const { return dir[i].key_id; }
+
+  // Matrix B = [[g, -f], [G, -F]] of i-th expanded key.
+  inline const fft::cmplx* B(const size_t i) const
+  {
+    return reinterpret_cast<const fft::cmplx*>(base + dir[i].offset);
+  }
+
+  // Falcon tree T of i-th expanded key, laid out following layout L.
+  inline const fft::cmplx* T(const size_t i) const
+  {
+    constexpr size_t toff = scratch::bytes<fft::cmplx>(2 * 2 * N);
+    return reinterpret_cast<const fft::cmplx*>(base + dir[i].offset + toff);
+  }
+
+  // Binary searches directory for key id, returning its index or `npos`.
+  inline size_t find(const uint8_t* const id) const
+  {
+    const auto end = dir + size();
+    const auto it =
+      std::lower_bound(dir, end, id, [](const dir_entry_t& e, const uint8_t* k) {
+        return std::memcmp(e.key_id, k, ID_LEN) < 0;
+      });
+
+    if ((it == end) || (std::memcmp(it->key_id, id, ID_LEN) != 0)) {
+      return npos;
+    }
+    return static_cast<size_t>(it - dir);
+  }
+
+  // Checks whether i-th record still matches its checksum. This touches every
+  // page of the record, so it's not done when store is opened.
+  inline bool check(const size_t i) const
+  {
+    uint8_t cs[CHECKSUM_LEN];
+    checksum(base + dir[i].offset, record_bytes<N>(), cs);
+
+    return std::memcmp(cs, dir[i].checksum, CHECKSUM_LEN) == 0;
+  }
+};
+
+}
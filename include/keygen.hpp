@@ -3,6 +3,9 @@
 #include "ff.hpp"
 #include "fft.hpp"
 #include "ntru_gen.hpp"
+#include "scratch.hpp"
+#include <algorithm>
+#include <cassert>
 
 // Falcon{512, 1024} Key Pair Generation related Routines
 namespace keygen {
@@ -21,19 +24,20 @@ namespace keygen {
 // https://github.com/tprest/falcon.py/blob/88d01ede1d7fa74a8392116bc5149dee57af93f2/ffsampling.py#L15-L31
 // where it's shown how Gram matrix of B can be computed in coefficient
 // representation.
-template<const size_t N>
+template<const size_t N, fft::complex_number C>
 static inline void
 compute_gram_matrix(
-  const fft::cmplx* const __restrict B, // 2 x 2 x N complex numbers
-  fft::cmplx* const __restrict G        // 2 x 2 x N complex numbers
+  const C* const __restrict B, // 2 x 2 x N complex numbers
+  C* const __restrict G,       // 2 x 2 x N complex numbers
+  C* const __restrict ws       // see `gram_matrix_scratch_bytes`
   )
   requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
 {
-  fft::cmplx B_adj[N * 2 * 2];
-  fft::cmplx tmp[N];
+  C* const B_adj = ws;
+  C* const tmp = ws + 4 * N;
 
   // compute B*
-  std::memcpy(B_adj, B, sizeof(B_adj));
+  std::memcpy(B_adj, B, sizeof(C) * N * 2 * 2);
   fft::adj_poly<log2<N>()>(B_adj);
   fft::adj_poly<log2<N>()>(B_adj + N);
   fft::adj_poly<log2<N>()>(B_adj + 2 * N);
@@ -60,6 +64,30 @@ compute_gram_matrix(
   polynomial::add_to<log2<N>()>(G + 3 * N, tmp);
 }
 
+// Compile-time compute how many bytes of scratch space are required by
+// workspace taking variant of `compute_gram_matrix` i.e. for keeping B* and
+// one temporary polynomial.
+template<const size_t N>
+static inline constexpr size_t
+gram_matrix_scratch_bytes()
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  return scratch::bytes<fft::cmplx>(5 * N);
+}
+
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N, fft::complex_number C>
+static inline void
+compute_gram_matrix(
+  const C* const __restrict B, // 2 x 2 x N complex numbers
+  C* const __restrict G        // 2 x 2 x N complex numbers
+  )
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  C ws[5 * N];
+  compute_gram_matrix<N>(B, G, ws);
+}
+
 // Given two degree N polynomials f, g s.t. f is invertible mod q ( = 12289 ),
 // this routine computes h = gf^-1 mod q, which is the Falcon public key,
 // following step 9 of algorithm 4 of Falcon specification
@@ -68,13 +96,15 @@ template<const size_t N>
 static inline void
 compute_public_key(const int32_t* const __restrict f,
                    const int32_t* const __restrict g,
-                   ff::ff_t* const __restrict h)
+                   ff::ff_t* const __restrict h,
+                   ff::ff_t* const __restrict ws // 2 * N elements
+                   )
   requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
 {
   constexpr int32_t q = ff::Q;
 
-  ff::ff_t f_[N];
-  ff::ff_t g_[N];
+  ff::ff_t* const f_ = ws;
+  ff::ff_t* const g_ = ws + N;
 
   // Input polynomials f, g has its coefficients ∈ [-6145, 6143], but for
   // performing division in NTT domain, we need to convert them into [0, 12289)
@@ -89,6 +119,37 @@ compute_public_key(const int32_t* const __restrict f,
   ntt::intt<log2<N>()>(h);
 }
 
+// Same as above, but keeps required workspace on the stack.
+template<const size_t N>
+static inline void
+compute_public_key(const int32_t* const __restrict f,
+                   const int32_t* const __restrict g,
+                   ff::ff_t* const __restrict h)
+  requires((N > 1) && ((N & (N - 1)) == 0) && (N <= 1024))
+{
+  ff::ff_t ws[2 * N];
+  compute_public_key<N>(f, g, h, ws);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `keygen`, which keeps f, g, F, G and Gram matrix of B in
+// scratch buffer, while rest of it is reused by each step of key generation,
+// including NTRU equation solving.
+template<const size_t N>
+static inline constexpr size_t
+keygen_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t fgFG = 4 * scratch::bytes<int32_t>(N);
+  constexpr size_t gram = scratch::bytes<fft::cmplx>(2 * 2 * N);
+  constexpr size_t shared = std::max({ ntru_gen::ntru_gen_scratch_bytes<N>(),
+                                       gram_matrix_scratch_bytes<N>(),
+                                       falcon_tree::ffldl_scratch_bytes<N>(),
+                                       scratch::bytes<ff::ff_t>(2 * N) });
+
+  return fgFG + gram + shared;
+}
+
 // Falcon{512, 1024} key generation algorithm i.e. an implementation of
 // algorithm 4 of Falcon specification which takes only standard deviation σ as
 // input ( see table 3.3 of Falcon specification for possible values that it can
@@ -97,21 +158,42 @@ compute_public_key(const int32_t* const __restrict f,
 // 12289 ).
 //
 // Note, B and T are part of Falcon secret key, while h is Falcon public key.
-template<const size_t N>
+// Falcon tree T is laid out following memory layout L, see
+// `falcon_tree::layout_t`.
+//
+// All fixed precision temporaries live in caller-provided scratch buffer, which
+// must be aligned to `scratch::ALIGNMENT` and span `keygen_scratch_bytes<N>()`
+// -bytes. Only exception is NTRU equation solving ( see `ntru_gen::ntru_gen` ),
+// which keeps polynomials with arbitrary precision coefficients as
+// `std::array`s of `mpz_class` on the stack, with limbs on the heap, managed by
+// GMP. So key generation still requires a sizable stack, making it unfit for
+// small, fixed-size stacks, such as those of fibers.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
 static inline void
 keygen(fft::cmplx* const __restrict B, // FFT form of [[g, -f], [G, -F]]
        fft::cmplx* const __restrict T, // Falcon Tree
        ff::ff_t* const __restrict h,   // Falcon Public Key
        const double σ, // Standard deviation ( see table 3.3 of specification )
-       prng::prng_t& rng)
+       prng::prng_t& rng,
+       uint8_t* const __restrict scratch // see `keygen_scratch_bytes`
+       )
   requires((N == 512) || (N == 1024))
 {
-  int32_t f[N];
-  int32_t g[N];
-  int32_t F[N];
-  int32_t G[N];
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  int32_t* const f = scratch::take<int32_t>(buf, N);
+  int32_t* const g = scratch::take<int32_t>(buf, N);
+  int32_t* const F = scratch::take<int32_t>(buf, N);
+  int32_t* const G = scratch::take<int32_t>(buf, N);
+  fft::cmplx* const gram_matrix = scratch::take<fft::cmplx>(buf, 2 * 2 * N);
 
-  ntru_gen::ntru_gen<N>(f, g, F, G, rng);
+  // rest of the scratch buffer is reused by each of following steps
+  fft::cmplx* const ws = reinterpret_cast<fft::cmplx*>(buf);
+
+  ntru_gen::ntru_gen<N>(f, g, F, G, rng, buf);
 
   for (size_t i = 0; i < N; i++) {
     B[i] = fft::cmplx{ static_cast<double>(g[i]) };
@@ -125,13 +207,27 @@ keygen(fft::cmplx* const __restrict B, // FFT form of [[g, -f], [G, -F]]
   fft::fft<log2<N>()>(B + 2 * N);
   fft::fft<log2<N>()>(B + 3 * N);
 
-  fft::cmplx gram_matrix[2 * 2 * N];
-  compute_gram_matrix<N>(B, gram_matrix);
+  compute_gram_matrix<N>(B, gram_matrix, ws);
+
+  falcon_tree::ffldl<N, 0, log2<N>(), L>(gram_matrix, T, ws);
+  falcon_tree::normalize_tree<N, 0, log2<N>(), L>(T, σ);
 
-  falcon_tree::ffldl<N, 0, log2<N>()>(gram_matrix, T);
-  falcon_tree::normalize_tree<N, 0, log2<N>()>(T, σ);
+  compute_public_key<N>(f, g, h, reinterpret_cast<ff::ff_t*>(buf));
+}
 
-  compute_public_key<N>(f, g, h);
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+keygen(fft::cmplx* const __restrict B, // FFT form of [[g, -f], [G, -F]]
+       fft::cmplx* const __restrict T, // Falcon Tree
+       ff::ff_t* const __restrict h,   // Falcon Public Key
+       const double σ, // Standard deviation ( see table 3.3 of specification )
+       prng::prng_t& rng)
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[keygen_scratch_bytes<N>()];
+  keygen<N, L>(B, T, h, σ, rng, buf);
 }
 
 }
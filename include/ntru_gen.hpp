@@ -3,6 +3,9 @@
 #include "polynomial.hpp"
 #include "prng.hpp"
 #include "samplerz.hpp"
+#include "scratch.hpp"
+#include <algorithm>
+#include <cassert>
 
 // Generate f, g, F, G ∈ Z[x]/(φ) | fG − gF = q mod φ ( i.e. NTRU equation )
 namespace ntru_gen {
@@ -41,15 +44,16 @@ gen_poly(int32_t* const poly, prng::prng_t& rng)
 // Given a polynomial of degree (n - 1) | n ∈ {512, 1024}, this routine checks
 // whether it can be inverted by computing NTT representation of polynomial and
 // ensuring none of the coefficients, in NTT representation, are zero.
+//
+// Workspace `tmp` must have space for N elements.
 template<const size_t LOG2N>
 static inline bool
-is_poly_invertible(const int32_t* const poly)
+is_poly_invertible(const int32_t* const __restrict poly,
+                   ff::ff_t* const __restrict tmp)
 {
   constexpr size_t N = 1ul << LOG2N;
   constexpr int32_t q = ff::Q;
 
-  ff::ff_t tmp[N];
-
   for (size_t i = 0; i < N; i++) {
     const bool flg = poly[i] < 0;
     tmp[i].v = static_cast<uint16_t>(flg * q + poly[i]);
@@ -87,19 +91,30 @@ sqrd_norm(const double* const poly)
 // representation, this routine computes squared norm using formula 3.8, as
 // described on top of page 24 of the Falcon specification
 // https://falcon-sign.info/falcon.pdf
-template<const size_t LOG2N>
-static inline double
-sqrd_norm(const fft::cmplx* const poly)
+template<const size_t LOG2N, fft::complex_number C>
+static inline fft::real_t<C>
+sqrd_norm(const C* const poly)
 {
   constexpr size_t N = 1ul << LOG2N;
-  constexpr double N_ = static_cast<double>(N);
-  fft::cmplx res{};
+  constexpr fft::real_t<C> N_ = static_cast<double>(N);
+  C res{};
 
   for (size_t i = 0; i < N; i++) {
-    res += poly[i] * std::conj(poly[i]);
+    res += poly[i] * conj(poly[i]);
   }
 
-  return std::real(res) / N_;
+  return res.real() / N_;
+}
+
+// Compile-time compute how many bytes of scratch space are required by
+// `gram_schmidt_norm`, which keeps f, g ( as doubles ) and nine intermediate
+// polynomials in FFT form.
+template<const size_t LOG2N>
+static inline constexpr size_t
+gram_schmidt_norm_scratch_bytes()
+{
+  constexpr size_t N = 1ul << LOG2N;
+  return 2 * scratch::bytes<double>(N) + 9 * scratch::bytes<fft::cmplx>(N);
 }
 
 // Computes squared Gram-Schmidt norm of NTRU matrix generated using random
@@ -107,17 +122,26 @@ sqrd_norm(const fft::cmplx* const poly)
 //
 // This routine does what line 9 of algorithm 5 in the Falcon specification (
 // https://falcon-sign.info/falcon.pdf ) does.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span
+// `gram_schmidt_norm_scratch_bytes<LOG2N>()` -bytes.
 template<const size_t LOG2N>
 static inline double
 gram_schmidt_norm(const int32_t* const __restrict f,
-                  const int32_t* const __restrict g)
+                  const int32_t* const __restrict g,
+                  uint8_t* const __restrict scratch)
 {
   constexpr size_t N = 1ul << LOG2N;
   constexpr double q = ff::Q;
   constexpr double qxq = q * q;
 
-  double tmp0[N];
-  double tmp1[N];
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  double* const tmp0 = scratch::take<double>(buf, N);
+  double* const tmp1 = scratch::take<double>(buf, N);
 
   for (size_t i = 0; i < N; i++) {
     tmp0[i] = static_cast<double>(f[i]);
@@ -126,8 +150,8 @@ gram_schmidt_norm(const int32_t* const __restrict f,
 
   const auto sq_norm_fg = sqrd_norm<LOG2N>(tmp0) + sqrd_norm<LOG2N>(tmp1);
 
-  fft::cmplx f_[N];
-  fft::cmplx g_[N];
+  fft::cmplx* const f_ = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const g_ = scratch::take<fft::cmplx>(buf, N);
 
   for (size_t i = 0; i < N; i++) {
     f_[i] = fft::cmplx{ tmp0[i] };
@@ -137,26 +161,26 @@ gram_schmidt_norm(const int32_t* const __restrict f,
   fft::fft<LOG2N>(f_);
   fft::fft<LOG2N>(g_);
 
-  fft::cmplx f_adj[N];
-  fft::cmplx g_adj[N];
+  fft::cmplx* const f_adj = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const g_adj = scratch::take<fft::cmplx>(buf, N);
 
-  std::memcpy(f_adj, f_, sizeof(f_));
-  std::memcpy(g_adj, g_, sizeof(g_));
+  std::memcpy(f_adj, f_, sizeof(fft::cmplx) * N);
+  std::memcpy(g_adj, g_, sizeof(fft::cmplx) * N);
 
   fft::adj_poly<LOG2N>(f_adj);
   fft::adj_poly<LOG2N>(g_adj);
 
-  fft::cmplx fxf_adj[N];
-  fft::cmplx gxg_adj[N];
+  fft::cmplx* const fxf_adj = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const gxg_adj = scratch::take<fft::cmplx>(buf, N);
 
   polynomial::mul<LOG2N>(f_, f_adj, fxf_adj);
   polynomial::mul<LOG2N>(g_, g_adj, gxg_adj);
 
-  fft::cmplx fxf_adj_gxg_adj[N];
+  fft::cmplx* const fxf_adj_gxg_adj = scratch::take<fft::cmplx>(buf, N);
   polynomial::add<LOG2N>(fxf_adj, gxg_adj, fxf_adj_gxg_adj);
 
-  fft::cmplx ft[N];
-  fft::cmplx gt[N];
+  fft::cmplx* const ft = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const gt = scratch::take<fft::cmplx>(buf, N);
 
   polynomial::div<LOG2N>(f_adj, fxf_adj_gxg_adj, ft);
   polynomial::div<LOG2N>(g_adj, fxf_adj_gxg_adj, gt);
@@ -324,19 +348,40 @@ min_max(const std::array<mpz_class, N>& arr)
   return { min, max };
 }
 
+// Compile-time compute how many bytes of scratch space are required by
+// `reduce`, when reducing degree N polynomials, which keeps fifteen polynomials
+// in FFT form and rounded coefficients of k. It also suffices for reducing any
+// lower degree polynomials.
+template<const size_t N>
+static inline constexpr size_t
+reduce_scratch_bytes()
+  requires((N > 1) && (N & (N - 1)) == 0)
+{
+  return 15 * scratch::bytes<fft::cmplx>(N) + scratch::bytes<signed long>(N);
+}
+
 // Given four polynomials of degree N, this routine reduces F, G w.r.t. f, g
 // using algorithm 7 of Falcon specification and returns reduced F, G.
 //
 // This implementation collects inspiration from
 // https://github.com/tprest/falcon.py/blob/88d01ed/ntrugen.py#L104-L150
+//
+// All temporaries, other than arbitrary precision integers, live in
+// caller-provided scratch buffer, which must be aligned to `scratch::ALIGNMENT`
+// and span `reduce_scratch_bytes<N>()` -bytes.
 template<const size_t N>
 static inline void
 reduce(const std::array<mpz_class, N>& f,
        const std::array<mpz_class, N>& g,
        std::array<mpz_class, N>& F,
-       std::array<mpz_class, N>& G)
+       std::array<mpz_class, N>& G,
+       uint8_t* const __restrict scratch)
   requires((N > 1) && (N & (N - 1)) == 0)
 {
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
   const std::pair<mpz_class, mpz_class> fmm = min_max(f);
   const std::pair<mpz_class, mpz_class> gmm = min_max(g);
 
@@ -345,10 +390,10 @@ reduce(const std::array<mpz_class, N>& f,
     std::max(std::max(approx_bit_len(fmm.first), approx_bit_len(fmm.second)),
              std::max(approx_bit_len(gmm.first), approx_bit_len(gmm.second))));
 
-  fft::cmplx f_adjust[N];
-  fft::cmplx g_adjust[N];
-  fft::cmplx f_adjoint[N];
-  fft::cmplx g_adjoint[N];
+  fft::cmplx* const f_adjust = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const g_adjust = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const f_adjoint = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const g_adjoint = scratch::take<fft::cmplx>(buf, N);
 
   for (size_t i = 0; i < N; i++) {
     f_adjust[i] = fft::cmplx{ mpz_class(f[i] >> (blen0 - 53ul)).get_d() };
@@ -358,12 +403,26 @@ reduce(const std::array<mpz_class, N>& f,
   fft::fft<log2<N>()>(f_adjust);
   fft::fft<log2<N>()>(g_adjust);
 
-  std::memcpy(f_adjoint, f_adjust, sizeof(f_adjust));
-  std::memcpy(g_adjoint, g_adjust, sizeof(g_adjust));
+  std::memcpy(f_adjoint, f_adjust, sizeof(fft::cmplx) * N);
+  std::memcpy(g_adjoint, g_adjust, sizeof(fft::cmplx) * N);
 
   fft::adj_poly<log2<N>()>(f_adjoint);
   fft::adj_poly<log2<N>()>(g_adjoint);
 
+  // rest of the scratch buffer is reused by each iteration
+  fft::cmplx* const F_adjust = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const G_adjust = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const F_adjoint = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const G_adjoint = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const ff_mul = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const gg_mul = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const Ff_mul = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const Gg_mul = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const ffgg_add = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const FfGg_add = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const k = scratch::take<fft::cmplx>(buf, N);
+  signed long* const k_rounded = scratch::take<signed long>(buf, N);
+
   while (1) {
     const std::pair<mpz_class, mpz_class> Fmm = min_max(F);
     const std::pair<mpz_class, mpz_class> Gmm = min_max(G);
@@ -378,11 +437,6 @@ reduce(const std::array<mpz_class, N>& f,
       break;
     }
 
-    fft::cmplx F_adjust[N];
-    fft::cmplx G_adjust[N];
-    fft::cmplx F_adjoint[N];
-    fft::cmplx G_adjoint[N];
-
     for (size_t i = 0; i < N; i++) {
       F_adjust[i] = fft::cmplx{ mpz_class(F[i] >> (blen1 - 53ul)).get_d() };
       G_adjust[i] = fft::cmplx{ mpz_class(G[i] >> (blen1 - 53ul)).get_d() };
@@ -391,34 +445,23 @@ reduce(const std::array<mpz_class, N>& f,
     fft::fft<log2<N>()>(F_adjust);
     fft::fft<log2<N>()>(G_adjust);
 
-    std::memcpy(F_adjoint, F_adjust, sizeof(F_adjust));
-    std::memcpy(G_adjoint, G_adjust, sizeof(G_adjust));
+    std::memcpy(F_adjoint, F_adjust, sizeof(fft::cmplx) * N);
+    std::memcpy(G_adjoint, G_adjust, sizeof(fft::cmplx) * N);
 
     fft::adj_poly<log2<N>()>(F_adjoint);
     fft::adj_poly<log2<N>()>(G_adjoint);
 
-    fft::cmplx ff_mul[N];
-    fft::cmplx gg_mul[N];
-    fft::cmplx Ff_mul[N];
-    fft::cmplx Gg_mul[N];
-
     polynomial::mul<log2<N>()>(f_adjust, f_adjoint, ff_mul);
     polynomial::mul<log2<N>()>(g_adjust, g_adjoint, gg_mul);
     polynomial::mul<log2<N>()>(F_adjust, f_adjoint, Ff_mul);
     polynomial::mul<log2<N>()>(G_adjust, g_adjoint, Gg_mul);
 
-    fft::cmplx ffgg_add[N];
-    fft::cmplx FfGg_add[N];
-
     polynomial::add<log2<N>()>(ff_mul, gg_mul, ffgg_add);
     polynomial::add<log2<N>()>(Ff_mul, Gg_mul, FfGg_add);
 
-    fft::cmplx k[N];
-
     polynomial::div<log2<N>()>(FfGg_add, ffgg_add, k);
     fft::ifft<log2<N>()>(k);
 
-    signed long k_rounded[N];
     for (size_t i = 0; i < N; i++) {
       k_rounded[i] = static_cast<signed long>(std::round(k[i].real()));
     }
@@ -470,11 +513,17 @@ public:
 // Before consuming two polynomials F, G, consider checking whether it's a valid
 // solution or not, using is_solution() function on returned value of type
 // ntru_solve_status_t.
+//
+// Scratch buffer, used for reducing F, G at each level of recursion, must be
+// aligned to `scratch::ALIGNMENT` and span `reduce_scratch_bytes<N>()` -bytes,
+// when N > 1.
 template<const size_t N>
 static inline std::pair<
   std::pair<std::array<mpz_class, N>, std::array<mpz_class, N>>,
   ntru_solve_status_t>
-ntru_solve(const std::array<mpz_class, N>& f, const std::array<mpz_class, N>& g)
+ntru_solve(const std::array<mpz_class, N>& f,
+           const std::array<mpz_class, N>& g,
+           uint8_t* const __restrict scratch)
   requires((N >= 1) && (N & (N - 1)) == 0)
 {
   if constexpr (N == 1) {
@@ -490,7 +539,7 @@ ntru_solve(const std::array<mpz_class, N>& f, const std::array<mpz_class, N>& g)
     const auto fprime = field_norm(f);
     const auto gprime = field_norm(g);
 
-    const auto ret = ntru_solve(fprime, gprime);
+    const auto ret = ntru_solve(fprime, gprime, scratch);
 
     if (!ret.second.is_solution()) {
       return { {}, ret.second };
@@ -499,33 +548,57 @@ ntru_solve(const std::array<mpz_class, N>& f, const std::array<mpz_class, N>& g)
     auto F = karatsuba::karamul(lift(ret.first.first), galois_conjugate(g));
     auto G = karatsuba::karamul(lift(ret.first.second), galois_conjugate(f));
 
-    reduce(f, g, F, G);
+    reduce(f, g, F, G, scratch);
     return { { F, G }, ntru_solve_status_t{} };
   }
 }
 
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `ntru_gen`, which is reused by each of its steps.
+template<const size_t N>
+static inline constexpr size_t
+ntru_gen_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return std::max({ scratch::bytes<ff::ff_t>(N),
+                    gram_schmidt_norm_scratch_bytes<log2<N>()>(),
+                    reduce_scratch_bytes<N>() });
+}
+
 // Given a modulus q ( = 12289 ), this routine generates four polynomials f, g,
 // F, G ∈ Z[x]/(x^N + 1), solving NTRU equation ( see eq 3.15 of Falcon
 // specification ). This routine is an implementation of algorithm 5 of Falcon
 // specification https://falcon-sign.info/falcon.pdf
+//
+// All fixed precision temporaries live in caller-provided scratch buffer,
+// which must be aligned to `scratch::ALIGNMENT` and span
+// `ntru_gen_scratch_bytes<N>()` -bytes. Polynomials with arbitrary precision
+// coefficients, used for solving NTRU equation, are still kept in `std::array`s
+// of `mpz_class` on the stack, while limbs of those integers live on the heap,
+// managed by GMP.
 template<const size_t N>
 static inline void
 ntru_gen(int32_t* const __restrict f,
          int32_t* const __restrict g,
          int32_t* const __restrict F,
          int32_t* const __restrict G,
-         prng::prng_t& rng)
+         prng::prng_t& rng,
+         uint8_t* const __restrict scratch // see `ntru_gen_scratch_bytes`
+         )
   requires((N == 512) || (N == 1024))
 {
+  assert(scratch::is_aligned(scratch));
+
   while (1) {
     gen_poly<log2<N>()>(f, rng);
     gen_poly<log2<N>()>(g, rng);
 
-    if (!is_poly_invertible<log2<N>()>(f)) {
+    const auto tmp = reinterpret_cast<ff::ff_t*>(scratch);
+    if (!is_poly_invertible<log2<N>()>(f, tmp)) {
       continue;
     }
 
-    const double gsnorm = gram_schmidt_norm<log2<N>()>(f, g);
+    const double gsnorm = gram_schmidt_norm<log2<N>()>(f, g, scratch);
     if (gsnorm > GS_NORM_THRESHOLD) {
       continue;
     }
@@ -538,7 +611,7 @@ ntru_gen(int32_t* const __restrict f,
       g_[i] = mpz_class(g[i]);
     }
 
-    const auto ret = ntru_solve(f_, g_);
+    const auto ret = ntru_solve(f_, g_, scratch);
     if (!ret.second.is_solution()) {
       continue;
     }
@@ -551,4 +624,18 @@ ntru_gen(int32_t* const __restrict f,
   }
 }
 
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N>
+static inline void
+ntru_gen(int32_t* const __restrict f,
+         int32_t* const __restrict g,
+         int32_t* const __restrict F,
+         int32_t* const __restrict G,
+         prng::prng_t& rng)
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[ntru_gen_scratch_bytes<N>()];
+  ntru_gen<N>(f, g, F, G, rng, buf);
+}
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "ff.hpp"
+#include "isa.hpp"
 #include <array>
 
 // (inverse) Number Theoretic Transform for degree-{511, 1023} polynomial, over
@@ -122,31 +123,33 @@ inline void
 ntt(ff::ff_t* const __restrict poly)
   requires(check_log2n(LOG2N))
 {
-  constexpr size_t N = 1ul << LOG2N;
-
-  for (int64_t l = LOG2N - 1; l >= 0; l--) {
-    const size_t len = 1ul << l;
-    const size_t lenx2 = len << 1;
-    const size_t k_beg = N >> (l + 1);
-
-    for (size_t start = 0; start < N; start += lenx2) {
-      const size_t k_now = k_beg + (start >> (l + 1));
-      ff::ff_t ζ_exp{};
-
-      if constexpr (LOG2N == FALCON512_LOG2N) {
-        ζ_exp = POWERS_OF_ζ_512[k_now];
-      } else {
-        ζ_exp = POWERS_OF_ζ_1024[k_now];
-      }
-
-      for (size_t i = start; i < start + len; i++) {
-        const auto tmp = ζ_exp * poly[i + len];
-
-        poly[i + len] = poly[i] - tmp;
-        poly[i] += tmp;
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
+
+    for (int64_t l = LOG2N - 1; l >= 0; l--) {
+      const size_t len = 1ul << l;
+      const size_t lenx2 = len << 1;
+      const size_t k_beg = N >> (l + 1);
+
+      for (size_t start = 0; start < N; start += lenx2) {
+        const size_t k_now = k_beg + (start >> (l + 1));
+        ff::ff_t ζ_exp{};
+
+        if constexpr (LOG2N == FALCON512_LOG2N) {
+          ζ_exp = POWERS_OF_ζ_512[k_now];
+        } else {
+          ζ_exp = POWERS_OF_ζ_1024[k_now];
+        }
+
+        for (size_t i = start; i < start + len; i++) {
+          const auto tmp = ζ_exp * poly[i + len];
+
+          poly[i + len] = poly[i] - tmp;
+          poly[i] += tmp;
+        }
       }
     }
-  }
+  });
 }
 
 // Given {512, 1024} evaluations of polynomial f s.t. each evaluation ∈ Z_q and
@@ -163,40 +166,42 @@ inline void
 intt(ff::ff_t* const __restrict poly)
   requires(check_log2n(LOG2N))
 {
-  constexpr size_t N = 1ul << LOG2N;
-
-  for (size_t l = 0; l < LOG2N; l++) {
-    const size_t len = 1ul << l;
-    const size_t lenx2 = len << 1;
-    const size_t k_beg = (N >> l) - 1;
-
-    for (size_t start = 0; start < N; start += lenx2) {
-      const size_t k_now = k_beg - (start >> (l + 1));
-      ff::ff_t neg_ζ_exp{};
+  isa::dispatch_n<LOG2N>([&] {
+    constexpr size_t N = 1ul << LOG2N;
+
+    for (size_t l = 0; l < LOG2N; l++) {
+      const size_t len = 1ul << l;
+      const size_t lenx2 = len << 1;
+      const size_t k_beg = (N >> l) - 1;
+
+      for (size_t start = 0; start < N; start += lenx2) {
+        const size_t k_now = k_beg - (start >> (l + 1));
+        ff::ff_t neg_ζ_exp{};
+
+        if constexpr (LOG2N == FALCON512_LOG2N) {
+          neg_ζ_exp = NEG_POWERS_OF_ζ_512[k_now];
+        } else {
+          neg_ζ_exp = NEG_POWERS_OF_ζ_1024[k_now];
+        }
+
+        for (size_t i = start; i < start + len; i++) {
+          const auto tmp = poly[i];
+
+          poly[i] += poly[i + len];
+          poly[i + len] = tmp - poly[i + len];
+          poly[i + len] *= neg_ζ_exp;
+        }
+      }
+    }
 
+    for (size_t i = 0; i < N; i++) {
       if constexpr (LOG2N == FALCON512_LOG2N) {
-        neg_ζ_exp = NEG_POWERS_OF_ζ_512[k_now];
+        poly[i] *= INV_FALCON512_N;
       } else {
-        neg_ζ_exp = NEG_POWERS_OF_ζ_1024[k_now];
-      }
-
-      for (size_t i = start; i < start + len; i++) {
-        const auto tmp = poly[i];
-
-        poly[i] += poly[i + len];
-        poly[i + len] = tmp - poly[i + len];
-        poly[i + len] *= neg_ζ_exp;
+        poly[i] *= INV_FALCON1024_N;
       }
     }
-  }
-
-  for (size_t i = 0; i < N; i++) {
-    if constexpr (LOG2N == FALCON512_LOG2N) {
-      poly[i] *= INV_FALCON512_N;
-    } else {
-      poly[i] *= INV_FALCON1024_N;
-    }
-  }
+  });
 }
 
 }
@@ -0,0 +1,420 @@
+#pragma once
+#include "key_store.hpp"
+#include "verification.hpp"
+#include <bit>
+#include <vector>
+
+// Persistent, memory-mappable store of decoded Falcon{512, 1024} public keys,
+// for verifiers holding many public keys
+namespace pkey_store {
+
+// Public key store is a single file, laid out as
+//
+// <64 -bytes header> +
+// <zero padding, till PAGE_SIZE boundary> +
+// <count -many records, each holding public key h as N elements of Z_q> +
+// <slot_cnt -many hash index slots, each of 40 -bytes>
+//
+// s.t. each record starts at 64 -bytes boundary and holds h either in
+// coefficient form ( exactly as `decoding::decode_pkey` returns it ) or in NTT
+// form ( ready to be consumed by `verification::verify_ntt` ), as recorded in
+// header. Hash index is an open addressing table, with linear probing, mapping
+// key id ( see `key_store::key_id` ) to record index, so that looking up a key
+// touches a single cache line of index, in common case, no matter how many
+// keys are stored. Field elements are kept in native byte order.
+constexpr uint8_t MAGIC[8]{ 'F', 'A', 'L', 'C', 'O', 'N', 'P', 'K' };
+constexpr uint32_t VERSION = 1;
+
+using key_store::ENDIANNESS;
+using key_store::ID_LEN;
+using key_store::PAGE_SIZE;
+
+// Form in which public key h is stored.
+enum class form_t : uint32_t
+{
+  COEFF = 0,
+  NTT = 1,
+};
+
+// Marks an unoccupied hash index slot.
+constexpr uint64_t EMPTY = ~0ul;
+
+struct header_t
+{
+  uint8_t magic[8];
+  uint32_t version;
+  uint32_t endianness;
+  uint32_t n;    // Falcon{512, 1024}
+  uint32_t form; // see `form_t`
+  uint64_t count;        // # -of records
+  uint64_t record_bytes; // N * sizeof(ff::ff_t)
+  uint64_t data_offset;  // offset of first record
+  uint64_t index_offset; // offset of first hash index slot
+  uint64_t slot_cnt;     // # -of hash index slots, power of 2
+};
+
+struct slot_t
+{
+  uint8_t key_id[ID_LEN];
+  uint64_t record; // record index or `EMPTY`
+};
+
+static_assert(sizeof(header_t) == 64, "Header must be 64 -bytes !");
+static_assert(sizeof(slot_t) == 40, "Hash index slot must be 40 -bytes !");
+
+// Compile-time compute byte length of a record, holding public key h.
+template<const size_t N>
+static inline constexpr size_t
+record_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<ff::ff_t>(N);
+}
+
+// Home slot of key id, in hash index of `slot_cnt` -many slots. Key ids are
+// SHAKE256 digests, so their leading bytes are already uniformly distributed.
+static inline size_t
+home_slot(const uint8_t* const id, const size_t slot_cnt)
+{
+  uint64_t h;
+  std::memcpy(&h, id, sizeof(h));
+  return static_cast<size_t>(h) & (slot_cnt - 1);
+}
+
+// Computes # -of hash index slots, for `count` -many keys, keeping load factor
+// at max 1/2.
+static inline constexpr size_t
+slot_count(const size_t count)
+{
+  return std::max<size_t>(std::bit_ceil(2 * count), 2);
+}
+
+// Streaming writer of public key store, which writes each record as soon as
+// it's added, keeping only key ids in memory. Hash index and header are written
+// by `finish`.
+//
+// Writer doesn't own file descriptor, caller is responsible for closing it.
+template<const size_t N>
+  requires((N == 512) || (N == 1024))
+class writer_t
+{
+private:
+  int fd;
+  form_t form;
+  bool ok = true;
+  std::vector<slot_t> ids;
+
+public:
+  explicit inline writer_t(const int fd, const form_t form = form_t::NTT)
+    : fd(fd)
+    , form(form)
+  {
+  }
+
+  // Appends a record, holding public key h ( in coefficient form ), identified
+  // by key id.
+  inline bool add(const uint8_t* const __restrict id,
+                  const ff::ff_t* const __restrict h)
+  {
+    alignas(scratch::ALIGNMENT) ff::ff_t rec[N];
+
+    std::memcpy(rec, h, sizeof(rec));
+    if (form == form_t::NTT) {
+      ntt::ntt<log2<N>()>(rec);
+    }
+
+    slot_t slot{};
+    std::memcpy(slot.key_id, id, ID_LEN);
+    slot.record = ids.size();
+
+    const uint64_t off = PAGE_SIZE + slot.record * record_bytes<N>();
+    ok &= key_store::pwrite_all(fd, rec, sizeof(rec), static_cast<off_t>(off));
+
+    ids.push_back(slot);
+    return ok;
+  }
+
+  // Decodes byte encoded public key and appends it, identified by its key id.
+  inline bool add(const uint8_t* const __restrict pkey)
+  {
+    ff::ff_t h[N];
+    uint8_t id[ID_LEN];
+
+    if (!decoding::decode_pkey<N>(pkey, h)) [[unlikely]] {
+      return false;
+    }
+
+    key_store::key_id<N>(pkey, id);
+    return add(id, h);
+  }
+
+  // Builds and writes hash index and header, completing the store. Returns
+  // false if any write failed or same key id was added more than once.
+  inline bool finish()
+  {
+    const size_t slot_cnt = slot_count(ids.size());
+
+    std::vector<slot_t> index(slot_cnt);
+    for (auto& slot : index) {
+      slot.record = EMPTY;
+    }
+
+    for (const auto& slot : ids) {
+      size_t i = home_slot(slot.key_id, slot_cnt);
+
+      while (index[i].record != EMPTY) {
+        ok &= std::memcmp(index[i].key_id, slot.key_id, ID_LEN) != 0;
+        i = (i + 1) & (slot_cnt - 1);
+      }
+
+      index[i] = slot;
+    }
+
+    header_t hdr{};
+    std::memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.version = VERSION;
+    hdr.endianness = ENDIANNESS;
+    hdr.n = N;
+    hdr.form = static_cast<uint32_t>(form);
+    hdr.count = ids.size();
+    hdr.record_bytes = record_bytes<N>();
+    hdr.data_offset = PAGE_SIZE;
+    hdr.index_offset = PAGE_SIZE + ids.size() * record_bytes<N>();
+    hdr.slot_cnt = slot_cnt;
+
+    const size_t ilen = sizeof(slot_t) * slot_cnt;
+    const off_t ioff = static_cast<off_t>(hdr.index_offset);
+
+    ok &= key_store::pwrite_all(fd, index.data(), ilen, ioff);
+    ok &= key_store::pwrite_all(fd, &hdr, sizeof(hdr), 0);
+
+    // zero padding, following header
+    uint8_t pad[PAGE_SIZE - sizeof(hdr)]{};
+    ok &= key_store::pwrite_all(fd, pad, sizeof(pad), sizeof(hdr));
+
+    return ok;
+  }
+};
+
+// Builds public key store at `path`, from `count` -many byte encoded public
+// keys, living one after another, keeping h in requested form. Returns false if
+// any public key can't be decoded or store can't be written.
+template<const size_t N>
+static inline bool
+build(const char* const path,
+      const uint8_t* const __restrict pkeys,
+      const size_t count,
+      const form_t form = form_t::NTT)
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+
+  const int fd = ::open(path, O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  writer_t<N> writer(fd, form);
+
+  bool ok = true;
+  for (size_t i = 0; (i < count) && ok; i++) {
+    ok &= writer.add(pkeys + i * pklen);
+  }
+
+  ok = ok && writer.finish();
+  ok &= ::fsync(fd) == 0;
+  ok &= ::close(fd) == 0;
+
+  return ok;
+}
+
+// Read-only, zero-copy view of public key store, memory mapped from a file (
+// or any other mappable file descriptor ). Opening a store only validates its
+// header, while hash index and records are faulted in, as keys are looked up,
+// so startup cost doesn't grow with # -of stored keys.
+template<const size_t N>
+  requires((N == 512) || (N == 1024))
+class mapped_t
+{
+private:
+  const uint8_t* base = nullptr;
+  size_t len = 0;
+  const header_t* hdr = nullptr;
+  const slot_t* index = nullptr;
+
+  // Checks that mapped bytes hold a well-formed store, touching only header.
+  inline bool validate() const
+  {
+    if (len < PAGE_SIZE) {
+      return false;
+    }
+
+    bool ok = std::memcmp(hdr->magic, MAGIC, sizeof(MAGIC)) == 0;
+    ok &= hdr->version == VERSION;
+    ok &= hdr->endianness == ENDIANNESS;
+    ok &= hdr->n == N;
+    ok &= hdr->form <= static_cast<uint32_t>(form_t::NTT);
+    ok &= hdr->record_bytes == record_bytes<N>();
+    ok &= hdr->data_offset == PAGE_SIZE;
+
+    // bounds are checked s.t. arithmetic can't overflow
+    ok = ok && (hdr->count <= (len - PAGE_SIZE) / record_bytes<N>());
+    ok = ok && (hdr->index_offset == PAGE_SIZE + hdr->count * record_bytes<N>());
+    ok = ok && std::has_single_bit(hdr->slot_cnt) &&
+         (hdr->slot_cnt > hdr->count) &&
+         (hdr->slot_cnt <= (len - hdr->index_offset) / sizeof(slot_t));
+
+    return ok;
+  }
+
+public:
+  inline mapped_t() = default;
+  mapped_t(const mapped_t&) = delete;
+  mapped_t& operator=(const mapped_t&) = delete;
+
+  inline ~mapped_t() { close(); }
+
+  // Maps store, backed by file descriptor, read-only. File descriptor can be
+  // closed as soon as this returns. With `populate` set, all pages are faulted
+  // in, right away. Returns false if store is malformed or can't be mapped.
+  inline bool attach(const int fd, const bool populate = false)
+  {
+    close();
+
+    struct stat st;
+    if ((::fstat(fd, &st) != 0) || (st.st_size < 0)) {
+      return false;
+    }
+
+    len = static_cast<size_t>(st.st_size);
+    if (len < PAGE_SIZE) {
+      len = 0;
+      return false;
+    }
+
+    const int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+    void* const ptr = ::mmap(nullptr, len, PROT_READ, flags, fd, 0);
+    if (ptr == MAP_FAILED) {
+      len = 0;
+      return false;
+    }
+
+    base = static_cast<const uint8_t*>(ptr);
+    hdr = reinterpret_cast<const header_t*>(base);
+
+    if (!validate()) {
+      close();
+      return false;
+    }
+
+    index = reinterpret_cast<const slot_t*>(base + hdr->index_offset);
+    return true;
+  }
+
+  // Opens and maps store, living at `path`, see `attach`.
+  inline bool open(const char* const path, const bool populate = false)
+  {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+
+    const bool ok = attach(fd, populate);
+    ::close(fd);
+
+    return ok;
+  }
+
+  // Unmaps store, if mapped.
+  inline void close()
+  {
+    if (base != nullptr) {
+      ::munmap(const_cast<uint8_t*>(base), len);
+    }
+
+    base = nullptr;
+    len = 0;
+    hdr = nullptr;
+    index = nullptr;
+  }
+
+  // Number of public keys in store.
+  inline size_t size() const { return hdr == nullptr ? 0 : hdr->count; }
+
+  // Form in which public keys are stored.
+  inline form_t form() const { return static_cast<form_t>(hdr->form); }
+
+  // Looks up public key h by key id, returning pointer into the mapping, or
+  // nullptr if key is not found. Returned h is in form, reported by `form`.
+  inline const ff::ff_t* find(const uint8_t* const id) const
+  {
+    if (hdr == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+
+    const size_t slot_cnt = hdr->slot_cnt;
+    size_t i = home_slot(id, slot_cnt);
+
+    // probing is bounded, so that a corrupted index can't loop forever
+    for (size_t probes = 0; probes < slot_cnt; probes++) {
+      const slot_t& slot = index[i];
+
+      if (slot.record == EMPTY) {
+        return nullptr;
+      }
+      if (std::memcmp(slot.key_id, id, ID_LEN) == 0) {
+        if (slot.record >= hdr->count) [[unlikely]] {
+          return nullptr;
+        }
+
+        const size_t off = PAGE_SIZE + slot.record * record_bytes<N>();
+        return reinterpret_cast<const ff::ff_t*>(base + off);
+      }
+
+      i = (i + 1) & (slot_cnt - 1);
+    }
+
+    return nullptr;
+  }
+
+  // Verifies signature over mlen -bytes message, using public key identified
+  // by key id, straight from the mapping. Returns false if key is not found or
+  // signature doesn't verify.
+  //
+  // All temporaries live in caller-provided scratch buffer, which must be
+  // aligned to `scratch::ALIGNMENT` and span
+  // `verification::verify_scratch_bytes<N>()` -bytes.
+  inline bool verify(const uint8_t* const __restrict id,
+                     const uint8_t* const __restrict msg,
+                     const size_t mlen,
+                     const uint8_t* const __restrict sig,
+                     uint8_t* const __restrict scratch) const
+  {
+    constexpr int32_t β2_values[]{ 34034726, 70265242 };
+    constexpr int32_t β2 = β2_values[N == 1024];
+
+    const ff::ff_t* const h = find(id);
+    if (h == nullptr) [[unlikely]] {
+      return false;
+    }
+
+    if (form() == form_t::NTT) [[likely]] {
+      return verification::verify_ntt<N, β2>(h, msg, mlen, sig, scratch);
+    }
+    return verification::verify<N, β2>(h, msg, mlen, sig, scratch);
+  }
+
+  // Same as above, but keeps required scratch space on the stack.
+  inline bool verify(const uint8_t* const __restrict id,
+                     const uint8_t* const __restrict msg,
+                     const size_t mlen,
+                     const uint8_t* const __restrict sig) const
+  {
+    constexpr size_t sclen = verification::verify_scratch_bytes<N>();
+
+    alignas(scratch::ALIGNMENT) uint8_t buf[sclen];
+    return verify(id, msg, mlen, sig, buf);
+  }
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "ff.hpp"
 #include "fft.hpp"
+#include "isa.hpp"
 #include "ntt.hpp"
 
 // Polynomial arithmetic over Falcon Prime Field Z_q | q = 3 * (2 ^ 12) + 1 and
@@ -9,32 +10,35 @@ namespace polynomial {
 
 // Add two degree-{(1 << lg2n) - 1} polynomials in their FFT form, by
 // performing element-wise addition over C
-template<const size_t lg2n>
+template<const size_t lg2n, fft::complex_number C>
 inline void
-add(const fft::cmplx* const __restrict polya,
-    const fft::cmplx* const __restrict polyb,
-    fft::cmplx* const __restrict polyc)
+add(const C* const __restrict polya,
+    const C* const __restrict polyb,
+    C* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] + polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = polya[i] + polyb[i];
+    }
+  });
 }
 
 // Accumulate one degree-{(1 << lg2n) - 1} polynomial into another one ( of same
 // degree ), when both of them are in their FFT form, by performing element-wise
 // addition over C
-template<const size_t lg2n>
+template<const size_t lg2n, fft::complex_number C>
 static inline void
-add_to(fft::cmplx* const __restrict polya,
-       const fft::cmplx* const __restrict polyb)
+add_to(C* const __restrict polya, const C* const __restrict polyb)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polya[i] += polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polya[i] += polyb[i];
+    }
+  });
 }
 
 // Accumulate one degree-{(1 << lg2n) - 1} polynomial into another one ( of same
@@ -44,11 +48,13 @@ template<const size_t lg2n>
 static inline void
 add_to(ff::ff_t* const __restrict polya, const ff::ff_t* const __restrict polyb)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polya[i] += polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polya[i] += polyb[i];
+    }
+  });
 }
 
 // Given a degree N polynomial ( in its NTT form ), this routine performs
@@ -57,41 +63,47 @@ template<const size_t log2n>
 static inline void
 neg(ff::ff_t* const __restrict poly)
 {
-  constexpr size_t n = 1ul << log2n;
+  isa::dispatch_n<log2n>([&] {
+    constexpr size_t n = 1ul << log2n;
 
-  for (size_t i = 0; i < n; i++) {
-    poly[i] = -poly[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      poly[i] = -poly[i];
+    }
+  });
 }
 
 // Subtracts one degree-{(1 << lg2n) - 1} polynomial from another one, when both
 // them are in their FFT form, by performing element-wise subtraction over C
-template<const size_t lg2n>
+template<const size_t lg2n, fft::complex_number C>
 inline void
-sub(const fft::cmplx* const __restrict polya,
-    const fft::cmplx* const __restrict polyb,
-    fft::cmplx* const __restrict polyc)
+sub(const C* const __restrict polya,
+    const C* const __restrict polyb,
+    C* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] - polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = polya[i] - polyb[i];
+    }
+  });
 }
 
 // Multiply two degree-{(1 << lg2n) - 1} polynomials in their FFT form, by
 // performing element-wise multiplication over C
-template<const size_t lg2n>
+template<const size_t lg2n, fft::complex_number C>
 inline void
-mul(const fft::cmplx* const __restrict polya,
-    const fft::cmplx* const __restrict polyb,
-    fft::cmplx* const __restrict polyc)
+mul(const C* const __restrict polya,
+    const C* const __restrict polyb,
+    C* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] * polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = fft::mul(polya[i], polyb[i]);
+    }
+  });
 }
 
 // Multiply two degree-{(1 << lg2n) - 1} polynomials in their NTT form, by
@@ -102,11 +114,13 @@ mul(const ff::ff_t* const __restrict polya,
     const ff::ff_t* const __restrict polyb,
     ff::ff_t* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] * polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = polya[i] * polyb[i];
+    }
+  });
 }
 
 // Divide one degree-{(1 << lg2n) - 1} polynomial by another one, in their NTT
@@ -122,26 +136,30 @@ div(const ff::ff_t* const __restrict polya,
     const ff::ff_t* const __restrict polyb,
     ff::ff_t* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] / polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = polya[i] / polyb[i];
+    }
+  });
 }
 
 // Divide one degree-{(1 << lg2n) - 1} polynomial by another one, in their FFT
 // form, by performing element-wise division over C
-template<const size_t lg2n>
+template<const size_t lg2n, fft::complex_number C>
 inline void
-div(const fft::cmplx* const __restrict polya,
-    const fft::cmplx* const __restrict polyb,
-    fft::cmplx* const __restrict polyc)
+div(const C* const __restrict polya,
+    const C* const __restrict polyb,
+    C* const __restrict polyc)
 {
-  constexpr size_t n = 1ul << lg2n;
+  isa::dispatch_n<lg2n>([&] {
+    constexpr size_t n = 1ul << lg2n;
 
-  for (size_t i = 0; i < n; i++) {
-    polyc[i] = polya[i] / polyb[i];
-  }
+    for (size_t i = 0; i < n; i++) {
+      polyc[i] = polya[i] / polyb[i];
+    }
+  });
 }
 
 }
@@ -1,43 +1,172 @@
 #pragma once
-#include "shake256.hpp"
+#include "forking.hpp"
+#include "scratch.hpp"
+#include "spsc_ring.hpp"
+#include "xof.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <random>
+#include <utility>
+#include <unistd.h>
+
+#if defined __linux__
+#include <sys/random.h>
+#endif
 
 // Pseudo Random Number Generator
 namespace prng {
 
+// Fills `len` -bytes buffer with randomness, sampled from operating system,
+// using getrandom(2) on Linux ( which blocks only till kernel's entropy pool is
+// initialized ) or getentropy(3) on other Unix-like systems. Falls back to
+// drawing 32 -bit words from std::random_device, if neither can be used.
+static inline void
+system_random(uint8_t* const bytes, const size_t len)
+{
+  size_t off = 0;
+
+#if defined __linux__
+  while (off < len) {
+    const ssize_t n = getrandom(bytes + off, len - off, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    off += static_cast<size_t>(n);
+  }
+#elif defined __APPLE__ || defined __FreeBSD__ || defined __OpenBSD__
+  while (off < len) {
+    // getentropy(3) can't fill more than 256 -bytes at once
+    const size_t n = std::min<size_t>(len - off, 256);
+    if (getentropy(bytes + off, n) != 0) {
+      break;
+    }
+
+    off += n;
+  }
+#endif
+
+  if (off < len) [[unlikely]] {
+    std::random_device rd;
+
+    while (off < len) {
+      const uint32_t word = rd();
+      const size_t n = std::min<size_t>(len - off, sizeof(word));
+
+      std::memcpy(bytes + off, &word, n);
+      off += n;
+    }
+  }
+}
+
 // Pseudo Random Number Generator s.t. N (>0) -many random bytes are read from
-// SHAKE256 XoF whose state is obtained by hashing 32 random bytes sampled from
-// uniform uint8_t random number generator distribution, using Mersenne Twister
-// engine, which itself is seeded with system random device ( read more @
-// https://en.cppreference.com/w/cpp/numeric/random/random_device )
+// SHAKE256 XoF whose state is obtained by hashing 32 random bytes, sampled from
+// operating system, see `system_random`.
 //
-// Note, std::random_device's behaviour is implementation defined feature, so
-// this PRNG implementation doesn't guarantee that it'll generate cryptographic
-// secure random bytes in all possible cases.
+// Constructing one costs a system call, which is why convenience APIs, which
+// don't take a PRNG, use PRNG local to calling thread, see `thread_prng`.
 struct prng_t
 {
 private:
-  shake256::shake256<false> state;
+  xof::shake256_t state;
+  spsc_ring::ring_t* ring = nullptr;
 
 public:
   inline prng_t()
   {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<uint8_t> dis{};
-
     uint8_t seed[32];
-    for (size_t i = 0; i < sizeof(seed); i++) {
-      seed[i] = dis(gen);
-    }
+    system_random(seed, sizeof(seed));
+
+    state.absorb(seed, sizeof(seed));
+    state.finalize();
+
+    scratch::secure_wipe(seed, sizeof(seed));
+  }
 
-    state.hash(seed, sizeof(seed));
+  // Deterministic PRNG, whose SHAKE256 state is obtained by hashing `slen`
+  // -bytes seed, so that same seed always produces same stream of bytes. Seed
+  // must carry enough entropy, if PRNG is used for key generation, see
+  // `falcon::keygen_from_seed`.
+  explicit inline prng_t(const uint8_t* const seed, const size_t slen)
+  {
+    state.absorb(seed, slen);
+    state.finalize();
+  }
+
+  // A copy carries SHAKE256 state, but not ring buffer attached to original,
+  // because a ring has a single consumer ( see `attach` ). Moving a PRNG hands
+  // its ring over, detaching it from moved-from PRNG.
+  inline prng_t(const prng_t& other)
+    : state(other.state)
+  {
+  }
+
+  inline prng_t(prng_t&& other) noexcept
+    : state(other.state)
+    , ring(std::exchange(other.ring, nullptr))
+  {
+  }
+
+  inline prng_t& operator=(const prng_t& other)
+  {
+    state = other.state;
+    ring = nullptr;
+    return *this;
   }
 
+  inline prng_t& operator=(prng_t&& other) noexcept
+  {
+    state = other.state;
+    ring = std::exchange(other.ring, nullptr);
+    return *this;
+  }
+
+  // Makes `read` take bytes out of given ring buffer, filled by a background
+  // producer ( see `entropy::producer_t` ), falling back to squeezing own
+  // SHAKE256 state, only when ring doesn't have enough bytes. Passing nullptr
+  // detaches ring. Ring must outlive PRNG, or be detached, and PRNG must be the
+  // only consumer of ring. In a child process, forked after ring was created,
+  // ring never hands out any bytes, see `spsc_ring::ring_t`.
+  //
+  // Note, once a ring is attached, seeded PRNG no longer produces a
+  // deterministic stream of bytes.
+  inline void attach(spsc_ring::ring_t* const r) { ring = r; }
+
   inline void read(uint8_t* const bytes, const size_t len)
   {
+    if ((ring != nullptr) && ring->pop(bytes, len)) [[likely]] {
+      return;
+    }
+
     state.read(bytes, len);
   }
 };
 
+// PRNG local to calling thread, which is seeded once, on first use, and then
+// reused by convenience APIs ( say `falcon::keygen(pkey, skey)` or
+// `falcon::sign(skey, ...)` ), instead of constructing a new one each time.
+//
+// After fork(2), child process reseeds it, on first use, so that parent and
+// child never produce same stream of bytes. Note, this is only done for PRNG
+// returned by this function, any other PRNG, which is alive at the time of
+// fork, is duplicated as is.
+inline prng_t&
+thread_prng()
+{
+  thread_local uint64_t epoch = forking::epoch();
+  thread_local prng_t rng;
+
+  const uint64_t now = forking::count.load(std::memory_order_relaxed);
+  if (now != epoch) [[unlikely]] {
+    rng = prng_t{};
+    epoch = now;
+  }
+
+  return rng;
+}
+
 }
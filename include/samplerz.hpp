@@ -1,9 +1,12 @@
 #pragma once
 #include "common.hpp"
+#include "isa.hpp"
 #include "prng.hpp"
+#include "stats.hpp"
 #include "u72.hpp"
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
 #include <cstring>
 #include <utility>
@@ -222,52 +225,90 @@ top_63_bits(std::pair<uint64_t, uint64_t> v)
 //
 // This is an implementation of algorithm 13, described on page 42 of Falcon
 // specification https://falcon-sign.info/falcon.pdf
+//
+// Real arguments are either double or emulated `fpr::fpr_t`, see
+// `fft::complex_number`.
+//
+// As x, ccs >= 0, floor is taken by truncating conversion to integer, which,
+// unlike `std::floor`, compiler vectorizes, see `samplerz_xn`.
+template<typename R>
 static inline uint64_t
-approx_exp(const double x, const double ccs)
+approx_exp(const R x, const R ccs)
 {
   uint64_t y = C[0];
-  uint64_t z = static_cast<uint64_t>(std::floor(9223372036854775808. * x));
+  uint64_t z = static_cast<uint64_t>(9223372036854775808. * x);
 
+  #pragma GCC unroll 12
   for (size_t u = 1; u < 13; u++) {
     const auto t0 = full_mul_u64(z, y);
     const auto t1 = top_63_bits(t0);
     y = C[u] - t1;
   }
 
-  z = static_cast<uint64_t>(std::floor(9223372036854775808. * ccs));
+  z = static_cast<uint64_t>(9223372036854775808. * ccs);
   const auto t0 = full_mul_u64(z, y);
   y = top_63_bits(t0);
 
   return y;
 }
 
-// Computes a single bit ( = 1 ) with probability ≈ ccs * e^−x | ccs, x >= 0
+// Computes 64 -bit integer z ≈ 2^64 * ccs * e^−x | ccs, x >= 0, against which
+// random bytes are compared, see lines 1 - 3 of algorithm 14, described on page
+// 43 of Falcon specification https://falcon-sign.info/falcon.pdf
 //
-// This is an implementation of algorithm 14, described on page 43 of Falcon
-// specification https://falcon-sign.info/falcon.pdf s.t. 8 uniform random bits
-// are sampled using SHAKE256 based PRNG.
+// As x >= 0, floor is taken by truncating conversion to integer, see
+// `approx_exp`.
+template<typename R>
+static inline uint64_t
+ber_exp_threshold(const R x, const R ccs)
+{
+  const uint64_t s = static_cast<uint64_t>(x * INV_LN2);
+  const R r = x - static_cast<R>(s) * LN2;
+  const uint64_t s_ = std::min<uint64_t>(s, 63ul);
+
+  return (2 * approx_exp(r, ccs) - 1) >> s_;
+}
+
+// Compares uniform random bytes against bytes of z, from most significant one,
+// returning 1, if former is lesser, see lines 4 - 8 of algorithm 14 of Falcon
+// specification. First random byte t0 is supplied by caller, while next ones,
+// needed only when previous ones are equal, are sampled using SHAKE256 based
+// PRNG.
 static inline uint8_t
-ber_exp(const double x, const double ccs, prng::prng_t& rng)
+ber_exp_compare(const uint64_t z, const uint8_t t0, prng::prng_t& rng)
 {
-  const double s = std::floor(x * INV_LN2);
-  const double r = x - s * LN2;
-  const uint64_t s_ = std::min<uint64_t>(static_cast<uint64_t>(s), 63ul);
-  const uint64_t z = (2 * approx_exp(r, ccs) - 1) >> s_;
+  int64_t i = 56l;
+  int32_t w = static_cast<int32_t>(t0) - static_cast<int32_t>(z >> i);
 
-  int32_t w = 0;
-  int64_t i = 64l;
-  do {
+  while ((w == 0) && (i > 0l)) {
     i = i - 8l;
 
-    uint8_t t0;
-    rng.read(&t0, sizeof(t0));
+    uint8_t t1;
+    rng.read(&t1, sizeof(t1));
 
-    w = static_cast<int32_t>(t0) - static_cast<int32_t>((z >> i) & 0xfful);
-  } while ((w == 0) && (i > 0l));
+    w = static_cast<int32_t>(t1) - static_cast<int32_t>((z >> i) & 0xfful);
+  }
 
   return w < 0;
 }
 
+// Computes a single bit ( = 1 ) with probability ≈ ccs * e^−x | ccs, x >= 0
+//
+// This is an implementation of algorithm 14, described on page 43 of Falcon
+// specification https://falcon-sign.info/falcon.pdf s.t. 8 uniform random bits
+// are sampled using SHAKE256 based PRNG.
+template<typename R>
+static inline uint8_t
+ber_exp(const R x, const R ccs, prng::prng_t& rng)
+{
+  const uint64_t z = ber_exp_threshold(x, ccs);
+
+  uint8_t t0;
+  rng.read(&t0, sizeof(t0));
+
+  return ber_exp_compare(z, t0, rng);
+}
+
 // Computes a single bit ( = 1 ) with probability ≈ ccs * e^−x | ccs, x >= 0
 //
 // This is an implementation of algorithm 14, described on page 43 of Falcon
@@ -309,40 +350,154 @@ ber_exp(const double x,
 // sampled from a distribution very close to D_{Z, μ, σ′}, following algorithm
 // 15 of Falcon specification https://falcon-sign.info/falcon.pdf s.t. all
 // random bits are sampled from a SHAKE256 based PRNG.
+//
+// Real arguments are either double or emulated `fpr::fpr_t`, see
+// `fft::complex_number`.
+template<typename R>
 static inline int32_t
-samplerz(const double μ,
-         const double σ_prime,
-         const double σ_min,
-         prng::prng_t& rng)
+samplerz(const R μ, const R σ_prime, const R σ_min, prng::prng_t& rng)
 {
-  const double r = μ - std::floor(μ);
-  const double ccs = σ_min / σ_prime;
+  return isa::dispatch([&] {
+    using std::floor;
 
-  const double t0 = 1. / (2. * σ_prime * σ_prime);
-  constexpr double t1 = 1. / (2. * σ_max * σ_max);
+    const R r = μ - floor(μ);
+    const R ccs = σ_min / σ_prime;
 
-  while (true) {
-    const auto z0 = static_cast<int32_t>(base_sampler(rng));
+    const R t0 = 1. / (2. * σ_prime * σ_prime);
+    constexpr double t1 = 1. / (2. * σ_max * σ_max);
 
-    uint8_t v;
-    rng.read(&v, sizeof(v));
+    stats::add(&stats::counters_t::samplerz_calls);
 
-    const auto b = v & 0b1;
-    const auto z = static_cast<double>(b + (2 * b - 1) * z0);
+    while (true) {
+      const auto z0 = static_cast<int32_t>(base_sampler(rng));
 
-    const auto t2 = z - r;
-    const auto t3 = t2 * t2;
-    const auto t4 = t3 * t0;
+      uint8_t v;
+      rng.read(&v, sizeof(v));
 
-    const auto t5 = static_cast<double>(z0 * z0);
-    const auto t6 = t5 * t1;
+      const auto b = v & 0b1;
+      const auto z = static_cast<R>(b + (2 * b - 1) * z0);
 
-    const auto x = t4 - t6;
-    const auto t7 = ber_exp(x, ccs, rng);
-    if (t7 == 1) {
-      return static_cast<int32_t>(z + std::floor(μ));
+      const auto t2 = z - r;
+      const auto t3 = t2 * t2;
+      const auto t4 = t3 * t0;
+
+      const auto t5 = static_cast<R>(z0 * z0);
+      const auto t6 = t5 * t1;
+
+      const auto x = t4 - t6;
+      const auto t7 = ber_exp(x, ccs, rng);
+      if (t7 == 1) {
+        return static_cast<int32_t>(z + floor(μ));
+      }
+
+      stats::add(&stats::counters_t::samplerz_rejects);
     }
-  }
+  });
+}
+
+// Lane-batched SamplerZ, which samples W integers at once, one per lane w, from
+// a distribution very close to D_{Z, μ[w], σ′}, using lane's own PRNG i.e.
+// rngs[w]. Lanes not set in `active` bitmask don't sample at all, leaving their
+// PRNG untouched, while z[w] is set to 0.
+//
+// Rejection loop goes around for all lanes, which are still pending, together.
+// Random bytes are read lane by lane, while everything in between i.e.
+// BaseSampler's table lookup and computing BerExp's threshold, out of
+// candidate and μ, is done for all lanes, in one branch-free loop, which
+// compiler vectorizes. As each lane reads same bytes, in same order, from its
+// PRNG, as `samplerz` does, it samples same integer as `samplerz` would.
+template<const size_t W>
+static inline void
+samplerz_xn(const double* const __restrict μ,
+            const double σ_prime,
+            const double σ_min,
+            prng::prng_t* const __restrict rngs,
+            const uint32_t active,
+            int32_t* const __restrict z)
+  requires((W > 0) && (W <= 32))
+{
+  isa::dispatch([&] {
+    const double ccs = σ_min / σ_prime;
+
+    const double t0 = 1. / (2. * σ_prime * σ_prime);
+    constexpr double t1 = 1. / (2. * σ_max * σ_max);
+
+    double fl[W]{};
+    double r[W]{};
+    u72::u72_t u[W]{};
+    int32_t b[W]{};
+    uint8_t r0[W]{};
+    int32_t zc[W];
+    uint64_t thr[W];
+
+    for (size_t w = 0; w < W; w++) {
+      z[w] = 0;
+
+      if ((active >> w) & 1u) {
+        fl[w] = std::floor(μ[w]);
+        r[w] = μ[w] - fl[w];
+      }
+    }
+
+    const uint32_t lanes = active & static_cast<uint32_t>((1ul << W) - 1ul);
+    stats::add(&stats::counters_t::samplerz_calls,
+               static_cast<uint64_t>(std::popcount(lanes)));
+
+    uint32_t pending = active;
+
+    while (pending != 0) {
+      for (size_t w = 0; w < W; w++) {
+        if (((pending >> w) & 1u) == 0) {
+          continue;
+        }
+
+        // 9 bytes of BaseSampler, 1 byte for sign of candidate and first byte,
+        // BerExp compares, are read in one go
+        uint8_t bytes[11];
+        rngs[w].read(bytes, sizeof(bytes));
+
+        std::array<uint8_t, 9> ubytes;
+        std::memcpy(ubytes.data(), bytes, ubytes.size());
+
+        u[w] = u72::u72_t::from_le_bytes(std::move(ubytes));
+        b[w] = bytes[9] & 0b1;
+        r0[w] = bytes[10];
+      }
+
+      for (size_t w = 0; w < W; w++) {
+        int32_t z0 = 0;
+
+        #pragma GCC unroll 18
+        for (size_t i = 0; i < 18; i++) {
+          z0 = z0 + 1 * (u[w] < RCDT[i]);
+        }
+
+        zc[w] = b[w] + (2 * b[w] - 1) * z0;
+
+        const auto t2 = static_cast<double>(zc[w]) - r[w];
+        const auto t3 = t2 * t2;
+        const auto t4 = t3 * t0;
+
+        const auto t5 = static_cast<double>(z0 * z0);
+        const auto t6 = t5 * t1;
+
+        thr[w] = ber_exp_threshold(t4 - t6, ccs);
+      }
+
+      for (size_t w = 0; w < W; w++) {
+        if (((pending >> w) & 1u) == 0) {
+          continue;
+        }
+
+        if (ber_exp_compare(thr[w], r0[w], rngs[w]) == 1) {
+          z[w] = static_cast<int32_t>(static_cast<double>(zc[w]) + fl[w]);
+          pending &= ~(1u << w);
+        } else {
+          stats::add(&stats::counters_t::samplerz_rejects);
+        }
+      }
+    }
+  });
 }
 
 // Given floating point arguments μ, σ' | σ' ∈ [σ_min, σ_max], integer z ∈ Z,
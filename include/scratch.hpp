@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Caller supplied scratch memory, used by Falcon{512, 1024} routines, which
+// otherwise keep large arrays on the stack
+namespace scratch {
+
+// Scratch buffer handed over to any routine must start at 64 -bytes boundary
+// and so does every region carved out of it.
+constexpr size_t ALIGNMENT = 64;
+
+// Compile-time compute how many bytes are taken by `cnt` -many elements of type
+// T, when carved out of scratch buffer, rounded up to multiple of ALIGNMENT.
+template<typename T>
+static inline constexpr size_t
+bytes(const size_t cnt)
+{
+  return ((sizeof(T) * cnt + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+}
+
+// Carves out a region of `cnt` -many elements of type T from the front of
+// scratch buffer, advancing buffer pointer past that region s.t. next region
+// also starts at ALIGNMENT boundary.
+template<typename T>
+static inline T*
+take(uint8_t*& buf, const size_t cnt)
+{
+  T* const region = reinterpret_cast<T*>(buf);
+  buf += bytes<T>(cnt);
+  return region;
+}
+
+// Checks whether given pointer can be used as start of a scratch buffer, which
+// every scratch taking routine asserts, on entry.
+static inline bool
+is_aligned(const void* const ptr)
+{
+  return (reinterpret_cast<uintptr_t>(ptr) & (ALIGNMENT - 1)) == 0;
+}
+
+// Overwrites `len` -bytes, starting at `ptr`, with zeros, s.t. compiler can't
+// elide these stores, even though memory is about to be released. Zeroing is
+// done by plain `memset` ( so that it runs at memory bandwidth, which matters
+// when wiping many expanded keys ), followed by an empty assembly statement,
+// which claims to read wiped memory, keeping those stores alive.
+static inline void
+secure_wipe(void* const ptr, const size_t len)
+{
+  std::memset(ptr, 0, len);
+  asm volatile("" : : "r"(ptr) : "memory");
+}
+
+}
@@ -5,14 +5,229 @@
 #include "ffsampling.hpp"
 #include "fft.hpp"
 #include "hashing.hpp"
+#include "interleaved.hpp"
+#include "keygen.hpp"
 #include "ntru_gen.hpp"
 #include "polynomial.hpp"
 #include "prng.hpp"
+#include "scratch.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
 #include <cstring>
+#include <new>
 
 // Falcon{512, 1024} Signing related Routines
 namespace signing {
 
+// Given hashed point c ( see `hashing::hash_to_point` ) and 2x2 matrix B ( in
+// FFT format, holding Falcon secret key ) s.t. B = [[g, -f], [G, -F]], this
+// routine computes target vector t = (t0, t1) ( in FFT format ), following line
+// 3 of algorithm 10 of falcon specification https://falcon-sign.info/falcon.pdf
+//
+// FFT form of c is kept in caller-provided workspace of N elements.
+template<const size_t N, fft::complex_number C>
+static inline void
+point_to_target(const C* const __restrict B,
+                const ff::ff_t* const __restrict c,
+                C* const __restrict t0,
+                C* const __restrict t1,
+                C* const __restrict c_fft)
+  requires((N == 512) || (N == 1024))
+{
+  for (size_t i = 0; i < N; i++) {
+    c_fft[i] = C{ fft::real_t<C>(c[i].v) };
+  }
+  fft::fft<log2<N>()>(c_fft);
+
+  polynomial::mul<log2<N>()>(c_fft, B + 3 * N, t0);
+  polynomial::mul<log2<N>()>(c_fft, B + N, t1);
+
+  constexpr C q{ fft::real_t<C>(ff::Q) };
+  for (size_t i = 0; i < N; i++) {
+    t0[i] /= q;
+    t1[i] = -(t1[i] / q);
+  }
+}
+
+// Given mlen -bytes message M, 40 -bytes salt and 2x2 matrix B ( in FFT format,
+// holding Falcon secret key ) s.t. B = [[g, -f], [G, -F]], this routine hashes
+// salt and message to a point c and computes target vector t = (t0, t1) ( in
+// FFT format ), following line 2, 3 of algorithm 10 of falcon specification
+// https://falcon-sign.info/falcon.pdf
+//
+// Hashed point c and its FFT form are kept in caller-provided workspace, each
+// of N elements.
+template<const size_t N, fft::complex_number C>
+static inline void
+compute_target(const C* const __restrict B,
+               const uint8_t* const __restrict salt,
+               const uint8_t* const __restrict msg,
+               const size_t mlen,
+               C* const __restrict t0,
+               C* const __restrict t1,
+               ff::ff_t* const __restrict c,
+               C* const __restrict c_fft)
+  requires((N == 512) || (N == 1024))
+{
+  hashing::hash_to_point<N>(salt, 40, msg, mlen, c);
+  point_to_target<N>(B, c, t0, t1, c_fft);
+}
+
+// Given target vector t = (t0, t1), sampled vector z = (z0, z1) ( both in FFT
+// format ) and 2x2 matrix B = [[g, -f], [G, -F]] ( in FFT format ), this routine
+// computes s = (t - z)B, checks whether its squared norm is within bound β2 and
+// if so, attempts to compress s2, following line 7 - 11 of algorithm 10 of
+// falcon specification https://falcon-sign.info/falcon.pdf
+//
+// Returns truth value only when signature has been compressed into sig, in
+// which case caller is still responsible for filling header and salt bytes.
+//
+// Intermediate polynomials live in caller-provided workspace `ws`, which must
+// be able to hold 5 * N complex numbers, while rounded s2 is written to `s2`,
+// though only partially, when compression fails.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         fft::complex_number C>
+static inline bool
+finalize_sig(const C* const __restrict B,
+             const C* const __restrict t0,
+             const C* const __restrict t1,
+             const C* const __restrict z0,
+             const C* const __restrict z1,
+             uint8_t* const __restrict sig,
+             C* const __restrict ws,
+             int32_t* const __restrict s2)
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
+{
+  constexpr fft::real_t<C> β2_ = static_cast<double>(β2);
+
+  C* const tz0 = ws;
+  C* const tz1 = ws + N;
+  C* const s0 = ws + 2 * N;
+  C* const s1 = ws + 3 * N;
+  C* const tmp = ws + 4 * N;
+
+  // compute tz = (tz0, tz1) = (t0 - z0, t1 - z1)
+  polynomial::sub<log2<N>()>(t0, z0, tz0);
+  polynomial::sub<log2<N>()>(t1, z1, tz1);
+
+  // compute s = (s0, s1) = tz * B | tz is 1x2 and B = 2x2 ( of dimension )
+  polynomial::mul<log2<N>()>(tz0, B, s0);
+  polynomial::mul<log2<N>()>(tz1, B + 2 * N, tmp);
+  polynomial::add_to<log2<N>()>(s0, tmp);
+
+  polynomial::mul<log2<N>()>(tz0, B + N, s1);
+  polynomial::mul<log2<N>()>(tz1, B + 3 * N, tmp);
+  polynomial::add_to<log2<N>()>(s1, tmp);
+
+  // compute (∥s0, s1∥) ^ 2
+  const auto sq_norm0 = ntru_gen::sqrd_norm<log2<N>()>(s0);
+  const auto sq_norm1 = ntru_gen::sqrd_norm<log2<N>()>(s1);
+  const auto sq_norm = sq_norm0 + sq_norm1;
+
+  // check ∥s∥2 > ⌊β2⌋
+  if (sq_norm > β2_) {
+    stats::add(&stats::counters_t::norm_rejects);
+    return false;
+  }
+
+  fft::ifft<log2<N>()>(s1);
+
+  // round s1 into s2, while compressing it, and check if signature has been
+  // compressed
+  const bool compressed = encoding::compress_sig<N, slen>(s1, sig, s2);
+  stats::add(&stats::counters_t::compress_rejects, !compressed);
+
+  return compressed;
+}
+
+// Compile-time compute how many bytes of scratch space are required by
+// `sign_hashed`, which keeps rounded s2, target vector t = (t0, t1), sampled
+// vector z = (z0, z1) and a workspace, shared by all steps of signing, which
+// must be able to hold `ws_len` complex numbers.
+template<const size_t N, const size_t ws_len = 5 * N>
+static inline constexpr size_t
+sign_hashed_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<int32_t>(N) + 4 * scratch::bytes<fft::cmplx>(N) +
+         scratch::bytes<fft::cmplx>(std::max(ws_len, 5 * N));
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `sign`, which, on top of what `sign_hashed` requires, keeps
+// hashed point c.
+template<const size_t N, const size_t ws_len = 5 * N>
+static inline constexpr size_t
+sign_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<ff::ff_t>(N) + sign_hashed_scratch_bytes<N, ws_len>();
+}
+
+// Given 2x2 matrix B ( in FFT format, holding Falcon secret key ) s.t. B = [[g,
+// -f], [G, -F]], falcon tree T ( in FFT format ), 40 -bytes salt and point c,
+// to which salt and message are already hashed, this routine computes
+// compressed signature, following line 3 - 12 of algorithm 10 of falcon
+// specification https://falcon-sign.info/falcon.pdf
+//
+// This is what `sign` does, after hashing message, split out, so that message
+// can also be hashed incrementally, see streaming.hpp.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `sign_hashed_scratch_bytes<N>()`
+// -bytes.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+sign_hashed(const C* const __restrict B,
+            const C* const __restrict T,
+            const uint8_t* const __restrict salt,
+            const ff::ff_t* const __restrict c,
+            uint8_t* const __restrict sig,
+            const fft::real_t<C> σ_min, // see table 3.3 of falcon specification
+            prng::prng_t& rng,
+            uint8_t* const __restrict scratch // see `sign_hashed_scratch_bytes`
+            )
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
+{
+  constexpr uint8_t header = 0x30 | static_cast<uint8_t>(log2<N>());
+
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  int32_t* const s2 = scratch::take<int32_t>(buf, N);
+  C* const t0 = scratch::take<C>(buf, N);
+  C* const t1 = scratch::take<C>(buf, N);
+  C* const z0 = scratch::take<C>(buf, N);
+  C* const z1 = scratch::take<C>(buf, N);
+  C* const ws = reinterpret_cast<C*>(buf);
+
+  point_to_target<N>(B, c, t0, t1, ws);
+
+  while (1) {
+    // ffSampling i.e. compute z = (z0, z1), same as line 6 of algo 10
+    ffsampling::ff_sampling_inplace<N, 0, log2<N>(), L>(
+      t0, t1, T, σ_min, z0, z1, ws, rng);
+
+    if (finalize_sig<N, β2, slen>(B, t0, t1, z0, z1, sig, ws, s2)) {
+      break;
+    }
+  }
+
+  sig[0] = header;
+  std::memcpy(sig + 1, salt, 40);
+}
+
 // Given mlen -bytes message M, 2x2 matrix B ( in FFT format, holding Falcon
 // secret key ) s.t. B = [[g, -f], [G, -F]] and falcon tree T ( in FFT format ),
 // this routine attempts to sign message M, while sampling 40 -bytes random
@@ -27,94 +242,324 @@ namespace signing {
 // This routine is an implementation of algorithm 10 of falcon specification
 // https://falcon-sign.info/falcon.pdf s.t. it takes secret key ( as 2x2 matrix
 // B ) and precomputed falcon tree as input.
-template<const size_t N, const int32_t β2, const size_t slen>
+//
+// Falcon tree T is expected to be laid out following memory layout L, see
+// `falcon_tree::layout_t`.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `sign_scratch_bytes<N>()` -bytes.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
 static inline void
-sign(const fft::cmplx* const __restrict B,
-     const fft::cmplx* const __restrict T,
+sign(const C* const __restrict B,
+     const C* const __restrict T,
      const uint8_t* const __restrict msg,
      const size_t mlen,
      uint8_t* const __restrict sig,
-     const double σ_min, // see table 3.3 of falcon specification
-     prng::prng_t& rng)
+     const fft::real_t<C> σ_min, // see table 3.3 of falcon specification
+     prng::prng_t& rng,
+     uint8_t* const __restrict scratch // see `sign_scratch_bytes`
+     )
   requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
            ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
 {
-  constexpr uint8_t header = 0x30 | static_cast<uint8_t>(log2<N>());
-  constexpr double β2_ = static_cast<double>(β2);
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+  ff::ff_t* const c = scratch::take<ff::ff_t>(buf, N);
 
   uint8_t salt[40];
   rng.read(salt, sizeof(salt));
 
-  ff::ff_t c[N];
   hashing::hash_to_point<N>(salt, sizeof(salt), msg, mlen, c);
+  sign_hashed<N, β2, slen, L>(B, T, salt, c, sig, σ_min, rng, buf);
+}
 
-  fft::cmplx c_fft[N];
-  for (size_t i = 0; i < N; i++) {
-    c_fft[i] = fft::cmplx{ static_cast<double>(c[i].v) };
-  }
-  fft::fft<log2<N>()>(c_fft);
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR,
+         fft::complex_number C>
+static inline void
+sign(const C* const __restrict B,
+     const C* const __restrict T,
+     const uint8_t* const __restrict msg,
+     const size_t mlen,
+     uint8_t* const __restrict sig,
+     const fft::real_t<C> σ_min, // see table 3.3 of falcon specification
+     prng::prng_t& rng)
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[sign_scratch_bytes<N>()];
+  sign<N, β2, slen, L>(B, T, msg, mlen, sig, σ_min, rng, buf);
+}
 
-  fft::cmplx t0[N];
-  fft::cmplx t1[N];
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `sign_xn`, which keeps W hashed points c, on top of what
+// `sign_hashed` requires, along with W lane-interleaved target vectors t = (t0,
+// t1), sampled vectors z = (z0, z1) and workspace of
+// `ffsampling::ff_sampling_xn`.
+template<const size_t N, const size_t W>
+static inline constexpr size_t
+sign_xn_scratch_bytes()
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  return scratch::bytes<ff::ff_t>(N * W) + sign_hashed_scratch_bytes<N>() +
+         4 * scratch::bytes<fft::cmplx>(N * W) +
+         scratch::bytes<fft::cmplx>(2 * N * W);
+}
 
-  polynomial::mul<log2<N>()>(c_fft, B + 3 * N, t0);
-  polynomial::mul<log2<N>()>(c_fft, B + N, t1);
+// Signs W messages, all with same secret key, in lockstep, s.t. ffSampling of
+// all W targets walks Falcon tree T only once, see
+// `ffsampling::ff_sampling_xn`. Message msgs[w] of mlens[w] -bytes is signed
+// using PRNG rngs[w], writing compressed signature to sigs[w].
+//
+// Lanes whose sampled signature doesn't pass norm check or can't be compressed
+// are resampled, while lanes which already have their signature stay idle,
+// consuming no more randomness. That's why, given same PRNG state, signature
+// of each lane is same as what `sign` computes for that message. Salts and
+// messages of all W lanes are hashed at once, see `hashing::hash_to_point_xn`.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `sign_xn_scratch_bytes<N, W>()`
+// -bytes.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const size_t W,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+sign_xn(const fft::cmplx* const __restrict B,
+        const fft::cmplx* const __restrict T,
+        const uint8_t* const* const __restrict msgs,
+        const size_t* const __restrict mlens,
+        uint8_t* const* const __restrict sigs,
+        const double σ_min, // see table 3.3 of falcon specification
+        prng::prng_t* const __restrict rngs,
+        uint8_t* const __restrict scratch // see `sign_xn_scratch_bytes`
+        )
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280))) &&
+          ((W == 4) || (W == 8))
+{
+  constexpr uint8_t header = 0x30 | static_cast<uint8_t>(log2<N>());
 
-  constexpr fft::cmplx q{ ff::Q };
-  for (size_t i = 0; i < N; i++) {
-    t0[i] /= q;
-    t1[i] = -(t1[i] / q);
-  }
+  assert(scratch::is_aligned(scratch));
 
-  fft::cmplx z0[N];
-  fft::cmplx z1[N];
-  fft::cmplx tz0[N];
-  fft::cmplx tz1[N];
-  fft::cmplx s0[N];
-  fft::cmplx s1[N];
-  int32_t s2[N];
-  fft::cmplx tmp[N];
+  uint8_t* buf = scratch;
 
-  while (1) {
-    // ffSampling i.e. compute z = (z0, z1), same as line 6 of algo 10
-    ffsampling::ff_sampling<N, 0, log2<N>()>(t0, t1, T, σ_min, z0, z1, rng);
+  ff::ff_t* const cx = scratch::take<ff::ff_t>(buf, N * W);
+  int32_t* const s2 = scratch::take<int32_t>(buf, N);
+  fft::cmplx* const t0 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const t1 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const z0 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const z1 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const ws = scratch::take<fft::cmplx>(buf, 5 * N);
+  fft::cmplx* const t0x = scratch::take<fft::cmplx>(buf, N * W);
+  fft::cmplx* const t1x = scratch::take<fft::cmplx>(buf, N * W);
+  fft::cmplx* const z0x = scratch::take<fft::cmplx>(buf, N * W);
+  fft::cmplx* const z1x = scratch::take<fft::cmplx>(buf, N * W);
+  fft::cmplx* const tmpx = reinterpret_cast<fft::cmplx*>(buf);
+
+  uint8_t salt[W][40];
+  const uint8_t* salts[W];
+  ff::ff_t* cs[W];
 
-    // compute tz = (tz0, tz1) = (t0 - z0, t1 - z1)
-    polynomial::sub<log2<N>()>(t0, z0, tz0);
-    polynomial::sub<log2<N>()>(t1, z1, tz1);
+  for (size_t w = 0; w < W; w++) {
+    rngs[w].read(salt[w], sizeof(salt[w]));
+
+    salts[w] = salt[w];
+    cs[w] = cx + w * N;
+  }
 
-    // compute s = (s0, s1) = tz * B | tz is 1x2 and B = 2x2 ( of dimension )
-    polynomial::mul<log2<N>()>(tz0, B, s0);
-    polynomial::mul<log2<N>()>(tz1, B + 2 * N, tmp);
-    polynomial::add_to<log2<N>()>(s0, tmp);
+  hashing::hash_to_point_xn<N, W>(salts, sizeof(salt[0]), msgs, mlens, cs);
 
-    polynomial::mul<log2<N>()>(tz0, B + N, s1);
-    polynomial::mul<log2<N>()>(tz1, B + 3 * N, tmp);
-    polynomial::add_to<log2<N>()>(s1, tmp);
+  for (size_t w = 0; w < W; w++) {
+    point_to_target<N>(B, cs[w], t0, t1, ws);
+    interleaved::interleave<N, W>(t0, w, t0x);
+    interleaved::interleave<N, W>(t1, w, t1x);
+  }
 
-    // compute (∥s0, s1∥) ^ 2
-    const double sq_norm0 = ntru_gen::sqrd_norm<log2<N>()>(s0);
-    const double sq_norm1 = ntru_gen::sqrd_norm<log2<N>()>(s1);
-    const double sq_norm = sq_norm0 + sq_norm1;
+  uint32_t active = (1u << W) - 1u;
 
-    // check ∥s∥2 > ⌊β2⌋
-    if (sq_norm <= β2_) {
-      fft::ifft<log2<N>()>(s1);
+  while (active != 0) {
+    // ffSampling of all lanes still waiting for their signature
+    ffsampling::ff_sampling_xn<N, W, 0, log2<N>(), L>(
+      t0x, t1x, T, σ_min, z0x, z1x, tmpx, rngs, active);
 
-      for (size_t i = 0; i < N; i++) {
-        s2[i] = static_cast<int32_t>(std::round(s1[i].real()));
+    for (size_t w = 0; w < W; w++) {
+      if (((active >> w) & 1u) == 0) {
+        continue;
       }
 
-      // check if signature has been compressed
-      const bool compressed = encoding::compress_sig<N, slen>(s2, sig);
-      if (compressed) {
-        break;
+      interleaved::deinterleave<N, W>(t0x, w, t0);
+      interleaved::deinterleave<N, W>(t1x, w, t1);
+      interleaved::deinterleave<N, W>(z0x, w, z0);
+      interleaved::deinterleave<N, W>(z1x, w, z1);
+
+      if (finalize_sig<N, β2, slen>(B, t0, t1, z0, z1, sigs[w], ws, s2)) {
+        sigs[w][0] = header;
+        std::memcpy(sigs[w] + 1, salt[w], sizeof(salt[w]));
+
+        active &= ~(1u << w);
       }
     }
   }
+}
+
+// Same as above, but allocates required scratch space on the heap, as it's too
+// large to be kept on the stack ( ~930 KB, for N = 1024 and W = 8 ), wiping it
+// before it's released. Throws `std::bad_alloc`, if it can't be allocated.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const size_t W,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+static inline void
+sign_xn(const fft::cmplx* const __restrict B,
+        const fft::cmplx* const __restrict T,
+        const uint8_t* const* const __restrict msgs,
+        const size_t* const __restrict mlens,
+        uint8_t* const* const __restrict sigs,
+        const double σ_min, // see table 3.3 of falcon specification
+        prng::prng_t* const __restrict rngs)
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280))) &&
+          ((W == 4) || (W == 8))
+{
+  constexpr size_t sclen = sign_xn_scratch_bytes<N, W>();
+
+  auto buf =
+    static_cast<uint8_t*>(std::aligned_alloc(scratch::ALIGNMENT, sclen));
+  if (buf == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  sign_xn<N, β2, slen, W, L>(B, T, msgs, mlens, sigs, σ_min, rngs, buf);
+
+  scratch::secure_wipe(buf, sclen);
+  std::free(buf);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `sign_dyn`. When CACHED = 0, Gram matrix of root node is
+// recomputed in the workspace, before each attempt of dynamic ffSampling.
+template<const size_t N, const size_t CACHED>
+static inline constexpr size_t
+sign_dyn_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t ws_len = CACHED == 0 ? 2 * 2 * N + 5 * N : 7 * N;
+  return sign_scratch_bytes<N, ws_len>();
+}
+
+// Tree-less ( dynamic ) variant of above signing routine, following `sign_dyn`
+// of Falcon reference implementation, which doesn't require full Falcon tree,
+// rather it takes only top `CACHED` levels of the tree along with Gram matrices
+// of nodes at level `CACHED` ( see `falcon_tree::ffldl_cached` ) and computes
+// rest of the LDL tree on-the-fly, during ffSampling. When CACHED = 0, Tc is
+// not accessed at all and only matrix B is required.
+//
+// Standard deviation σ ( see table 3.3 of falcon specification ) is required
+// for normalizing leaves of the tree. Given same PRNG state, this routine
+// produces same signature as `sign`, when latter uses full Falcon tree.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `sign_dyn_scratch_bytes<N,
+// CACHED>()` -bytes.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const size_t CACHED>
+static inline void
+sign_dyn(const fft::cmplx* const __restrict B,
+         const fft::cmplx* const __restrict Tc,
+         const uint8_t* const __restrict msg,
+         const size_t mlen,
+         uint8_t* const __restrict sig,
+         const double σ,
+         const double σ_min,
+         prng::prng_t& rng,
+         uint8_t* const __restrict scratch // see `sign_dyn_scratch_bytes`
+         )
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
+{
+  constexpr uint8_t header = 0x30 | static_cast<uint8_t>(log2<N>());
+
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  ff::ff_t* const c = scratch::take<ff::ff_t>(buf, N);
+  int32_t* const s2 = scratch::take<int32_t>(buf, N);
+  fft::cmplx* const t0 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const t1 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const z0 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const z1 = scratch::take<fft::cmplx>(buf, N);
+  fft::cmplx* const ws = reinterpret_cast<fft::cmplx*>(buf);
+
+  uint8_t salt[40];
+  rng.read(salt, sizeof(salt));
+
+  compute_target<N>(B, salt, msg, mlen, t0, t1, c, ws);
+
+  while (1) {
+    // ffSampling i.e. compute z = (z0, z1), same as line 6 of algo 10
+    if constexpr (CACHED == 0) {
+      // Gram matrix is destroyed by dynamic ffSampling, recompute it each time
+      keygen::compute_gram_matrix<N>(B, ws, ws + 4 * N);
+      ffsampling::ff_sampling_dyn<N>(t0,
+                                     t1,
+                                     ws,         // g00
+                                     ws + 2 * N, // g10
+                                     ws + 3 * N, // g11
+                                     σ,
+                                     σ_min,
+                                     z0,
+                                     z1,
+                                     ws + 4 * N,
+                                     rng);
+    } else {
+      constexpr size_t Toff = CACHED * N; // Gram matrices follow cached levels
+
+      ffsampling::ff_sampling_cached<N, 0, log2<N>(), CACHED>(
+        t0, t1, Tc, Tc + Toff, σ, σ_min, z0, z1, ws, rng);
+    }
+
+    if (finalize_sig<N, β2, slen>(B, t0, t1, z0, z1, sig, ws, s2)) {
+      break;
+    }
+  }
 
   sig[0] = header;
   std::memcpy(sig + 1, salt, sizeof(salt));
 }
 
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N,
+         const int32_t β2,
+         const size_t slen,
+         const size_t CACHED>
+static inline void
+sign_dyn(const fft::cmplx* const __restrict B,
+         const fft::cmplx* const __restrict Tc,
+         const uint8_t* const __restrict msg,
+         const size_t mlen,
+         uint8_t* const __restrict sig,
+         const double σ,
+         const double σ_min,
+         prng::prng_t& rng)
+  requires(((N == 512) && (β2 == 34034726) && (slen == 666)) ||
+           ((N == 1024) && (β2 == 70265242) && (slen == 1280)))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[sign_dyn_scratch_bytes<N, CACHED>()];
+  sign_dyn<N, β2, slen, CACHED>(B, Tc, msg, mlen, sig, σ, σ_min, rng, buf);
+}
+
 }
@@ -0,0 +1,163 @@
+#pragma once
+#include "forking.hpp"
+#include "scratch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Lock-free, single producer single consumer ring buffer of random bytes
+namespace spsc_ring {
+
+// Ring buffer of bytes, which is written to by exactly one producer thread ( see
+// `fill` ) and read from by exactly one consumer thread ( see `pop` ), without
+// any lock. Producer publishes bytes with release semantics, after they're
+// fully written, so that consumer, which observes them, also observes their
+// content, and vice versa for bytes consumer is done with.
+//
+// Each side caches last seen position of other side, so that shared cache line
+// is touched only when cached position doesn't tell enough, and keeps its own
+// state on a separate cache line, to avoid false sharing.
+//
+// Bytes are wiped out of ring, as soon as they're read, and rest of its content
+// is wiped when it's destroyed.
+//
+// Ring belongs to process which created it. As fork(2) duplicates it, along
+// with bytes it holds, which parent process is yet to consume, ring neither
+// hands out nor takes any bytes in a child process, forked after it was
+// created ( see `forking::epoch` ), where consumer falls back to some other
+// source, as it does when ring runs dry.
+class ring_t
+{
+private:
+  static constexpr size_t CACHE_LINE = 64;
+
+  const size_t cap; // power of 2
+  const uint64_t epoch;
+  std::unique_ptr<uint8_t[]> buf;
+
+  // owned by producer
+  alignas(CACHE_LINE) std::atomic<size_t> head{ 0 }; // bytes written, so far
+  size_t tail_seen = 0;
+
+  // owned by consumer
+  alignas(CACHE_LINE) std::atomic<size_t> tail{ 0 }; // bytes read, so far
+  size_t head_seen = 0;
+  size_t dry_cnt = 0;
+
+public:
+  // Allocates ring of `capacity` -bytes, rounded up to next power of 2.
+  explicit inline ring_t(const size_t capacity)
+    : cap(std::bit_ceil(std::max<size_t>(capacity, 1)))
+    , epoch(forking::epoch())
+    , buf(new uint8_t[cap])
+  {
+  }
+
+  ring_t(const ring_t&) = delete;
+  ring_t& operator=(const ring_t&) = delete;
+
+  inline ~ring_t() { scratch::secure_wipe(buf.get(), cap); }
+
+  // Capacity of ring, in bytes.
+  inline size_t capacity() const { return cap; }
+
+  // Whether calling process was forked after ring was created, in which case
+  // ring is no longer used.
+  inline bool forked() const
+  {
+    return forking::count.load(std::memory_order_relaxed) != epoch;
+  }
+
+  // Number of bytes, ready to be read. Exact only when called by consumer,
+  // while producer is idle, otherwise it's a snapshot.
+  inline size_t available() const
+  {
+    if (forked()) [[unlikely]] {
+      return 0;
+    }
+
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+
+  // Number of `pop` calls, which found ring dry. Must only be called by
+  // consumer.
+  inline size_t dry() const { return dry_cnt; }
+
+  // Producer side: invokes `write(ptr, len)` for at most two contiguous spans of
+  // free space ( as free space may wrap around end of buffer ), each of which
+  // must be fully written, before publishing them to consumer. Returns number
+  // of bytes published, which is 0, when ring is full.
+  template<typename F>
+  inline size_t fill(F&& write)
+  {
+    if (forked()) [[unlikely]] {
+      return 0;
+    }
+
+    const size_t h = head.load(std::memory_order_relaxed);
+
+    size_t free = cap - (h - tail_seen);
+    if (free == 0) {
+      tail_seen = tail.load(std::memory_order_acquire);
+      free = cap - (h - tail_seen);
+
+      if (free == 0) {
+        return 0;
+      }
+    }
+
+    const size_t off = h & (cap - 1);
+    const size_t first = std::min(free, cap - off);
+
+    write(buf.get() + off, first);
+    if (free > first) {
+      write(buf.get(), free - first);
+    }
+
+    head.store(h + free, std::memory_order_release);
+    return free;
+  }
+
+  // Consumer side: copies `len` -bytes out of ring, returning true, if there
+  // are at least that many bytes ready, otherwise nothing is read and false is
+  // returned, so that caller can fall back to some other source. Bytes, which
+  // are read, are wiped out of ring, before their space is handed back to
+  // producer.
+  inline bool pop(uint8_t* const __restrict bytes, const size_t len)
+  {
+    if (forked()) [[unlikely]] {
+      dry_cnt++;
+      return false;
+    }
+
+    const size_t t = tail.load(std::memory_order_relaxed);
+
+    if (head_seen - t < len) [[unlikely]] {
+      head_seen = head.load(std::memory_order_acquire);
+
+      if (head_seen - t < len) {
+        dry_cnt++;
+        return false;
+      }
+    }
+
+    const size_t off = t & (cap - 1);
+    const size_t first = std::min(len, cap - off);
+
+    std::memcpy(bytes, buf.get() + off, first);
+    std::memcpy(bytes + first, buf.get(), len - first);
+
+    scratch::secure_wipe(buf.get() + off, first);
+    scratch::secure_wipe(buf.get(), len - first);
+
+    tail.store(t + len, std::memory_order_release);
+    return true;
+  }
+};
+
+}
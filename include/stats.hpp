@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+
+// Rejection and retry counters of Falcon{512, 1024} signing
+namespace stats {
+
+// How many times signing, on calling thread, had to go around one of its
+// rejection loops, so that benchmarks can report, next to timings, how much
+// of work was spent on rejected samples and signatures.
+struct counters_t
+{
+  uint64_t samplerz_calls = 0;   // integers sampled by `samplerz`
+  uint64_t samplerz_rejects = 0; // candidates rejected by `samplerz`
+  uint64_t norm_rejects = 0;     // signatures whose s = (s1, s2) is too long
+  uint64_t compress_rejects = 0; // signatures whose s2 doesn't compress
+};
+
+// Counting is compiled in, only when `FALCON_STATS` is defined, which benchmark
+// build does ( see Makefile ), so that signing doesn't touch thread local
+// counters, otherwise, while they always read as zero.
+#if defined FALCON_STATS
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Counters of calling thread, which are plain, non-atomic integers, so that
+// counting costs an increment of a thread local variable.
+inline thread_local counters_t counters{};
+
+// Adds `n` to given counter of calling thread, if counting is compiled in.
+static inline void
+add(uint64_t counters_t::*const ctr, const uint64_t n = 1)
+{
+  if constexpr (ENABLED) {
+    counters.*ctr += n;
+  }
+}
+
+// Resets counters of calling thread to zero.
+inline void
+reset()
+{
+  counters = counters_t{};
+}
+
+}
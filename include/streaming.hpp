@@ -0,0 +1,210 @@
+#pragma once
+#include "decoding.hpp"
+#include "falcon.hpp"
+#include "hashing.hpp"
+#include "ntt.hpp"
+#include "prng.hpp"
+#include "scratch.hpp"
+#include "signing.hpp"
+#include "verification.hpp"
+#include "xof.hpp"
+#include <cassert>
+
+// Incremental ( init -> update -> final ) Falcon{512, 1024} signing and
+// verification, for messages which don't fit in memory or arrive in chunks
+namespace streaming {
+
+// Streaming signer, which absorbs message, chunk by chunk, into SHAKE256 XOF
+// state, so that memory use stays constant, no matter how large message is. As
+// salt is hashed before message, it's sampled upfront, during `init`.
+//
+// Given same PRNG state, signature is same as what `falcon::sign` computes for
+// whole message, i.e. init -> update(s) -> final, consumes randomness in same
+// order as `falcon::sign` does. As `final` readies signer for next message, by
+// calling `init`, same holds when signing many messages, one after another.
+//
+// Signer borrows 2x2 matrix B, falcon tree T ( laid out following memory layout
+// L, see `falcon_tree::layout_t` ) and PRNG, all of which must outlive it.
+template<const size_t N,
+         const falcon_tree::layout_t L = falcon_tree::layout_t::LEVEL_MAJOR>
+  requires((N == 512) || (N == 1024))
+class signer_t
+{
+private:
+  static constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  static constexpr size_t slen_values[]{ 666, 1280 };
+  static constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+
+  static constexpr int32_t β2 = β2_values[N == 1024];
+  static constexpr size_t slen = slen_values[N == 1024];
+  static constexpr double σ_min = σ_min_values[N == 1024];
+
+  const fft::cmplx* B;
+  const fft::cmplx* T;
+  prng::prng_t& rng;
+
+  xof::shake256_t hasher{};
+  uint8_t salt[40];
+
+public:
+  // Prepares signer for first message, see `init`.
+  inline signer_t(const fft::cmplx* const B, // [[g, -f], [G, -F]]
+                  const fft::cmplx* const T, // Falcon Tree ( in FFT form )
+                  prng::prng_t& rng)
+    : B(B)
+    , T(T)
+    , rng(rng)
+  {
+    init();
+  }
+
+  // Samples 40 -bytes salt for next message and absorbs it into freshly reset
+  // SHAKE256 state. Called by constructor and by `final`, so that signer is
+  // always ready to absorb next message. Calling it explicitly discards message
+  // absorbed so far, along with its salt.
+  inline void init()
+  {
+    hasher = xof::shake256_t{};
+
+    rng.read(salt, sizeof(salt));
+    hasher.absorb(salt, sizeof(salt));
+  }
+
+  // Absorbs next `len` -bytes chunk of message.
+  inline void update(const uint8_t* const chunk, const size_t len)
+  {
+    hasher.absorb(chunk, len);
+  }
+
+  // Hashes absorbed message to a point and computes its compressed signature,
+  // writing {666, 1280} -bytes to sig, before readying signer for next message,
+  // see `init`.
+  //
+  // All temporaries live in caller-provided scratch buffer, which must be
+  // aligned to `scratch::ALIGNMENT` and span `signing::sign_scratch_bytes<N>()`
+  // -bytes.
+  inline void final(uint8_t* const __restrict sig,
+                    uint8_t* const __restrict scratch)
+  {
+    assert(scratch::is_aligned(scratch));
+
+    uint8_t* buf = scratch;
+    ff::ff_t* const c = scratch::take<ff::ff_t>(buf, N);
+
+    hasher.finalize();
+    hashing::squeeze_to_point<N>(hasher, c);
+
+    signing::sign_hashed<N, β2, slen, L>(B, T, salt, c, sig, σ_min, rng, buf);
+    init();
+  }
+
+  // Same as above, but keeps required scratch space on the stack.
+  inline void final(uint8_t* const __restrict sig)
+  {
+    alignas(scratch::ALIGNMENT) uint8_t buf[signing::sign_scratch_bytes<N>()];
+    final(sig, buf);
+  }
+};
+
+// Streaming verifier, which absorbs message, chunk by chunk, into SHAKE256 XOF
+// state, so that memory use stays constant, no matter how large message is. As
+// salt is hashed before message, it's taken from signature, during `init`.
+//
+// Public key is decoded and forward transformed once, when verifier is
+// constructed, so that same verifier can be reused for checking many
+// signatures, one after another.
+template<const size_t N>
+  requires((N == 512) || (N == 1024))
+class verifier_t
+{
+private:
+  static constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  static constexpr int32_t β2 = β2_values[N == 1024];
+
+  ff::ff_t h[N]; // NTT form
+  int32_t s2[N];
+  bool pkey_ok = false;
+  bool sig_ok = false;
+
+  xof::shake256_t hasher{};
+
+public:
+  // Decodes byte encoded public key, see `ok` for whether it was decoded.
+  explicit inline verifier_t(const uint8_t* const pkey)
+  {
+    pkey_ok = decoding::decode_pkey<N>(pkey, h);
+    if (pkey_ok) [[likely]] {
+      ntt::ntt<log2<N>()>(h);
+    }
+  }
+
+  // Whether public key could be decoded.
+  inline bool ok() const { return pkey_ok; }
+
+  // Decodes {666, 1280} -bytes signature ( which is not accessed afterwards )
+  // and absorbs its salt into freshly reset SHAKE256 state. Returns false if
+  // either public key or signature can't be decoded, in which case `final`
+  // also returns false. Must be called before verifying each signature.
+  inline bool init(const uint8_t* const __restrict sig)
+  {
+    uint8_t salt[40];
+
+    hasher = xof::shake256_t{};
+
+    sig_ok = pkey_ok && decoding::decode_sig<N>(sig, salt, s2);
+    if (sig_ok) [[likely]] {
+      hasher.absorb(salt, sizeof(salt));
+    }
+
+    return sig_ok;
+  }
+
+  // Absorbs next `len` -bytes chunk of message.
+  inline void update(const uint8_t* const chunk, const size_t len)
+  {
+    hasher.absorb(chunk, len);
+  }
+
+  // Hashes absorbed message to a point and checks whether signature, given to
+  // `init`, is valid for it. Returns false, if called again, without calling
+  // `init` in between.
+  //
+  // All temporaries live in caller-provided scratch buffer, which must be
+  // aligned to `scratch::ALIGNMENT` and span `final_scratch_bytes()` -bytes.
+  inline bool final(uint8_t* const scratch)
+  {
+    if (!sig_ok) [[unlikely]] {
+      return false;
+    }
+
+    assert(scratch::is_aligned(scratch));
+
+    uint8_t* buf = scratch;
+    ff::ff_t* const c = scratch::take<ff::ff_t>(buf, N);
+
+    // signature is checked only once, see `init`
+    sig_ok = false;
+
+    hasher.finalize();
+    hashing::squeeze_to_point<N>(hasher, c);
+
+    return verification::verify_hashed<N, β2>(h, s2, c, buf);
+  }
+
+  // Same as above, but keeps required scratch space on the stack.
+  inline bool final()
+  {
+    alignas(scratch::ALIGNMENT) uint8_t buf[final_scratch_bytes()];
+    return final(buf);
+  }
+
+  // Compile-time compute how many bytes of scratch space are required by
+  // scratch taking variant of `final`.
+  static inline constexpr size_t final_scratch_bytes()
+  {
+    return scratch::bytes<ff::ff_t>(N) +
+           verification::verify_hashed_scratch_bytes<N>();
+  }
+};
+
+}
@@ -4,11 +4,13 @@
 #include "encoding.hpp"
 #include "ffsampling.hpp"
 #include "hashing.hpp"
+#include "isa.hpp"
 #include "keygen.hpp"
 #include "prng.hpp"
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 // Test functional correctness of Falcon PQC suite implementation
 namespace test_falcon {
@@ -45,6 +47,106 @@ test_encoding_pkey()
   assert(success);
 }
 
+// Packs n values, as W -bit fields, least significant bit first, one bit at a
+// time, which is how public and secret keys lay out their fixed-width fields.
+static inline void
+pack_bits_lsb(const uint32_t* const __restrict vals,
+              const size_t n,
+              const size_t W,
+              uint8_t* const __restrict out)
+{
+  std::memset(out, 0, (n * W) / 8);
+  for (size_t i = 0; i < n * W; i++) {
+    const uint32_t bit = (vals[i / W] >> (i % W)) & 1u;
+    out[i / 8] |= static_cast<uint8_t>(bit << (i % 8));
+  }
+}
+
+// Test that fixed-width fields of public and secret key, which are packed using
+// BMI2 ( see bitpack.hpp ) or portable code, depending on ISA variant in use,
+// are laid out same as a bit at a time reference packer would, with extreme
+// values of each field, and that they're unpacked back, with either of them.
+template<const size_t N>
+void
+test_encoding_fixed_width()
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t W = N == 512 ? 6 : 5;
+  constexpr int32_t lim = 1 << (W - 1);
+
+  std::vector<ff::ff_t> h(N), h_(N);
+  std::vector<int32_t> f(N), g(N), F(N), f_(N), g_(N), F_(N);
+  std::vector<uint32_t> vals(N);
+  std::vector<uint8_t> pkey(pklen), skey(sklen), expected(sklen);
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < N; i++) {
+    uint32_t v = 0;
+    rng.read(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+
+    h[i].v = static_cast<uint16_t>(v % ff::Q);
+    f[i] = static_cast<int32_t>(v % (2 * lim)) - lim;
+    g[i] = static_cast<int32_t>((v >> 8) % (2 * lim)) - lim;
+    F[i] = static_cast<int32_t>((v >> 16) % 255) - 127;
+  }
+
+  h[0].v = 0;
+  h[N - 1].v = ff::Q - 1;
+  f[0] = -lim;
+  f[N - 1] = lim - 1;
+  g[0] = lim - 1;
+  g[N - 1] = -lim;
+
+  constexpr isa::level_t levels[]{ isa::level_t::SCALAR, isa::level_t::AVX2 };
+  const isa::level_t initial = isa::active();
+
+  bool flg = true;
+
+  for (const isa::level_t lvl : levels) {
+    // skip variants this CPU can't run
+    if (isa::select(lvl) != lvl) {
+      continue;
+    }
+
+    flg &= bitpack::has_bmi2() == (lvl != isa::level_t::SCALAR);
+
+    encoding::encode_pkey<N>(h.data(), pkey.data());
+    for (size_t i = 0; i < N; i++) {
+      vals[i] = h[i].v;
+    }
+    pack_bits_lsb(vals.data(), N, 14, expected.data());
+    flg &= std::memcmp(pkey.data() + 1, expected.data(), pklen - 1) == 0;
+
+    encoding::encode_skey<N>(f.data(), g.data(), F.data(), skey.data());
+    for (size_t i = 0; i < N; i++) {
+      vals[i] = static_cast<uint32_t>(f[i]) & ((1u << W) - 1);
+    }
+    pack_bits_lsb(vals.data(), N, W, expected.data());
+    flg &= std::memcmp(skey.data() + 1, expected.data(), (N * W) / 8) == 0;
+    for (size_t i = 0; i < N; i++) {
+      vals[i] = static_cast<uint32_t>(g[i]) & ((1u << W) - 1);
+    }
+    pack_bits_lsb(vals.data(), N, W, expected.data());
+    flg &= std::memcmp(skey.data() + 1 + (N * W) / 8,
+                       expected.data(),
+                       (N * W) / 8) == 0;
+
+    flg &= decoding::decode_pkey<N>(pkey.data(), h_.data());
+    flg &=
+      decoding::decode_skey<N>(skey.data(), f_.data(), g_.data(), F_.data());
+
+    for (size_t i = 0; i < N; i++) {
+      flg &= h[i] == h_[i];
+      flg &= (f[i] == f_[i]) && (g[i] == g_[i]) && (F[i] == F_[i]);
+    }
+  }
+
+  isa::select(initial);
+
+  assert(flg);
+}
+
 // Test whether randomly generated ( using NTRUGen ) Falcon secret key can be
 // correctly encoded/ decoded or not.
 template<const size_t N>
@@ -267,4 +369,134 @@ test_sig_decompression()
   std::free(s2);
 }
 
+// Compress random polynomials, with coefficients of varying magnitude, s.t.
+// some of them fit in signature and some don't, checking that compressed
+// signature decompresses back to same polynomial, that failed compression
+// leaves signature bytes zeroed and that compressing real coefficients, while
+// rounding them ( as signing does ), produces same signature and rounding.
+template<const size_t N>
+void
+test_sig_compression_bounds()
+{
+  // See table 3.3 of the specification
+  constexpr size_t siglens[]{ 666, 1280 };
+  constexpr size_t siglen = siglens[N == 1024];
+  constexpr uint32_t bounds[]{ 128, 192, 2048, 1u << 14 };
+
+  auto s2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto r2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto dec_s2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto s1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  prng::prng_t rng;
+
+  bool flg = true;
+
+  for (const uint32_t bound : bounds) {
+    for (size_t t = 0; t < 8; t++) {
+      for (size_t i = 0; i < N; i++) {
+        uint32_t v = 0;
+        rng.read(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+
+        const int32_t c = static_cast<int32_t>(v % (2 * bound + 1)) -
+                          static_cast<int32_t>(bound);
+        const double frac = ((v >> 28) & 1) ? 0.375 : -0.375;
+
+        s2[i] = c;
+        s1[i] = fft::cmplx{ static_cast<double>(c) + frac, 0. };
+      }
+
+      std::memset(sig0, 0xff, siglen);
+      std::memset(sig1, 0xff, siglen);
+
+      const bool ok0 = encoding::compress_sig<N, siglen>(s2, sig0);
+      const bool ok1 = encoding::compress_sig<N, siglen>(s1, sig1, r2);
+
+      flg &= ok0 == ok1;
+      flg &= std::memcmp(sig0 + 41, sig1 + 41, siglen - 41) == 0;
+
+      if (ok0) {
+        flg &= std::memcmp(s2, r2, sizeof(int32_t) * N) == 0;
+        flg &= decoding::decompress_sig<N, siglen>(sig0, dec_s2);
+        flg &= std::memcmp(s2, dec_s2, sizeof(int32_t) * N) == 0;
+      } else {
+        for (size_t i = 41; i < siglen; i++) {
+          flg &= sig0[i] == 0;
+        }
+      }
+
+      // small coefficients always fit, large ones never do
+      flg &= (bound != 128) || ok0;
+      flg &= (bound < 2048) || !ok0;
+    }
+  }
+
+  std::free(s2);
+  std::free(r2);
+  std::free(dec_s2);
+  std::free(s1);
+  std::free(sig0);
+  std::free(sig1);
+
+  assert(flg);
+}
+
+// Check that signature decompression accepts only canonical encoding i.e. it
+// rejects 0 encoded with sign bit set, non-zero trailing bits and signatures
+// which run out of bits, while decompressing coefficients with long unary
+// encoded high bits, correctly.
+template<const size_t N>
+void
+test_sig_decompression_canonical()
+{
+  // See table 3.3 of the specification
+  constexpr size_t siglens[]{ 666, 1280 };
+  constexpr size_t siglen = siglens[N == 1024];
+
+  auto s2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto dec_s2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  prng::prng_t rng;
+
+  bool flg = true;
+
+  // small coefficients, except a few large ones, with high bits >= 8
+  for (size_t i = 0; i < N; i++) {
+    uint8_t v = 0;
+    rng.read(&v, sizeof(v));
+    s2[i] = static_cast<int32_t>(v & 0x7f) - 64;
+  }
+  s2[0] = 0;
+  s2[1] = 1500;
+  s2[N - 1] = -2047;
+
+  std::memset(sig, 0, siglen);
+  flg &= encoding::compress_sig<N, siglen>(s2, sig);
+  flg &= decoding::decompress_sig<N, siglen>(sig, dec_s2);
+  flg &= std::memcmp(s2, dec_s2, sizeof(int32_t) * N) == 0;
+
+  // 0 with sign bit set
+  sig[41] ^= 0x80;
+  flg &= !decoding::decompress_sig<N, siglen>(sig, dec_s2);
+  sig[41] ^= 0x80;
+
+  // non-zero trailing bit
+  sig[siglen - 1] ^= 0x01;
+  flg &= !decoding::decompress_sig<N, siglen>(sig, dec_s2);
+  sig[siglen - 1] ^= 0x01;
+
+  flg &= decoding::decompress_sig<N, siglen>(sig, dec_s2);
+
+  // unary code of first coefficient never terminates
+  std::memset(sig + 41, 0, siglen - 41);
+  flg &= !decoding::decompress_sig<N, siglen>(sig, dec_s2);
+
+  std::free(s2);
+  std::free(dec_s2);
+  std::free(sig);
+
+  assert(flg);
+}
+
 }
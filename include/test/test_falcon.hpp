@@ -4,8 +4,12 @@
 #include "test_ff.hpp"
 #include "test_ffsampling.hpp"
 #include "test_fft.hpp"
+#include "test_fpr.hpp"
+#include "test_hashing.hpp"
+#include "test_isa.hpp"
 #include "test_keygen.hpp"
 #include "test_ntru_gen.hpp"
 #include "test_ntt.hpp"
+#include "test_prng.hpp"
 #include "test_samplerz.hpp"
 #include "test_signing.hpp"
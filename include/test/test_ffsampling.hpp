@@ -139,4 +139,82 @@ test_ff_sampling(
   assert(match);
 }
 
+// Check that in-place ffSampling ( which uses a single caller-provided
+// workspace ) samples exactly same integer polynomials z0, z1 as the original
+// ffSampling routine, when both of them consume same PRNG output.
+template<const size_t N>
+void
+test_ff_sampling_inplace(
+  const double σ,    // Standard deviation ( see table 3.3 of specification )
+  const double σ_min // See table 3.3 of specification
+  )
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t ft_len = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr fft::cmplx q{ ff::Q };
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ft_len));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto c_fft = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto t0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto t1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z0_ = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto z1_ = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N));
+  auto ws = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 2));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+
+  for (size_t i = 0; i < N; i++) {
+    c_fft[i] = fft::cmplx{ static_cast<double>(ff::ff_t::random().v) };
+  }
+
+  fft::fft<log2<N>()>(c_fft);
+  polynomial::mul<log2<N>()>(c_fft, B + 3 * N, t0);
+  polynomial::mul<log2<N>()>(c_fft, B + N, t1);
+
+  for (size_t i = 0; i < N; i++) {
+    t0[i] /= q;
+    t1[i] = -(t1[i] / q);
+  }
+
+  // both ffSampling variants must consume same PRNG output
+  prng::prng_t rng_ = rng;
+
+  ffsampling::ff_sampling<N, 0, log2<N>()>(t0, t1, T, σ_min, z0, z1, rng);
+  ffsampling::ff_sampling_inplace<N, 0, log2<N>()>(
+    t0, t1, T, σ_min, z0_, z1_, ws, rng_);
+
+  // z0, z1 are FFT representation of integer polynomials, compare coefficients
+  // because compiler may ( say, by vectorizing differently ) produce results
+  // differing in least significant bits of their FFT form
+  fft::ifft<log2<N>()>(z0);
+  fft::ifft<log2<N>()>(z1);
+  fft::ifft<log2<N>()>(z0_);
+  fft::ifft<log2<N>()>(z1_);
+
+  bool match = true;
+  for (size_t i = 0; i < N; i++) {
+    match &= std::round(z0[i].real()) == std::round(z0_[i].real());
+    match &= std::round(z1[i].real()) == std::round(z1_[i].real());
+  }
+
+  std::free(B);
+  std::free(T);
+  std::free(h);
+  std::free(c_fft);
+  std::free(t0);
+  std::free(t1);
+  std::free(z0);
+  std::free(z1);
+  std::free(z0_);
+  std::free(z1_);
+  std::free(ws);
+
+  assert(match);
+}
+
 }
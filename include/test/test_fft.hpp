@@ -1,6 +1,10 @@
 #pragma once
+#include "codelets.hpp"
+#include "falcon_tree.hpp"
+#include "ffsampling.hpp"
 #include "fft.hpp"
 #include "polynomial.hpp"
+#include "prng.hpp"
 #include <cassert>
 #include <cstring>
 
@@ -197,4 +201,145 @@ test_fft_split_merge()
   assert(!flg2);
 }
 
+// Generic ffLDL recursion, down to the leaves, which never uses fused kernel,
+// serving as reference for `falcon_tree::ffldl_fused`.
+template<const size_t N, const size_t AT_LEVEL, const size_t T_HEIGHT>
+inline void
+ffldl_generic(const fft::cmplx* const __restrict G,
+              fft::cmplx* const __restrict T)
+{
+  constexpr auto L = falcon_tree::layout_t::LEVEL_MAJOR;
+  constexpr size_t loff = falcon_tree::left_child<N, AT_LEVEL, L>();
+  constexpr size_t roff = falcon_tree::right_child<N, AT_LEVEL, L>();
+
+  fft::cmplx D00[N];
+  fft::cmplx D11[N];
+
+  falcon_tree::ldl<N>(G, T, D00, D11);
+
+  if constexpr (N == 2) {
+    T[loff] = D00[0];
+    T[roff] = D11[0];
+  } else {
+    fft::cmplx Gc[2 * N];
+
+    falcon_tree::child_gram<N>(D00, Gc);
+    ffldl_generic<N / 2, AT_LEVEL + 1, T_HEIGHT>(Gc, T + loff);
+
+    falcon_tree::child_gram<N>(D11, Gc);
+    ffldl_generic<N / 2, AT_LEVEL + 1, T_HEIGHT>(Gc, T + roff);
+  }
+}
+
+// Ensure that unrolled codelets, used at bottom levels of ffSampling and ffLDL,
+// and fused kernels built of them, compute bit-for-bit same results as generic
+// split/ merge, polynomial arithmetic, LDL* decomposition, ffLDL and
+// ffSampling routines, on random polynomials ( in FFT form ).
+template<const size_t lgn>
+void
+test_codelets()
+  requires((lgn > 0) && ((1ul << lgn) <= codelets::MAX_N))
+{
+  constexpr size_t n = 1ul << lgn;
+  constexpr size_t hn = n >> 1;
+
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+  std::uniform_real_distribution<double> dis{ -1e3, 1e3 };
+
+  fft::cmplx t0[n], t1[n], z1[n], l[n], G[4 * n];
+  fft::cmplx a[n], b[n], c[n], d[n], e[n], f[n];
+
+  for (size_t i = 0; i < n; i++) {
+    t0[i] = fft::cmplx{ dis(gen), dis(gen) };
+    t1[i] = fft::cmplx{ dis(gen), dis(gen) };
+    z1[i] = fft::cmplx{ dis(gen), dis(gen) };
+    l[i] = fft::cmplx{ dis(gen), dis(gen) };
+  }
+
+  // self-adjoint Gram matrix, with positive real g00, g11
+  for (size_t i = 0; i < n; i++) {
+    G[i] = fft::cmplx{ std::abs(dis(gen)) + 1. };
+    G[2 * n + i] = fft::cmplx{ dis(gen), dis(gen) };
+    G[n + i] = std::conj(G[2 * n + i]);
+    G[3 * n + i] = fft::cmplx{ std::abs(dis(gen)) + 1. };
+  }
+
+  auto same = [](const fft::cmplx* x, const fft::cmplx* y, const size_t len) {
+    return std::memcmp(x, y, sizeof(fft::cmplx) * len) == 0;
+  };
+
+  bool flg = true;
+
+  // split
+  fft::split_fft<lgn>(t0, a, a + hn);
+  codelets::split_fft<lgn>(t0, b, b + hn);
+  flg &= same(a, b, n);
+
+  // merge
+  fft::merge_fft<lgn>(t0, t0 + hn, a);
+  codelets::merge_fft<lgn>(t0, t0 + hn, b);
+  flg &= same(a, b, n);
+
+  // t0' = t0 + (t1 - z1) * l
+  polynomial::sub<lgn>(t1, z1, c);
+  polynomial::mul<lgn>(c, l, d);
+  polynomial::add<lgn>(t0, d, a);
+  codelets::sub_mul_add<lgn>(t0, t1, z1, l, b);
+  flg &= same(a, b, n);
+
+  // LDL* decomposition
+  falcon_tree::ldl<n>(G, a, c, e);
+  codelets::ldl<lgn>(G, b, d, f);
+  flg &= same(a, b, n) && same(c, d, n) && same(e, f, n);
+
+  // Gram matrix of child node
+  fft::cmplx Ga[2 * n], Gb[2 * n];
+  falcon_tree::child_gram<n>(e, Ga);
+  codelets::child_gram<lgn>(e, Gb);
+  flg &= same(Ga, Gb, 2 * n);
+
+  constexpr size_t tlen = (1ul << lgn) * (lgn + 1);
+
+  constexpr auto L = falcon_tree::layout_t::LEVEL_MAJOR;
+
+  // fused ffLDL, starting at root of tree
+  if constexpr (n <= codelets::MAX_LDL_N) {
+    fft::cmplx Ta[tlen]{}, Tb[tlen]{};
+
+    ffldl_generic<n, 0, lgn>(G, Ta);
+    falcon_tree::ffldl_fused<n, 0, lgn, L>(G, Tb);
+    flg &= same(Ta, Tb, tlen);
+  }
+
+  // fused ffSampling, starting at root of tree, with random inner nodes and
+  // leaves holding σ' ∈ [σ_min, σ_max], given same PRNG state
+  {
+    constexpr double σ_min = 1.277833697;
+    std::uniform_real_distribution<double> σ_dis{ 1.3, 1.8 };
+
+    fft::cmplx T[tlen];
+    for (size_t i = 0; i < lgn * n; i++) {
+      T[i] = fft::cmplx{ dis(gen), dis(gen) };
+    }
+    for (size_t i = lgn * n; i < tlen; i++) {
+      T[i] = fft::cmplx{ σ_dis(gen) };
+    }
+
+    uint8_t seed[32];
+    for (size_t i = 0; i < sizeof(seed); i++) {
+      seed[i] = static_cast<uint8_t>(gen());
+    }
+
+    prng::prng_t rng0(seed, sizeof(seed));
+    prng::prng_t rng1(seed, sizeof(seed));
+
+    ffsampling::ff_sampling<n, 0, lgn, L>(t0, t1, T, σ_min, a, c, rng0);
+    ffsampling::ff_sampling_fused<n, 0, lgn, L>(t0, t1, T, σ_min, b, d, rng1);
+    flg &= same(a, b, n) && same(c, d, n);
+  }
+
+  assert(flg);
+}
+
 }
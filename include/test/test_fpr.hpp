@@ -0,0 +1,162 @@
+#pragma once
+#include "falcon.hpp"
+#include "fpr.hpp"
+#include "isa.hpp"
+#include "prng.hpp"
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// Test functional correctness of Falcon PQC suite implementation
+namespace test_falcon {
+
+// Samples a random double, with random sign and mantissa, while its exponent is
+// kept within [-64, 64), so that neither operands nor results of arithmetic on
+// them are subnormal ( which emulated arithmetic flushes to zero ) or overflow.
+inline double
+random_fpr_operand(prng::prng_t& rng)
+{
+  uint64_t bits = 0;
+  rng.read(reinterpret_cast<uint8_t*>(&bits), sizeof(bits));
+
+  const uint64_t sign = bits & fpr::SIGN;
+  const uint64_t exp = 1023ul - 64ul + ((bits >> 52) & 127ul);
+  const uint64_t mant = bits & fpr::MANT;
+
+  return std::bit_cast<double>(sign | (exp << 52) | mant);
+}
+
+// Whether emulated real x holds same bit pattern as hardware double y.
+inline bool
+same_bits(const fpr::fpr_t x, const double y)
+{
+  return x.v == std::bit_cast<uint64_t>(y);
+}
+
+// Test that emulated floating point arithmetic ( see fpr.hpp ) is bit-for-bit
+// same as what IEEE 754 hardware double computes, with round to nearest, ties
+// to even, for random operands as well as for cases where rounding is harder
+// i.e. cancellation, exact halves and integers.
+inline void
+test_fpr_ops()
+{
+  constexpr size_t rounds = 1ul << 16;
+
+  prng::prng_t rng;
+  bool flg = true;
+
+  for (size_t i = 0; i < rounds; i++) {
+    const double a = random_fpr_operand(rng);
+    double b = random_fpr_operand(rng);
+
+    // every now and then, make operands cancel, fully or partially
+    if ((i & 7) == 0) {
+      b = -a;
+    } else if ((i & 7) == 1) {
+      b = std::nextafter(-a, 0.);
+    }
+
+    const fpr::fpr_t x{ a };
+    const fpr::fpr_t y{ b };
+
+    flg &= same_bits(x + y, a + b);
+    flg &= same_bits(x - y, a - b);
+    flg &= same_bits(x * y, a * b);
+    flg &= same_bits(x / y, a / b);
+    flg &= same_bits(fpr::sqrt(fpr::abs(x)), std::sqrt(std::abs(a)));
+    flg &= (x < y) == (a < b);
+    flg &= (x == y) == (a == b);
+
+    // exact integers and halves, around which floor/ round/ truncate differ
+    const double c = std::ldexp(a, -54) + static_cast<double>(i & 1) * 0.5;
+    const fpr::fpr_t z{ c };
+
+    flg &= same_bits(fpr::floor(z), std::floor(c));
+    flg &= same_bits(fpr::round(z), std::round(c));
+    flg &= static_cast<int64_t>(z) == static_cast<int64_t>(c);
+    flg &= same_bits(fpr::fpr_t{ static_cast<int64_t>(c) },
+                     static_cast<double>(static_cast<int64_t>(c)));
+  }
+
+  assert(flg);
+}
+
+// Test that signing, with Falcon tree and matrix B made of emulated complex
+// numbers ( see `fpr::cmplx_t` ), produces signatures which verify and which
+// are same, for same seeded PRNG, no matter which ISA variant of hot kernels (
+// see isa.hpp ) is in use. They are also compared against signatures produced
+// using hardware double, which rounds same, as FP contraction is disabled, while
+// complex multiplication keeps compiler from fusing it, see `fft::mul`.
+template<const size_t N>
+void
+test_fpr_sign()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+  constexpr isa::level_t levels[]{ isa::level_t::SCALAR,
+                                   isa::level_t::AVX2,
+                                   isa::level_t::AVX512 };
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  auto Be =
+    static_cast<fpr::cmplx_t*>(std::malloc(sizeof(fpr::cmplx_t) * 4 * N));
+  auto Te =
+    static_cast<fpr::cmplx_t*>(std::malloc(sizeof(fpr::cmplx_t) * tlen));
+  uint8_t msg[mlen];
+  uint8_t seed[32];
+  prng::prng_t rng;
+
+  const isa::level_t initial = isa::active();
+
+  rng.read(msg, sizeof(msg));
+  rng.read(seed, sizeof(seed));
+
+  falcon::keygen<N>(pkey, skey);
+
+  // reference signature, using hardware double
+  bool flg = falcon::expand_skey<N>(skey, B, T);
+
+  prng::prng_t rng0(seed, sizeof(seed));
+  falcon::sign<N>(B, T, msg, mlen, sig0, rng0);
+
+  for (const isa::level_t lvl : levels) {
+    // skip variants this CPU can't run
+    if (isa::select(lvl) != lvl) {
+      continue;
+    }
+
+    flg &= falcon::expand_skey<N>(skey, Be, Te);
+
+    prng::prng_t rng1(seed, sizeof(seed));
+    falcon::sign<N>(Be, Te, msg, mlen, sig1, rng1);
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= falcon::verify<N>(pkey, msg, mlen, sig1);
+  }
+
+  isa::select(initial);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(B);
+  std::free(T);
+  std::free(Be);
+  std::free(Te);
+
+  assert(flg);
+}
+
+}
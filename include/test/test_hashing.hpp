@@ -0,0 +1,129 @@
+#pragma once
+#include "hashing.hpp"
+#include "prng.hpp"
+#include "shake256.hpp"
+#include "xof.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Test functional correctness of Falcon PQC suite implementation
+namespace test_falcon {
+
+// Test that hashing W salts and messages at once ( see
+// `hashing::hash_to_point_xn` ) produces same W polynomials as hashing each of
+// them alone does, when messages are of same or different lengths, spanning
+// one or more SHAKE256 blocks.
+template<const size_t N, const size_t W>
+void
+test_hash_to_point_xn()
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  constexpr size_t mlens_[]{ 0, 1, 32, 95, 96, 97, 135, 136, 137, 1000 };
+  constexpr size_t cnt = sizeof(mlens_) / sizeof(mlens_[0]);
+  constexpr size_t max_mlen = 1000;
+
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(W * max_mlen));
+  auto polys_ = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N * W));
+  auto poly = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  uint8_t salt[W][40];
+  prng::prng_t rng;
+
+  const uint8_t* salts[W];
+  const uint8_t* msgs[W];
+  size_t mlens[W];
+  ff::ff_t* polys[W];
+
+  bool flg = true;
+
+  for (size_t round = 0; round < 2 * cnt; round++) {
+    rng.read(msgs_, W * max_mlen);
+
+    for (size_t w = 0; w < W; w++) {
+      rng.read(salt[w], sizeof(salt[w]));
+
+      salts[w] = salt[w];
+      msgs[w] = msgs_ + w * max_mlen;
+      // first half of rounds, all lanes hash messages of same length
+      mlens[w] = mlens_[(round < cnt) ? round : (round + w * 3) % cnt];
+      polys[w] = polys_ + w * N;
+    }
+
+    hashing::hash_to_point_xn<N, W>(salts, sizeof(salt[0]), msgs, mlens, polys);
+
+    for (size_t w = 0; w < W; w++) {
+      hashing::hash_to_point<N>(
+        salts[w], sizeof(salt[0]), msgs[w], mlens[w], poly);
+
+      for (size_t i = 0; i < N; i++) {
+        flg &= polys[w][i] == poly[i];
+      }
+    }
+  }
+
+  std::free(msgs_);
+  std::free(polys_);
+  std::free(poly);
+
+  assert(flg);
+}
+
+// Test that SHAKE256, backed by Falcon-side Keccak-f[1600] permutation ( see
+// xof.hpp ), squeezes same bytes as SHAKE256 from sha3 submodule does, when
+// message is absorbed and output is squeezed, in chunks of random length,
+// which may or may not cross SHAKE256 block boundaries.
+void
+test_xof()
+{
+  constexpr size_t max_mlen = 1024;
+  constexpr size_t max_olen = 2048;
+
+  auto msg = static_cast<uint8_t*>(std::malloc(max_mlen));
+  auto out0 = static_cast<uint8_t*>(std::malloc(max_olen));
+  auto out1 = static_cast<uint8_t*>(std::malloc(max_olen));
+  prng::prng_t rng;
+
+  bool flg = true;
+
+  for (size_t mlen = 0; mlen < max_mlen; mlen += 17) {
+    uint16_t lens[2];
+    rng.read(msg, mlen);
+
+    xof::falcon_shake256_t hasher0{};
+    shake256::shake256<true> hasher1{};
+
+    size_t off = 0;
+    while (off < mlen) {
+      rng.read(reinterpret_cast<uint8_t*>(lens), sizeof(lens));
+      const size_t len = std::min<size_t>(lens[0] % 300 + 1, mlen - off);
+
+      hasher0.absorb(msg + off, len);
+      off += len;
+    }
+    hasher1.absorb(msg, mlen);
+
+    hasher0.finalize();
+    hasher1.finalize();
+
+    const size_t olen = (mlen * 2) % max_olen;
+
+    off = 0;
+    while (off < olen) {
+      rng.read(reinterpret_cast<uint8_t*>(lens), sizeof(lens));
+      const size_t len = std::min<size_t>(lens[1] % 400 + 1, olen - off);
+
+      hasher0.read(out0 + off, len);
+      off += len;
+    }
+    hasher1.read(out1, olen);
+
+    flg &= std::equal(out0, out0 + olen, out1);
+  }
+
+  std::free(msg);
+  std::free(out0);
+  std::free(out1);
+
+  assert(flg);
+}
+
+}
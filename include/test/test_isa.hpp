@@ -0,0 +1,91 @@
+#pragma once
+#include "falcon.hpp"
+#include "isa.hpp"
+#include "prng.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+// Test functional correctness of Falcon PQC suite implementation
+namespace test_falcon {
+
+// Test that every ISA variant of hot kernels ( see isa.hpp ), which this CPU
+// can run, expands secret key into bit-identical matrix B and Falcon tree T,
+// produces same signature, for same key, message and seeded PRNG, and that
+// each of them verifies signatures produced by others, so that switching
+// variant, at run time, doesn't change what library computes. Note, variants
+// are compiled with wider vector registers and, for AVX2 and AVX-512, with FMA
+// available, so that this also checks that no multiplication and addition are
+// fused, in floating point kernels.
+template<const size_t N>
+void
+test_isa_dispatch()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+  constexpr isa::level_t levels[]{ isa::level_t::SCALAR,
+                                   isa::level_t::AVX2,
+                                   isa::level_t::AVX512 };
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen];
+  uint8_t seed[32];
+  prng::prng_t rng;
+
+  const isa::level_t initial = isa::active();
+
+  rng.read(msg, sizeof(msg));
+  rng.read(seed, sizeof(seed));
+
+  falcon::keygen<N>(pkey, skey);
+
+  // reference signature, using scalar variant
+  isa::select(isa::level_t::SCALAR);
+  bool flg = falcon::expand_skey<N>(skey, B0, T0);
+
+  prng::prng_t rng0(seed, sizeof(seed));
+  falcon::sign<N>(B0, T0, msg, mlen, sig0, rng0);
+
+  for (const isa::level_t lvl : levels) {
+    // skip variants this CPU can't run
+    if (isa::select(lvl) != lvl) {
+      continue;
+    }
+
+    flg &= falcon::expand_skey<N>(skey, B, T);
+    flg &= std::memcmp(B0, B, sizeof(fft::cmplx) * 4 * N) == 0;
+    flg &= std::memcmp(T0, T, sizeof(fft::cmplx) * tlen) == 0;
+
+    prng::prng_t rng1(seed, sizeof(seed));
+    falcon::sign<N>(B, T, msg, mlen, sig1, rng1);
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= falcon::verify<N>(pkey, msg, mlen, sig0);
+  }
+
+  isa::select(initial);
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(B0);
+  std::free(T0);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+}
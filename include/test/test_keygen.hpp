@@ -7,6 +7,7 @@
 #include "test_ntru_gen.hpp"
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 
 // Test functional correctness of Falcon PQC suite implementation
 namespace test_falcon {
@@ -19,11 +20,20 @@ namespace test_falcon {
 // - Recompute G using NTRU equation
 // - Check if NTRU equation still satisfies or not
 // - Also ensure that actual G and recomputed G' matches
+// - Cross-check exact, NTT based G recomputation against FFT based one, both
+//   for generated key and for many more derived ones, obtained by replacing
+//   (F, G) with (F ± x^j f, G ± x^j g), which keeps fG - gF = q intact
+// - Ensure that secret keys which decode, but don't satisfy NTRU equation, i.e.
+//   with tampered F or with f not invertible mod q, are rejected, both by G
+//   recomputation and by routines expanding secret key or signing with it
 template<const size_t N>
 void
 test_keygen()
 {
   constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
 
   auto f = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
   auto g = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
@@ -34,6 +44,10 @@ test_keygen()
   auto F_ = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
   auto G_ = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
   auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen]{};
   prng::prng_t rng;
 
   // Generate f, g, F and G
@@ -43,9 +57,9 @@ test_keygen()
   // Deserialize f, g and F
   decoding::decode_skey<N>(skey, f_, g_, F_);
   // Recompute G using NTRU equation
-  falcon::recompute_G<N>(f_, g_, F_, G_);
+  bool flg = falcon::recompute_G<N>(f_, g_, F_, G_);
   // See if NTRU equation can be solved
-  const bool flg = check_ntru_eq<N>(f_, g_, F_, G_);
+  flg &= check_ntru_eq<N>(f_, g_, F_, G_);
 
   // Ensure that each coefficient of original G and recomputed G' matches
   bool match = true;
@@ -53,6 +67,52 @@ test_keygen()
     match &= G[i] == G_[i];
   }
 
+  // Ensure that NTT and FFT based recomputation of G agree
+  falcon::recompute_G_fft<N>(f_, g_, F_, G_);
+  for (size_t i = 0; i < N; i++) {
+    match &= G[i] == G_[i];
+  }
+
+  // Tampered F, which still encodes, gives G out of range
+  F_[0] += (F_[0] < 0) ? 1 : -1;
+  flg &= !falcon::recompute_G<N>(f_, g_, F_, G_);
+
+  encoding::encode_skey<N>(f_, g_, F_, skey);
+  flg &= !falcon::expand_skey<N>(skey, B, T);
+  flg &= !falcon::sign<N>(skey, msg, mlen, sig);
+
+  // f, which is zero mod q, isn't invertible
+  std::memset(f_, 0, sizeof(int32_t) * N);
+  flg &= !falcon::recompute_G<N>(f_, g_, F_, G_);
+
+  encoding::encode_skey<N>(f_, g_, F_, skey);
+  flg &= !falcon::expand_skey<N>(skey, B, T);
+  flg &= !falcon::sign<N>(skey, msg, mlen, sig);
+
+  for (size_t j = 0; j < N; j += N / 32) {
+    const int32_t sign = ((j / (N / 32)) & 1) ? -1 : 1;
+
+    // F_ <- F + sign * x^j * f, G <- G + sign * x^j * g ( mod φ )
+    for (size_t i = 0; i < N; i++) {
+      const size_t k = (i + j) & (N - 1);
+      const int32_t wrap = (i + j) >= N ? -1 : 1;
+
+      F_[k] = F[k] + sign * wrap * f[i];
+      G[k] += sign * wrap * g[i];
+    }
+    std::memcpy(F, F_, sizeof(int32_t) * N);
+
+    falcon::recompute_G<N>(f, g, F, G_);
+    for (size_t i = 0; i < N; i++) {
+      match &= G[i] == G_[i];
+    }
+
+    falcon::recompute_G_fft<N>(f, g, F, G_);
+    for (size_t i = 0; i < N; i++) {
+      match &= G[i] == G_[i];
+    }
+  }
+
   std::free(f);
   std::free(g);
   std::free(F);
@@ -62,9 +122,93 @@ test_keygen()
   std::free(F_);
   std::free(G_);
   std::free(skey);
+  std::free(sig);
+  std::free(B);
+  std::free(T);
 
   assert(flg);
   assert(match);
 }
 
+// Test that Falcon keypair, generated from a seed, can be regenerated from same
+// seed, both in byte encoded form ( see `falcon::keygen_from_seed` ) and in
+// expanded form ( see `falcon::expand_seed` ), which must match B and T computed
+// from byte encoded secret key, while different seeds give different keypairs.
+template<const size_t N>
+void
+test_keygen_from_seed()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+
+  auto pkey0 = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey0 = static_cast<uint8_t*>(std::malloc(sklen));
+  auto pkey1 = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey1 = static_cast<uint8_t*>(std::malloc(sklen));
+  auto B0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  auto B1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  auto f = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto g = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto F = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto G = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t seed[falcon::SEED_LEN];
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  rng.read(seed, sizeof(seed));
+  rng.read(msg, sizeof(msg));
+
+  bool flg = true;
+
+  // same seed, same keypair
+  falcon::keygen_from_seed<N>(seed, pkey0, skey0);
+  falcon::keygen_from_seed<N>(seed, pkey1, skey1);
+
+  flg &= std::memcmp(pkey0, pkey1, pklen) == 0;
+  flg &= std::memcmp(skey0, skey1, sklen) == 0;
+
+  // seed expands to same B and T, as byte encoded secret key does
+  flg &= decoding::decode_skey<N>(skey0, f, g, F);
+  flg &= falcon::recompute_G<N>(f, g, F, G);
+  falcon::compute_matrix_B<N>(f, g, F, G, B0);
+  falcon::compute_falcon_tree<N>(B0, T0);
+
+  falcon::expand_seed<N>(seed, B1, T1);
+
+  flg &= std::memcmp(B0, B1, sizeof(fft::cmplx) * 4 * N) == 0;
+  flg &= std::memcmp(T0, T1, sizeof(fft::cmplx) * tlen) == 0;
+
+  falcon::sign<N>(B1, T1, msg, mlen, sig, rng);
+  flg &= falcon::verify<N>(pkey0, msg, mlen, sig);
+
+  // different seed, different keypair
+  seed[0] ^= 1;
+  falcon::keygen_from_seed<N>(seed, pkey1, skey1);
+
+  flg &= std::memcmp(pkey0, pkey1, pklen) != 0;
+
+  std::free(pkey0);
+  std::free(skey0);
+  std::free(pkey1);
+  std::free(skey1);
+  std::free(B0);
+  std::free(T0);
+  std::free(B1);
+  std::free(T1);
+  std::free(f);
+  std::free(g);
+  std::free(F);
+  std::free(G);
+  std::free(sig);
+
+  assert(flg);
+}
+
 }
@@ -0,0 +1,73 @@
+#pragma once
+#include "prng.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// Test functional correctness of Falcon PQC suite implementation
+namespace test_falcon {
+
+// Test that PRNG local to a thread ( see `prng::thread_prng` ) is reused by
+// same thread, is different for different threads and gets reseeded in a
+// forked child process, so that child doesn't produce same stream of bytes as
+// parent does.
+void
+test_thread_prng()
+{
+  uint8_t bytes0[32];
+  uint8_t bytes1[32];
+
+  bool flg = true;
+
+  // system randomness
+  prng::system_random(bytes0, sizeof(bytes0));
+  prng::system_random(bytes1, sizeof(bytes1));
+
+  flg &= std::memcmp(bytes0, bytes1, sizeof(bytes0)) != 0;
+
+  // same thread, same PRNG
+  prng::prng_t& rng = prng::thread_prng();
+  flg &= &rng == &prng::thread_prng();
+
+  // other thread, other PRNG
+  const prng::prng_t* other = nullptr;
+  std::thread([&] {
+    other = &prng::thread_prng();
+    prng::thread_prng().read(bytes1, sizeof(bytes1));
+  }).join();
+
+  rng.read(bytes0, sizeof(bytes0));
+
+  flg &= other != &rng;
+  flg &= std::memcmp(bytes0, bytes1, sizeof(bytes0)) != 0;
+
+  // forked child, reseeded PRNG
+  prng::prng_t copy = rng;
+
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    prng::thread_prng().read(bytes0, sizeof(bytes0));
+    copy.read(bytes1, sizeof(bytes1));
+
+    const bool ok = std::memcmp(bytes0, bytes1, sizeof(bytes0)) != 0;
+    ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  int status = 0;
+  flg &= pid > 0;
+  flg &= ::waitpid(pid, &status, 0) == pid;
+  flg &= WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+
+  // parent keeps its PRNG as is
+  rng.read(bytes0, sizeof(bytes0));
+  copy.read(bytes1, sizeof(bytes1));
+
+  flg &= std::memcmp(bytes0, bytes1, sizeof(bytes0)) == 0;
+
+  assert(flg);
+}
+
+}
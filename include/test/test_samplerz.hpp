@@ -1,6 +1,8 @@
 #pragma once
+#include "prng.hpp"
 #include "samplerz.hpp"
 #include <cassert>
+#include <cstring>
 
 // Test functional correctness of Falcon PQC suite implementation
 namespace test_falcon {
@@ -15676,4 +15678,70 @@ test_falcon1024_samplerz()
   }
 }
 
+// Test that lane-batched samplerZ routine samples, for each active lane, same
+// integer as samplerZ does, given same PRNG state, for Falcon{512, 1024}
+// parameters and random centers μ, while inactive lanes don't consume any
+// randomness.
+template<const size_t W>
+void
+test_samplerz_xn()
+{
+  constexpr double σ_mins[]{ samplerz::FALCON512_σ_min,
+                             samplerz::FALCON1024_σ_min };
+
+  prng::prng_t rng;
+  bool flg = true;
+
+  for (size_t round = 0; round < 256; round++) {
+    const double σ_min = σ_mins[round & 1];
+
+    uint32_t bits = 0;
+    rng.read(reinterpret_cast<uint8_t*>(&bits), sizeof(bits));
+
+    // σ' ∈ [σ_min, σ_max), while random lanes are active, except for first
+    // round, where all of them are
+    const double σ_prime =
+      σ_min + (samplerz::σ_max - σ_min) * static_cast<double>(bits >> 8) /
+                static_cast<double>(1u << 24);
+    const uint32_t mask = (1u << W) - 1u;
+    const uint32_t active = round == 0 ? mask : bits & mask;
+
+    double μ[W];
+    prng::prng_t rngs0[W];
+    prng::prng_t rngs1[W];
+
+    for (size_t w = 0; w < W; w++) {
+      int32_t v = 0;
+      rng.read(reinterpret_cast<uint8_t*>(&v), sizeof(v));
+      μ[w] = static_cast<double>(v) / 65536.;
+
+      uint8_t seed[32];
+      rng.read(seed, sizeof(seed));
+
+      rngs0[w] = prng::prng_t(seed, sizeof(seed));
+      rngs1[w] = prng::prng_t(seed, sizeof(seed));
+    }
+
+    int32_t z[W];
+    samplerz::samplerz_xn<W>(μ, σ_prime, σ_min, rngs1, active, z);
+
+    for (size_t w = 0; w < W; w++) {
+      if ((active >> w) & 1u) {
+        flg &= z[w] == samplerz::samplerz(μ[w], σ_prime, σ_min, rngs0[w]);
+      } else {
+        flg &= z[w] == 0;
+      }
+
+      // both PRNGs must have been advanced by same many bytes
+      uint8_t b0[16], b1[16];
+      rngs0[w].read(b0, sizeof(b0));
+      rngs1[w].read(b1, sizeof(b1));
+
+      flg &= std::memcmp(b0, b1, sizeof(b0)) == 0;
+    }
+  }
+
+  assert(flg);
+}
+
 }
@@ -1,8 +1,20 @@
 #pragma once
+#include "batch_signing.hpp"
 #include "common.hpp"
+#include "entropy.hpp"
 #include "falcon.hpp"
+#include "key_cache.hpp"
+#include "key_loader.hpp"
+#include "key_store.hpp"
+#include "pkey_store.hpp"
 #include "prng.hpp"
+#include "stats.hpp"
+#include "streaming.hpp"
 #include <cassert>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Test functional correctness of Falcon PQC suite implementation
 namespace test_falcon {
@@ -41,4 +53,1337 @@ test_keygen_sign_verify()
   std::free(sig);
 }
 
+// Builds signatures over random messages, carrying random but short s2, so that
+// they decode fine, while s1 = c - s2*h ( mod q ) is essentially random, making
+// squared norm of (s1, s2) far exceed bound β2 and also overflow 32 -bit
+// integer. Looks for one whose squared norm, wrapped to 32 -bit, is still
+// within β2 - which verification accepted, when it accumulated squared norm in
+// 32 -bit integer - and checks that it gets rejected.
+template<const size_t N>
+void
+test_verify_norm_overflow()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+  constexpr size_t attempts = 64;
+  constexpr uint16_t qby2 = ff::Q / 2;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto s2 = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto c = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto s1 = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto s2_ntt = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  uint8_t msg[32];
+  uint8_t salt[40];
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  bool flg = decoding::decode_pkey<N>(pkey, h);
+  ntt::ntt<log2<N>()>(h);
+
+  bool found = false;
+  for (size_t i = 0; (i < attempts) && !found; i++) {
+    rng.read(msg, sizeof(msg));
+    rng.read(salt, sizeof(salt));
+
+    for (size_t j = 0; j < N; j++) {
+      uint8_t b = 0;
+      rng.read(&b, sizeof(b));
+      s2[j] = static_cast<int32_t>(b % 31) - 15;
+    }
+
+    sig[0] = 0x30 | static_cast<uint8_t>(log2<N>());
+    std::memcpy(sig + 1, salt, sizeof(salt));
+    flg &= encoding::compress_sig<N, siglen>(s2, sig);
+
+    // s1 = c - s2*h ( mod q ), same as verification computes
+    hashing::hash_to_point<N>(salt, sizeof(salt), msg, sizeof(msg), c);
+    for (size_t j = 0; j < N; j++) {
+      s2_ntt[j].v = static_cast<uint16_t>((s2[j] < 0) * ff::Q + s2[j]);
+    }
+
+    ntt::ntt<log2<N>()>(c);
+    ntt::ntt<log2<N>()>(s2_ntt);
+    polynomial::mul<log2<N>()>(s2_ntt, h, s1);
+    polynomial::neg<log2<N>()>(s1);
+    polynomial::add_to<log2<N>()>(s1, c);
+    ntt::intt<log2<N>()>(s1);
+
+    int64_t sqrd_norm = 0;
+    for (size_t j = 0; j < N; j++) {
+      const int64_t t0 = s1[j].v - (s1[j].v >= qby2) * ff::Q;
+      const int64_t t1 = s2[j];
+      sqrd_norm += t0 * t0 + t1 * t1;
+    }
+
+    const auto wrapped = static_cast<int32_t>(static_cast<uint32_t>(sqrd_norm));
+    if ((sqrd_norm > INT32_MAX) && (wrapped <= β2)) {
+      found = true;
+      flg &= !falcon::verify<N>(pkey, msg, sizeof(msg), sig);
+    }
+  }
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig);
+  std::free(s2);
+  std::free(h);
+  std::free(c);
+  std::free(s1);
+  std::free(s2_ntt);
+
+  assert(found && flg);
+}
+
+// Given expanded Falcon{512, 1024} secret key, signs same message using full
+// falcon tree and tree-less signing routine, keeping top `CACHED` levels of the
+// tree, while consuming same PRNG output - both must produce same signature.
+template<const size_t N, const size_t CACHED>
+static bool
+check_sign_dyn(const fft::cmplx* const __restrict B,
+               const fft::cmplx* const __restrict T,
+               const ff::ff_t* const __restrict h,
+               prng::prng_t& rng)
+{
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tclen = falcon_tree::cached_tree_len<N, CACHED>();
+  constexpr size_t mlen = 32;
+
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto Tc = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tclen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+
+  falcon::compute_cached_tree<N, CACHED>(B, Tc);
+  rng.read(msg, mlen);
+
+  prng::prng_t rng_ = rng;
+
+  falcon::sign<N>(B, T, msg, mlen, sig0, rng);
+  falcon::sign_dyn<N, CACHED>(B, Tc, msg, mlen, sig1, rng_);
+
+  const bool verified = verification::verify<N, β2>(h, msg, mlen, sig1);
+  const bool matches = std::memcmp(sig0, sig1, siglen) == 0;
+
+  std::free(Tc);
+  std::free(sig0);
+  std::free(sig1);
+
+  return verified && matches;
+}
+
+// Test that tree-less ( dynamic ) signing, keeping only some top levels of
+// falcon tree or only f, g, F, G, produces same signatures as signing with
+// full falcon tree, given same PRNG state, and those signatures verify.
+template<const size_t N>
+void
+test_sign_dyn()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>());
+  constexpr size_t mlen = 32;
+
+  auto f = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto g = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto F = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto G = static_cast<int32_t*>(std::malloc(sizeof(int32_t) * N));
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  ntru_gen::ntru_gen<N>(f, g, F, G, rng);
+  keygen::compute_public_key<N>(f, g, h);
+  falcon::compute_matrix_B<N>(f, g, F, G, B);
+  falcon::compute_falcon_tree<N>(B, T);
+
+  bool flg = true;
+
+  flg &= check_sign_dyn<N, 0>(B, T, h, rng);
+  flg &= check_sign_dyn<N, 1>(B, T, h, rng);
+  flg &= check_sign_dyn<N, 3>(B, T, h, rng);
+  flg &= check_sign_dyn<N, log2<N>() - 1>(B, T, h, rng);
+
+  // sign using only f, g, F and G
+  rng.read(msg, mlen);
+  prng::prng_t rng_ = rng;
+
+  falcon::sign<N>(B, T, msg, mlen, sig0, rng);
+  falcon::sign_dyn<N>(f, g, F, G, msg, mlen, sig1, rng_);
+  flg &= std::memcmp(sig0, sig1, siglen) == 0;
+
+  std::free(f);
+  std::free(g);
+  std::free(F);
+  std::free(G);
+  std::free(h);
+  std::free(B);
+  std::free(T);
+  std::free(sig0);
+  std::free(sig1);
+
+  assert(flg);
+}
+
+// Test that scratch buffer taking variants of key generation, cached falcon
+// tree computation, signing and verification routines, produce same keys, trees
+// and signatures as those keeping temporaries on the stack, given same PRNG
+// state.
+template<const size_t N>
+void
+test_scratch_api()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>());
+  constexpr size_t mlen = 32;
+  constexpr size_t ctop = log2<N>() - 1;
+  constexpr size_t tclen = falcon_tree::cached_tree_len<N, ctop>();
+
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ_min_values[]{ 1.277833697, 1.298280334 };
+  constexpr double σ = σ_values[N == 1024];
+  constexpr double σ_min = σ_min_values[N == 1024];
+
+  constexpr size_t ctlen0 = falcon::cached_tree_scratch_bytes<N, 2>();
+  constexpr size_t ctlen1 = falcon::cached_tree_scratch_bytes<N, ctop>();
+  constexpr size_t sclen = std::max({ keygen::keygen_scratch_bytes<N>(),
+                                      signing::sign_scratch_bytes<N>(),
+                                      signing::sign_dyn_scratch_bytes<N, 0>(),
+                                      falcon::sign_skey_scratch_bytes<N>(),
+                                      falcon::verify_pkey_scratch_bytes<N>(),
+                                      ctlen0,
+                                      ctlen1 });
+
+  auto scratch_ =
+    static_cast<uint8_t*>(std::aligned_alloc(scratch::ALIGNMENT, sclen));
+  auto h0 = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto h1 = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto B0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto B1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto T1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto Tc0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tclen));
+  auto Tc1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tclen));
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  bool flg = scratch::is_aligned(scratch_);
+
+  prng::prng_t rng_ = rng;
+  keygen::keygen<N>(B0, T0, h0, σ, rng);
+  keygen::keygen<N>(B1, T1, h1, σ, rng_, scratch_);
+  flg &= std::memcmp(h0, h1, sizeof(ff::ff_t) * N) == 0;
+  flg &= std::memcmp(B0, B1, sizeof(fft::cmplx) * N * 4) == 0;
+  flg &= std::memcmp(T0, T1, sizeof(fft::cmplx) * ftlen) == 0;
+
+  // top levels of falcon tree, for tree-less signing
+  falcon::compute_cached_tree<N, 2>(B0, Tc0);
+  falcon::compute_cached_tree<N, 2>(B0, Tc1, scratch_);
+  flg &= std::memcmp(Tc0, Tc1, sizeof(fft::cmplx) * 4 * N) == 0;
+
+  falcon::compute_cached_tree<N, ctop>(B0, Tc0);
+  falcon::compute_cached_tree<N, ctop>(B0, Tc1, scratch_);
+  flg &= std::memcmp(Tc0, Tc1, sizeof(fft::cmplx) * tclen) == 0;
+
+  rng.read(msg, mlen);
+  rng_ = rng;
+
+  falcon::sign<N>(B0, T0, msg, mlen, sig0, rng);
+  falcon::sign<N>(B1, T1, msg, mlen, sig1, rng_, scratch_);
+  flg &= std::memcmp(sig0, sig1, siglen) == 0;
+
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  flg &= verification::verify<N, β2>(h1, msg, mlen, sig1, scratch_);
+
+  rng_ = rng;
+
+  falcon::sign_dyn<N, 0>(B0, nullptr, msg, mlen, sig0, rng);
+  signing::sign_dyn<N, β2, siglen, 0>(
+    B1, nullptr, msg, mlen, sig1, σ, σ_min, rng_, scratch_);
+  flg &= std::memcmp(sig0, sig1, siglen) == 0;
+
+  // byte encoded keys
+  falcon::keygen<N>(pkey, skey);
+
+  flg &= falcon::sign<N>(skey, msg, mlen, sig1, scratch_);
+
+  // secret key material doesn't outlive signing, whether it succeeds or not
+  constexpr size_t wlen = falcon::sign_skey_scratch_bytes<N>();
+  const auto wiped = [&]() {
+    return std::all_of(
+      scratch_, scratch_ + wlen, [](const uint8_t v) { return v == 0; });
+  };
+
+  flg &= wiped();
+  flg &= falcon::verify<N>(pkey, msg, mlen, sig1, scratch_);
+
+  skey[0] ^= 0xff;
+  std::memset(scratch_, 0xff, wlen);
+  flg &= !falcon::sign<N>(skey, msg, mlen, sig1, scratch_);
+  flg &= wiped();
+  skey[0] ^= 0xff;
+
+  std::free(scratch_);
+  std::free(Tc0);
+  std::free(Tc1);
+  std::free(h0);
+  std::free(h1);
+  std::free(B0);
+  std::free(B1);
+  std::free(T0);
+  std::free(T1);
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig0);
+  std::free(sig1);
+
+  assert(flg);
+}
+
+// Test that signing with Falcon tree laid out in pre-order ( see
+// `falcon_tree::layout_t` ), produces same signature as signing with
+// level-major Falcon tree, given same PRNG state, and both layouts hold
+// bit-identical tree nodes.
+template<const size_t N>
+void
+test_preorder_tree()
+  requires((N == 512) || (N == 1024))
+{
+  using layout_t = falcon_tree::layout_t;
+
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>());
+  constexpr size_t mlen = 32;
+
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T0 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto T1 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto T2 = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  keygen::keygen<N, layout_t::PRE_ORDER>(B, T1, h, σ, rng);
+  falcon::compute_falcon_tree<N, layout_t::LEVEL_MAJOR>(B, T0);
+
+  // both layouts must hold bit-identical tree nodes, as they're computed by
+  // same arithmetic, only laid out differently
+  falcon_tree::relayout_tree<N,
+                             0,
+                             log2<N>(),
+                             layout_t::LEVEL_MAJOR,
+                             layout_t::PRE_ORDER>(T0, T2);
+
+  bool flg = std::memcmp(T1, T2, sizeof(fft::cmplx) * ftlen) == 0;
+
+  for (size_t i = 0; i < 8; i++) {
+    rng.read(msg, mlen);
+    prng::prng_t rng_ = rng;
+
+    falcon::sign<N, layout_t::LEVEL_MAJOR>(B, T0, msg, mlen, sig0, rng);
+    falcon::sign<N, layout_t::PRE_ORDER>(B, T1, msg, mlen, sig1, rng_);
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= verification::verify<N, β2>(h, msg, mlen, sig1);
+  }
+
+  std::free(h);
+  std::free(B);
+  std::free(T0);
+  std::free(T1);
+  std::free(T2);
+  std::free(sig0);
+  std::free(sig1);
+
+  assert(flg);
+}
+
+// Test that batched, multi-threaded signing ( see `batch_signing::signer_t` )
+// produces valid signatures for all messages of a batch, each written in same
+// order as messages are supplied.
+template<const size_t N>
+void
+test_sign_batch()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>());
+  constexpr size_t cnt = 67;
+  constexpr size_t max_mlen = 128;
+
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(cnt * max_mlen));
+  auto sigs_ = static_cast<uint8_t*>(std::malloc(cnt * siglen));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+  rng.read(msgs_, cnt * max_mlen);
+
+  // messages of varying length, stored one after another
+  std::vector<std::span<const uint8_t>> msgs;
+  std::vector<uint8_t*> sigs;
+  for (size_t i = 0; i < cnt; i++) {
+    msgs.emplace_back(msgs_ + i * max_mlen, (i * 13) % max_mlen);
+    sigs.push_back(sigs_ + i * siglen);
+  }
+
+  bool flg = true;
+
+  for (const size_t threads : { 1ul, 4ul }) {
+    batch_signing::signer_t<N> signer(threads);
+    flg &= signer.threads() == threads;
+
+    std::memset(sigs_, 0, cnt * siglen);
+    flg &= batch_signing::sign_batch<N>(signer, B, T, msgs, sigs);
+
+    for (size_t i = 0; i < cnt; i++) {
+      flg &= verification::verify<N, β2>(
+        h, msgs[i].data(), msgs[i].size(), sigs[i]);
+    }
+
+    // # -of messages and signature buffers must match
+    const std::span<uint8_t* const> sigs0(sigs.data(), cnt - 1);
+    flg &= !batch_signing::sign_batch<N>(signer, B, T, msgs, sigs0);
+  }
+
+  // persistent signer, with as many workers as hardware threads
+  std::memset(sigs_, 0, cnt * siglen);
+  flg &= batch_signing::sign_batch<N>(B, T, msgs, sigs);
+
+  for (size_t i = 0; i < cnt; i++) {
+    flg &=
+      verification::verify<N, β2>(h, msgs[i].data(), msgs[i].size(), sigs[i]);
+  }
+
+  std::free(h);
+  std::free(B);
+  std::free(T);
+  std::free(msgs_);
+  std::free(sigs_);
+
+  assert(flg);
+}
+
+// Test that signing W messages in lockstep ( see `falcon::sign_xn` ) produces,
+// for each lane, same signature as signing that message alone does, given same
+// PRNG state, and all those signatures verify, both one by one and all at once
+// ( see `verification::verify_ntt_xn` ).
+template<const size_t N, const size_t W>
+void
+test_sign_xn()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t ftlen = (log2<N>() + 1) * (1ul << log2<N>());
+  constexpr size_t max_mlen = 64;
+
+  constexpr double σ_values[]{ 165.736617183, 168.388571447 };
+  constexpr double σ = σ_values[N == 1024];
+
+  constexpr int32_t β2_values[]{ 34034726, 70265242 };
+  constexpr int32_t β2 = β2_values[N == 1024];
+
+  auto h = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto h_ntt = static_cast<ff::ff_t*>(std::malloc(sizeof(ff::ff_t) * N));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * N * 4));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * ftlen));
+  auto msgs_ = static_cast<uint8_t*>(std::malloc(W * max_mlen));
+  auto sigs0_ = static_cast<uint8_t*>(std::malloc(W * siglen));
+  auto sigs1_ = static_cast<uint8_t*>(std::malloc(W * siglen));
+  auto scratch_ = static_cast<uint8_t*>(std::aligned_alloc(
+    scratch::ALIGNMENT, signing::sign_xn_scratch_bytes<N, W>()));
+  prng::prng_t rng;
+
+  keygen::keygen<N>(B, T, h, σ, rng);
+
+  const uint8_t* msgs[W];
+  size_t mlens[W];
+  uint8_t* sigs[W];
+  prng::prng_t rngs[W];
+
+  bool flg = true;
+
+  for (size_t round = 0; round < 4; round++) {
+    rng.read(msgs_, W * max_mlen);
+
+    for (size_t w = 0; w < W; w++) {
+      msgs[w] = msgs_ + w * max_mlen;
+      mlens[w] = (round * W + w * 7) % max_mlen;
+      sigs[w] = sigs1_ + w * siglen;
+    }
+
+    prng::prng_t rngs_[W];
+    std::copy(rngs, rngs + W, rngs_);
+
+    for (size_t w = 0; w < W; w++) {
+      falcon::sign<N>(B, T, msgs[w], mlens[w], sigs0_ + w * siglen, rngs_[w]);
+    }
+
+    if (round & 1) {
+      falcon::sign_xn<N, W>(B, T, msgs, mlens, sigs, rngs, scratch_);
+    } else {
+      falcon::sign_xn<N, W>(B, T, msgs, mlens, sigs, rngs);
+    }
+
+    flg &= std::memcmp(sigs0_, sigs1_, W * siglen) == 0;
+
+    for (size_t w = 0; w < W; w++) {
+      flg &= verification::verify<N, β2>(h, msgs[w], mlens[w], sigs[w]);
+    }
+
+    // verify all W signatures at once, while salt of last one is altered, from
+    // second round onwards
+    const ff::ff_t* hs[W];
+    bool ok[W];
+
+    std::memcpy(h_ntt, h, sizeof(ff::ff_t) * N);
+    ntt::ntt<log2<N>()>(h_ntt);
+    std::fill(hs, hs + W, h_ntt);
+
+    sigs[W - 1][1] ^= static_cast<uint8_t>(round > 0);
+
+    const bool all =
+      verification::verify_ntt_xn<N, β2, W>(hs, msgs, mlens, sigs, ok);
+
+    flg &= all == (round == 0);
+    flg &= ok[W - 1] == (round == 0);
+    for (size_t w = 0; w < W - 1; w++) {
+      flg &= ok[w];
+    }
+  }
+
+  std::free(h);
+  std::free(h_ntt);
+  std::free(B);
+  std::free(T);
+  std::free(msgs_);
+  std::free(sigs0_);
+  std::free(sigs1_);
+  std::free(scratch_);
+
+  assert(flg);
+}
+
+// Test that cache of expanded secret keys ( see `key_cache::key_cache_t` ) hands
+// out expanded keys which produce valid signatures, evicts least recently used
+// entry when memory cap is hit, and once enabled, is consulted by
+// `falcon::sign(skey, msg, mlen, sig)`.
+template<const size_t N>
+void
+test_key_cache()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t kcnt = 3;
+  constexpr size_t mlen = 32;
+
+  // room for two expanded keys
+  constexpr size_t cap = 2 * key_cache::entry_t<N>::bytes();
+
+  auto pkeys = static_cast<uint8_t*>(std::malloc(pklen * kcnt));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * kcnt));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < kcnt; i++) {
+    falcon::keygen<N>(pkeys + i * pklen, skeys + i * sklen);
+  }
+
+  key_cache::key_cache_t<N> cache(cap);
+
+  bool flg = true;
+
+  // access pattern k0, k1, k0, k2, k0, k1 s.t. k1 is evicted, when k2 is added
+  constexpr size_t order[]{ 0, 1, 0, 2, 0, 1 };
+  constexpr bool hit[]{ false, false, true, false, true, false };
+
+  for (size_t i = 0; i < std::size(order); i++) {
+    const size_t k = order[i];
+    const size_t hits = cache.hits();
+
+    rng.read(msg, mlen);
+
+    flg &= cache.sign(skeys + k * sklen, msg, mlen, sig);
+    flg &= falcon::verify<N>(pkeys + k * pklen, msg, mlen, sig);
+    flg &= (cache.hits() == hits + 1) == hit[i];
+    flg &= cache.size() <= 2;
+  }
+
+  flg &= cache.misses() == 4;
+
+  // undecodable secret key is never cached
+  auto bad = static_cast<uint8_t*>(std::malloc(sklen));
+  std::memcpy(bad, skeys, sklen);
+  bad[0] ^= 0xff;
+
+  flg &= !cache.sign(bad, msg, mlen, sig);
+  flg &= cache.size() == 2;
+
+  // opt-in caching behind single-shot signing API
+  key_cache::enable<N>(cap);
+
+  for (size_t i = 0; i < 4; i++) {
+    rng.read(msg, mlen);
+
+    flg &= falcon::sign<N>(skeys, msg, mlen, sig);
+    flg &= falcon::verify<N>(pkeys, msg, mlen, sig);
+  }
+
+  flg &= key_cache::global<N>().misses() == 1;
+  flg &= key_cache::global<N>().hits() == 3;
+
+  key_cache::disable<N>();
+  flg &= key_cache::global<N>().size() == 0;
+
+  rng.read(msg, mlen);
+  flg &= falcon::sign<N>(skeys, msg, mlen, sig);
+  flg &= falcon::verify<N>(pkeys, msg, mlen, sig);
+  flg &= key_cache::global<N>().misses() == 1;
+
+  std::free(pkeys);
+  std::free(skeys);
+  std::free(sig);
+  std::free(bad);
+
+  assert(flg);
+}
+
+// Test that expanded secret keys, written to store ( see `key_store::build` )
+// and memory mapped back ( see `key_store::mapped_t` ), can be looked up by key
+// id and produce same signatures as freshly expanded secret keys, while
+// corrupted stores are rejected.
+template<const size_t N>
+void
+test_key_store()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t kcnt = 3;
+  constexpr size_t mlen = 32;
+  constexpr auto L = falcon_tree::layout_t::LEVEL_MAJOR;
+
+  auto pkeys = static_cast<uint8_t*>(std::malloc(pklen * kcnt));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * kcnt));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen];
+  uint8_t id[key_store::ID_LEN];
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < kcnt; i++) {
+    falcon::keygen<N>(pkeys + i * pklen, skeys + i * sklen);
+  }
+
+  char path[] = "/tmp/falcon_key_store_XXXXXX";
+  const int fd = ::mkstemp(path);
+  assert(fd >= 0);
+
+  bool flg = true;
+
+  flg &= key_store::build<N, L>(path, skeys, kcnt);
+
+  key_store::mapped_t<N, L> store;
+  flg &= store.open(path);
+  flg &= store.size() == kcnt;
+
+  for (size_t i = 0; i < kcnt; i++) {
+    key_store::key_id<N>(pkeys + i * pklen, id);
+
+    const size_t idx = store.find(id);
+    flg &= idx != store.npos;
+    if (idx == store.npos) {
+      continue;
+    }
+
+    flg &= store.check(idx);
+    flg &= (reinterpret_cast<uintptr_t>(store.B(idx)) % scratch::ALIGNMENT) == 0;
+    flg &= (reinterpret_cast<uintptr_t>(store.T(idx)) % scratch::ALIGNMENT) == 0;
+
+    // signing, straight from mapping, must match freshly expanded key
+    int32_t f[N], g[N], F[N], G[N];
+    flg &= decoding::decode_skey<N>(skeys + i * sklen, f, g, F);
+    flg &= falcon::recompute_G<N>(f, g, F, G);
+    falcon::compute_matrix_B<N>(f, g, F, G, B);
+    falcon::compute_falcon_tree<N, L>(B, T);
+
+    rng.read(msg, mlen);
+    prng::prng_t rng0 = rng;
+    prng::prng_t rng1 = rng;
+
+    falcon::sign<N, L>(B, T, msg, mlen, sig0, rng0);
+    falcon::sign<N, L>(store.B(idx), store.T(idx), msg, mlen, sig1, rng1);
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= falcon::verify<N>(pkeys + i * pklen, msg, mlen, sig1);
+  }
+
+  // unknown key id is not found
+  std::memset(id, 0, sizeof(id));
+  flg &= store.find(id) == store.npos;
+
+  // store written for other layout is rejected
+  key_store::mapped_t<N, falcon_tree::layout_t::PRE_ORDER> other;
+  flg &= !other.open(path);
+
+  // flipped byte of a record is caught by its checksum
+  const uint8_t flip = 0xff;
+  uint8_t byte = 0;
+  const off_t off = static_cast<off_t>(key_store::PAGE_SIZE + 8);
+
+  flg &= ::pread(fd, &byte, 1, off) == 1;
+  byte ^= flip;
+  flg &= ::pwrite(fd, &byte, 1, off) == 1;
+
+  size_t bad = 0;
+  for (size_t i = 0; i < store.size(); i++) {
+    bad += !store.check(i);
+  }
+  flg &= bad == 1;
+
+  // corrupted header is rejected
+  const uint8_t junk = 0;
+  flg &= ::pwrite(fd, &junk, 1, 0) == 1;
+  store.close();
+  flg &= !store.open(path);
+  flg &= store.size() == 0;
+
+  ::close(fd);
+  ::unlink(path);
+
+  std::free(pkeys);
+  std::free(skeys);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+// Test that public keys, written to store ( see `pkey_store::build` ) and memory
+// mapped back ( see `pkey_store::mapped_t` ), in either coefficient or NTT form,
+// can be looked up by key id, through hash index, and verify signatures, same
+// as byte encoded public keys do.
+template<const size_t N>
+void
+test_pkey_store()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t kcnt = 2;
+  constexpr size_t fake_cnt = 61; // ids w/o public key, for exercising probing
+  constexpr size_t mlen = 32;
+
+  auto pkeys = static_cast<uint8_t*>(std::malloc(pklen * kcnt));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * kcnt));
+  auto sigs = static_cast<uint8_t*>(std::malloc(siglen * kcnt));
+  uint8_t msg[mlen];
+  uint8_t id[pkey_store::ID_LEN];
+  ff::ff_t h[N];
+  prng::prng_t rng;
+
+  rng.read(msg, mlen);
+
+  for (size_t i = 0; i < kcnt; i++) {
+    falcon::keygen<N>(pkeys + i * pklen, skeys + i * sklen);
+    falcon::sign<N>(skeys + i * sklen, msg, mlen, sigs + i * siglen);
+  }
+
+  bool flg = true;
+
+  for (const auto form : { pkey_store::form_t::COEFF, pkey_store::form_t::NTT }) {
+    char path[] = "/tmp/falcon_pkey_store_XXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0);
+
+    pkey_store::writer_t<N> writer(fd, form);
+
+    flg &= decoding::decode_pkey<N>(pkeys, h);
+    for (size_t i = 0; i < fake_cnt; i++) {
+      rng.read(id, sizeof(id));
+      flg &= writer.add(id, h);
+    }
+    for (size_t i = 0; i < kcnt; i++) {
+      flg &= writer.add(pkeys + i * pklen);
+    }
+    flg &= writer.finish();
+
+    pkey_store::mapped_t<N> store;
+    flg &= store.attach(fd);
+    flg &= store.size() == fake_cnt + kcnt;
+    flg &= store.form() == form;
+
+    for (size_t i = 0; i < kcnt; i++) {
+      key_store::key_id<N>(pkeys + i * pklen, id);
+
+      const auto h_ = store.find(id);
+      flg &= h_ != nullptr;
+      flg &= (reinterpret_cast<uintptr_t>(h_) % scratch::ALIGNMENT) == 0;
+
+      const uint8_t* const sig = sigs + i * siglen;
+      const uint8_t* const other = sigs + (i ^ 1) * siglen;
+
+      flg &= store.verify(id, msg, mlen, sig);
+      flg &= !store.verify(id, msg, mlen, other);
+    }
+
+    // unknown key id is not found
+    std::memset(id, 0, sizeof(id));
+    flg &= store.find(id) == nullptr;
+    flg &= !store.verify(id, msg, mlen, sigs);
+
+    // corrupted header is rejected
+    const uint8_t junk = 0;
+    flg &= ::pwrite(fd, &junk, 1, 0) == 1;
+    flg &= !store.attach(fd);
+    flg &= store.size() == 0;
+
+    ::close(fd);
+    ::unlink(path);
+  }
+
+  // duplicate key ids are rejected
+  {
+    char path[] = "/tmp/falcon_pkey_store_XXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0);
+
+    pkey_store::writer_t<N> writer(fd);
+    flg &= writer.add(pkeys);
+    flg &= writer.add(pkeys);
+    flg &= !writer.finish();
+
+    ::close(fd);
+    ::unlink(path);
+  }
+
+  std::free(pkeys);
+  std::free(skeys);
+  std::free(sigs);
+
+  assert(flg);
+}
+
+// Test that expanded secret keys, written to sealed shared memory segment ( see
+// `key_store::create_segment` ), can't be modified, once sealed, and can be
+// attached to, from a forked worker process, producing same signatures as
+// freshly expanded secret keys.
+template<const size_t N>
+void
+test_key_segment()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t kcnt = 2;
+  constexpr size_t mlen = 32;
+
+  auto pkeys = static_cast<uint8_t*>(std::malloc(pklen * kcnt));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * kcnt));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  uint8_t msg[mlen];
+  uint8_t id[key_store::ID_LEN];
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < kcnt; i++) {
+    falcon::keygen<N>(pkeys + i * pklen, skeys + i * sklen);
+  }
+
+  rng.read(msg, mlen);
+  key_store::key_id<N>(pkeys + pklen, id);
+
+  // expected signature, using freshly expanded secret key
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr auto L = falcon_tree::layout_t::LEVEL_MAJOR;
+
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t id_[key_store::ID_LEN];
+
+  bool flg = key_store::expand_skey<N, L>(skeys + sklen, B, T, id_);
+  flg &= std::memcmp(id, id_, sizeof(id)) == 0;
+
+  prng::prng_t rng0 = rng;
+  falcon::sign<N>(B, T, msg, mlen, sig0, rng0);
+
+  const int fd = key_store::create_segment<N>(skeys, kcnt);
+  flg &= fd >= 0;
+  flg &= key_store::is_sealed(fd);
+
+  // sealed segment can't be written to, grown or shrunk
+  const uint8_t junk = 0;
+  flg &= ::pwrite(fd, &junk, 1, 0) < 0;
+  flg &= ::ftruncate(fd, 0) < 0;
+
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    key_store::mapped_t<N> store;
+
+    bool ok = store.attach(fd);
+    ok = ok && (store.size() == kcnt);
+
+    const size_t idx = ok ? store.find(id) : store.npos;
+    ok = ok && (idx != store.npos);
+
+    if (ok) {
+      prng::prng_t rng1 = rng;
+      falcon::sign<N>(store.B(idx), store.T(idx), msg, mlen, sig1, rng1);
+
+      ok = std::memcmp(sig0, sig1, siglen) == 0;
+    }
+
+    ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  int status = 0;
+  flg &= pid > 0;
+  flg &= ::waitpid(pid, &status, 0) == pid;
+  flg &= WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+
+  // ordinary file descriptors are not sealed
+  flg &= !key_store::is_sealed(STDIN_FILENO);
+
+  ::close(fd);
+
+  std::free(pkeys);
+  std::free(skeys);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+// Test that bulk loader ( see `key_loader::loader_t` ) expands every decodable
+// secret key into same B and T, as `falcon::expand_skey` does, reports each key
+// exactly once, through its callback, and flags undecodable secret keys as
+// failed, without affecting others.
+template<const size_t N>
+void
+test_key_loader()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t kcnt = 2;
+  constexpr size_t cnt = 2 * kcnt + 1; // each key twice, plus a bad one
+  constexpr size_t mlen = 32;
+
+  auto pkeys = static_cast<uint8_t*>(std::malloc(pklen * kcnt));
+  auto skeys = static_cast<uint8_t*>(std::malloc(sklen * cnt));
+  auto sig = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen];
+  prng::prng_t rng;
+
+  for (size_t i = 0; i < kcnt; i++) {
+    falcon::keygen<N>(pkeys + i * pklen, skeys + i * sklen);
+    std::memcpy(skeys + (kcnt + i) * sklen, skeys + i * sklen, sklen);
+  }
+
+  constexpr size_t bad = cnt - 1;
+  std::memcpy(skeys + bad * sklen, skeys, sklen);
+  skeys[bad * sklen] ^= 0xff;
+
+  std::atomic<size_t> ready[cnt]{};
+  std::atomic<size_t> failed[cnt]{};
+
+  key_loader::loader_t<N> loader(cnt, 2);
+
+  bool flg = loader.load(skeys, [&](const size_t idx, const bool ok) {
+    (ok ? ready : failed)[idx].fetch_add(1);
+  });
+  flg &= !loader.load(skeys);
+
+  loader.wait();
+
+  flg &= loader.size() == cnt;
+  flg &= loader.done() == cnt;
+  flg &= loader.failed() == 1;
+  flg &= loader.status(bad) == key_loader::status_t::FAILED;
+  flg &= (ready[bad] == 0) && (failed[bad] == 1);
+
+  for (size_t i = 0; i < cnt - 1; i++) {
+    const size_t k = i % kcnt;
+
+    flg &= loader.ready(i);
+    flg &= (ready[i] == 1) && (failed[i] == 0);
+
+    flg &= falcon::expand_skey<N>(skeys + i * sklen, B, T);
+    flg &= std::memcmp(B, loader.B(i), sizeof(fft::cmplx) * 4 * N) == 0;
+    flg &= std::memcmp(T, loader.T(i), sizeof(fft::cmplx) * tlen) == 0;
+
+    rng.read(msg, mlen);
+    falcon::sign<N>(loader.B(i), loader.T(i), msg, mlen, sig, rng);
+    flg &= falcon::verify<N>(pkeys + k * pklen, msg, mlen, sig);
+  }
+
+  std::free(pkeys);
+  std::free(skeys);
+  std::free(sig);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+// Test that streaming signer and verifier ( see `streaming::signer_t` and
+// `streaming::verifier_t` ), fed message in chunks of varying length, produce
+// same signature as signing whole message does, given same PRNG state, also
+// when signer is reused for many messages, and accept exactly those signatures
+// which `falcon::verify` accepts.
+template<const size_t N>
+void
+test_streaming()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 4099;
+  constexpr size_t chunks[]{ 0, 1, 7, 135, 136, 137, 1000 };
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto msg = static_cast<uint8_t*>(std::malloc(mlen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  prng::prng_t rng0;
+
+  falcon::keygen<N>(pkey, skey);
+  bool flg = falcon::expand_skey<N>(skey, B, T);
+
+  rng0.read(msg, mlen);
+  prng::prng_t rng1 = rng0;
+
+  streaming::signer_t<N> signer(B, T, rng1);
+  streaming::verifier_t<N> verifier(pkey);
+
+  flg &= verifier.ok();
+
+  // feeds whole message, in chunks of i-th ( and following ) length
+  const auto feed = [&](auto& obj, const size_t i) {
+    size_t off = 0;
+    size_t j = i;
+
+    while (off < mlen) {
+      const size_t len = std::min(chunks[j % std::size(chunks)], mlen - off);
+
+      obj.update(msg + off, len);
+      off += len;
+      j++;
+    }
+  };
+
+  for (size_t i = 0; i < std::size(chunks); i++) {
+    falcon::sign<N>(B, T, msg, mlen, sig0, rng0);
+
+    // signer is readied for next message, by `final`
+    feed(signer, i);
+    signer.final(sig1);
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= falcon::verify<N>(pkey, msg, mlen, sig1);
+
+    flg &= verifier.init(sig1);
+    feed(verifier, i + 1);
+    flg &= verifier.final();
+
+    // reusing verifier, without `init`, is rejected
+    feed(verifier, i + 1);
+    flg &= !verifier.final();
+
+    // altered message must not verify
+    msg[i * 512] ^= 1;
+
+    flg &= verifier.init(sig1);
+    feed(verifier, i);
+    flg &= !verifier.final();
+
+    msg[i * 512] ^= 1;
+  }
+
+  // undecodable signature is rejected, whatever message is fed
+  sig1[0] ^= 0xff;
+
+  flg &= !verifier.init(sig1);
+  feed(verifier, 0);
+  flg &= !verifier.final();
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(msg);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+// Test that signatures, whose sampler randomness comes from rings filled by
+// entropy producer ( see `entropy::producer_t` ), verify, whether rings are
+// empty ( so that signer falls back to inline generation ), topped up during
+// idle time or kept filled by background thread, while many signers drain
+// their own rings concurrently, and that, in a forked child process, rings
+// hand out no bytes, while producer is inert.
+template<const size_t N>
+void
+test_entropy_producer()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+  constexpr size_t signers = 2;
+  constexpr size_t rounds = 4;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sigs = static_cast<uint8_t*>(std::malloc(siglen * signers));
+  auto msgs = static_cast<uint8_t*>(std::malloc(mlen * signers));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  prng::prng_t rngs[signers];
+
+  falcon::keygen<N>(pkey, skey);
+  bool flg = falcon::expand_skey<N>(skey, B, T);
+
+  rngs[0].read(msgs, mlen * signers);
+
+  entropy::producer_t producer(signers);
+  spsc_ring::ring_t& ring = producer.ring(0);
+
+  flg &= producer.size() == signers;
+  flg &= ring.capacity() == (1ul << 17);
+
+  // empty ring, so that all randomness is generated inline
+  rngs[0].attach(&ring);
+  falcon::sign<N>(B, T, msgs, mlen, sigs, rngs[0]);
+
+  flg &= ring.dry() > 0;
+  flg &= falcon::verify<N>(pkey, msgs, mlen, sigs);
+
+  // topped up ring, which is drained, but not beyond what it holds
+  flg &= producer.refill() == signers * ring.capacity();
+  flg &= producer.refill() == 0;
+
+  const size_t dry = ring.dry();
+  falcon::sign<N>(B, T, msgs, mlen, sigs, rngs[0]);
+
+  flg &= ring.available() < ring.capacity();
+  flg &= ring.dry() == dry;
+  flg &= falcon::verify<N>(pkey, msgs, mlen, sigs);
+
+  // copy of an attached PRNG doesn't become a second consumer of its ring
+  const size_t avail = ring.available();
+  prng::prng_t rng_ = rngs[0];
+  falcon::sign<N>(B, T, msgs, mlen, sigs, rng_);
+
+  flg &= ring.available() == avail;
+  flg &= falcon::verify<N>(pkey, msgs, mlen, sigs);
+
+  // rings kept filled by background thread, while signers drain them
+  for (size_t i = 0; i < signers; i++) {
+    rngs[i].attach(&producer.ring(i));
+  }
+
+  flg &= producer.start();
+  flg &= !producer.start();
+
+  std::thread threads[signers];
+  bool oks[signers];
+
+  for (size_t i = 0; i < signers; i++) {
+    threads[i] = std::thread([&, i] {
+      uint8_t* const msg = msgs + i * mlen;
+      uint8_t* const sig = sigs + i * siglen;
+
+      oks[i] = true;
+      for (size_t r = 0; r < rounds; r++) {
+        falcon::sign<N>(B, T, msg, mlen, sig, rngs[i]);
+        oks[i] &= falcon::verify<N>(pkey, msg, mlen, sig);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < signers; i++) {
+    threads[i].join();
+    flg &= oks[i];
+  }
+
+  // forked child must not consume bytes, which parent is yet to consume, nor
+  // produce more of them, out of duplicated PRNGs
+  const pid_t pid = ::fork();
+  if (pid == 0) {
+    uint8_t bytes[32];
+
+    bool ok = ring.forked() && (ring.available() == 0);
+    ok &= !ring.pop(bytes, sizeof(bytes));
+    ok &= producer.forked();
+    ok &= producer.refill() == 0;
+    ok &= !producer.start();
+
+    // thread, started by parent, is forgotten, not joined
+    producer.stop();
+
+    ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  int status = 0;
+  flg &= pid > 0;
+  flg &= ::waitpid(pid, &status, 0) == pid;
+  flg &= WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+  flg &= !ring.forked();
+
+  producer.stop();
+
+  for (size_t i = 0; i < signers; i++) {
+    rngs[i].attach(nullptr);
+  }
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sigs);
+  std::free(msgs);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
+// Test that signing with PRNG, seeded with same seed, replays same sampler
+// paths, so that both signature and rejection/ retry counters ( see
+// `stats::counters_t` ) are same, and that counters add up, i.e. each
+// ffSampling pass, which is one more than # -of rejected signatures, samples
+// 2N integers. Unless counting is compiled in ( see `stats::ENABLED` ),
+// counters must stay zero.
+template<const size_t N>
+void
+test_sign_replay()
+  requires((N == 512) || (N == 1024))
+{
+  constexpr size_t pklen = falcon_utils::compute_pkey_len<N>();
+  constexpr size_t sklen = falcon_utils::compute_skey_len<N>();
+  constexpr size_t siglen = falcon_utils::compute_sig_len<N>();
+  constexpr size_t tlen = (1ul << log2<N>()) * (log2<N>() + 1);
+  constexpr size_t mlen = 32;
+  constexpr size_t rounds = 8;
+
+  auto pkey = static_cast<uint8_t*>(std::malloc(pklen));
+  auto skey = static_cast<uint8_t*>(std::malloc(sklen));
+  auto sig0 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto sig1 = static_cast<uint8_t*>(std::malloc(siglen));
+  auto B = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * 4 * N));
+  auto T = static_cast<fft::cmplx*>(std::malloc(sizeof(fft::cmplx) * tlen));
+  uint8_t msg[mlen];
+  uint8_t seed[32];
+  prng::prng_t rng;
+
+  falcon::keygen<N>(pkey, skey);
+  bool flg = falcon::expand_skey<N>(skey, B, T);
+
+  for (size_t r = 0; r < rounds; r++) {
+    rng.read(msg, sizeof(msg));
+    rng.read(seed, sizeof(seed));
+
+    prng::prng_t rng0(seed, sizeof(seed));
+    prng::prng_t rng1(seed, sizeof(seed));
+
+    stats::reset();
+    falcon::sign<N>(B, T, msg, mlen, sig0, rng0);
+    const stats::counters_t cnt0 = stats::counters;
+
+    stats::reset();
+    falcon::sign<N>(B, T, msg, mlen, sig1, rng1);
+    const stats::counters_t cnt1 = stats::counters;
+
+    const uint64_t passes = 1 + cnt0.norm_rejects + cnt0.compress_rejects;
+
+    flg &= std::memcmp(sig0, sig1, siglen) == 0;
+    flg &= falcon::verify<N>(pkey, msg, mlen, sig0);
+    flg &= cnt0.samplerz_calls == cnt1.samplerz_calls;
+    flg &= cnt0.samplerz_rejects == cnt1.samplerz_rejects;
+    flg &= cnt0.norm_rejects == cnt1.norm_rejects;
+    flg &= cnt0.compress_rejects == cnt1.compress_rejects;
+
+    if constexpr (stats::ENABLED) {
+      flg &= cnt0.samplerz_calls == 2 * N * passes;
+    } else {
+      flg &= cnt0.samplerz_calls == 0;
+      flg &= cnt0.samplerz_rejects == 0;
+      flg &= passes == 1;
+    }
+  }
+
+  std::free(pkey);
+  std::free(skey);
+  std::free(sig0);
+  std::free(sig1);
+  std::free(B);
+  std::free(T);
+
+  assert(flg);
+}
+
 }
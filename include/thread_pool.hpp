@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent pool of worker threads, used for parallelizing batched Falcon
+// operations
+namespace thread_pool {
+
+// Fixed size pool of worker threads, which are spawned once, when pool is
+// constructed, and are kept parked on a condition variable between jobs, so
+// that cost of spawning threads is not paid for every batch.
+//
+// A job is a function of form f(worker_idx, task_idx), which is invoked once
+// for each task_idx ∈ [0, task_cnt), by any of the workers. Tasks are handed out
+// dynamically ( using an atomic counter ), so that workers finishing early pick
+// up remaining tasks. Because worker_idx ∈ [0, size()) uniquely identifies the
+// worker executing a task, it can be used for indexing per-worker state ( say
+// PRNG or scratch buffers ), which is never accessed concurrently.
+class thread_pool_t
+{
+private:
+  std::vector<std::thread> workers;
+
+  std::mutex submit; // serializes concurrent calls to `run`
+  std::mutex lock;   // guards all of following members
+  std::condition_variable wake;
+  std::condition_variable done;
+
+  const std::function<void(size_t, size_t)>* job = nullptr;
+  size_t task_cnt = 0;
+  size_t pending = 0;      // # -of workers yet to finish current job
+  uint64_t generation = 0; // bumped every time a new job is posted
+  bool stop = false;
+
+  std::atomic<size_t> next_task{ 0 };
+
+  // Body of each worker thread, which waits for a job to be posted, executes
+  // as many of its tasks as it can grab, reports back and waits again.
+  inline void worker(const size_t widx)
+  {
+    uint64_t seen = 0;
+
+    while (true) {
+      const std::function<void(size_t, size_t)>* job_ = nullptr;
+      size_t cnt = 0;
+
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        wake.wait(guard, [&] { return stop || (generation != seen); });
+
+        if (stop) {
+          return;
+        }
+
+        seen = generation;
+        job_ = job;
+        cnt = task_cnt;
+      }
+
+      while (true) {
+        const size_t tidx = next_task.fetch_add(1, std::memory_order_relaxed);
+        if (tidx >= cnt) {
+          break;
+        }
+
+        (*job_)(widx, tidx);
+      }
+
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        pending--;
+        if (pending == 0) {
+          done.notify_one();
+        }
+      }
+    }
+  }
+
+public:
+  // Spawns `cnt` -many worker threads, which live as long as the pool does.
+  // Requesting a pool of zero threads results in a pool of single thread.
+  explicit inline thread_pool_t(const size_t cnt)
+  {
+    const size_t cnt_ = std::max<size_t>(cnt, 1);
+
+    workers.reserve(cnt_);
+    for (size_t i = 0; i < cnt_; i++) {
+      workers.emplace_back(&thread_pool_t::worker, this, i);
+    }
+  }
+
+  thread_pool_t(const thread_pool_t&) = delete;
+  thread_pool_t& operator=(const thread_pool_t&) = delete;
+
+  // Asks all workers to exit, once they're done with current job ( if any ),
+  // and joins them.
+  inline ~thread_pool_t()
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+
+    wake.notify_all();
+    for (auto& w : workers) {
+      w.join();
+    }
+  }
+
+  // Number of worker threads in this pool.
+  inline size_t size() const { return workers.size(); }
+
+  // Executes f(worker_idx, task_idx), for all task_idx ∈ [0, cnt), on worker
+  // threads of this pool, blocking caller until all tasks are done. Job must
+  // not throw.
+  inline void run(const size_t cnt,
+                  const std::function<void(size_t, size_t)>& f)
+  {
+    if (cnt == 0) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> serialize(submit);
+
+    {
+      std::unique_lock<std::mutex> guard(lock);
+
+      job = &f;
+      task_cnt = cnt;
+      pending = workers.size();
+      next_task.store(0, std::memory_order_relaxed);
+      generation++;
+
+      wake.notify_all();
+      done.wait(guard, [&] { return pending == 0; });
+
+      job = nullptr;
+    }
+  }
+};
+
+}
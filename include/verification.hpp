@@ -4,60 +4,89 @@
 #include "hashing.hpp"
 #include "ntt.hpp"
 #include "polynomial.hpp"
+#include "scratch.hpp"
+#include <cassert>
 
 // Falcon{512, 1024} Signature Verification related Routines
 namespace verification {
 
-// Given mlen -bytes message, {666, 1280} -bytes signature ( encapsulating
-// polynomial s2 ) and Falcon{512, 1024} public key as degree N polynomial over
-// Z_q ( i.e. h ), this routine checks whether s1 + s2*h = c ( mod q ) equation
-// holds or not, by computing s1, using arithmetic over Z_q[x]/(x^N + 1) and
-// trying to assert if squared norm of vector of polynomials (s1, s2) is within
-// expected bound β2.
+// Compile-time compute how many bytes of scratch space are required by
+// `verify_hashed`, for keeping s1 ( along with its normalized form ) and NTT
+// form of s2.
+template<const size_t N>
+static inline constexpr size_t
+verify_hashed_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<int32_t>(N) + 2 * scratch::bytes<ff::ff_t>(N);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `verify_ntt`, for keeping s2, c and s1 ( along with their
+// NTT forms ).
+template<const size_t N>
+static inline constexpr size_t
+verify_ntt_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<int32_t>(N) + scratch::bytes<ff::ff_t>(N) +
+         verify_hashed_scratch_bytes<N>();
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `verify`, for keeping s2, c, h and s1 ( along with their
+// NTT forms ).
+template<const size_t N>
+static inline constexpr size_t
+verify_scratch_bytes()
+  requires((N == 512) || (N == 1024))
+{
+  return scratch::bytes<ff::ff_t>(N) + verify_ntt_scratch_bytes<N>();
+}
+
+// Given Falcon{512, 1024} public key h in its NTT form, polynomial s2, decoded
+// from signature, and point c, to which salt and message are already hashed,
+// this routine computes s1 = c - s2*h ( mod q ) and checks whether squared norm
+// of (s1, s2) is within bound β2, following line 4 - 6 of algorithm 16 of
+// falcon specification https://falcon-sign.info/falcon.pdf
 //
-// This routine returns boolean truth value in case of successful signature
-// verification, otherwise it returns false.
+// This is what `verify_ntt` does, after decoding signature and hashing message,
+// split out, so that message can also be hashed incrementally, see
+// streaming.hpp. Note, c is overwritten by its NTT form.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `verify_hashed_scratch_bytes<N>()`
+// -bytes.
 template<const size_t N, const int32_t β2>
 static inline bool
-verify(const ff::ff_t* const __restrict h,
-       const uint8_t* const __restrict msg,
-       const size_t mlen,
-       const uint8_t* const __restrict sig)
+verify_hashed(const ff::ff_t* const __restrict h_ntt,
+              const int32_t* const __restrict s2,
+              ff::ff_t* const __restrict c,
+              uint8_t* const __restrict scratch)
   requires((N == 512) || (N == 1024))
 {
-  uint8_t salt[40];
-  int32_t s2[N];
+  assert(scratch::is_aligned(scratch));
 
-  const size_t decoded = decoding::decode_sig<N>(sig, salt, s2);
-  if (!decoded) [[unlikely]] {
-    return decoded;
-  }
+  uint8_t* buf = scratch;
+
+  int32_t* const normalized_s1 = scratch::take<int32_t>(buf, N);
+  ff::ff_t* const s2_ntt = scratch::take<ff::ff_t>(buf, N);
+  ff::ff_t* const s1 = scratch::take<ff::ff_t>(buf, N);
 
-  ff::ff_t s2_ntt[N];
   for (size_t i = 0; i < N; i++) {
     s2_ntt[i].v = static_cast<uint16_t>((s2[i] < 0) * ff::Q + s2[i]);
   }
 
-  ff::ff_t c[N];
-  hashing::hash_to_point<N>(salt, sizeof(salt), msg, mlen, c);
-
-  ff::ff_t h_[N];
-  std::memcpy(h_, h, sizeof(h_));
-
   ntt::ntt<log2<N>()>(c);
   ntt::ntt<log2<N>()>(s2_ntt);
-  ntt::ntt<log2<N>()>(h_);
-
-  ff::ff_t s1[N];
 
-  polynomial::mul<log2<N>()>(s2_ntt, h_, s1); // s1 <- s2 * h ( mod q ) [NTT]
-  polynomial::neg<log2<N>()>(s1);             // s1 <- -s1 ( mod q ) [NTT]
-  polynomial::add_to<log2<N>()>(s1, c);       // s1 <- s1 + c ( mod q ) [NTT]
+  polynomial::mul<log2<N>()>(s2_ntt, h_ntt, s1); // s1 <- s2 * h ( mod q ) [NTT]
+  polynomial::neg<log2<N>()>(s1);                // s1 <- -s1 ( mod q ) [NTT]
+  polynomial::add_to<log2<N>()>(s1, c);          // s1 <- s1 + c ( mod q ) [NTT]
 
   ntt::intt<log2<N>()>(s1); // s1 <- c - s2*h ( mod q ) [Coeff]
 
   constexpr uint16_t qby2 = ff::Q / 2;
-  int32_t normalized_s1[N];
 
   for (size_t i = 0; i < N; i++) {
     const bool flg = s1[i].v >= qby2;
@@ -67,16 +96,194 @@ verify(const ff::ff_t* const __restrict h,
     normalized_s1[i] = t0 - t1;
   }
 
-  int32_t sqrd_norm = 0;
+  // Each squared coefficient of s1 can be as large as (q/2)^2, so that, for a
+  // forged signature, sum of N of them overflows 32 -bit accumulator.
+  int64_t sqrd_norm = 0;
 
   for (size_t i = 0; i < N; i++) {
-    sqrd_norm += s2[i] * s2[i];
+    sqrd_norm += static_cast<int64_t>(s2[i]) * s2[i];
   }
   for (size_t i = 0; i < N; i++) {
-    sqrd_norm += normalized_s1[i] * normalized_s1[i];
+    sqrd_norm += static_cast<int64_t>(normalized_s1[i]) * normalized_s1[i];
   }
 
   return sqrd_norm <= β2;
 }
 
+// Same as `verify` ( see below ), but takes Falcon{512, 1024} public key h
+// already in its NTT form, so that a verifier, which keeps public keys around (
+// say in a memory mapped key store, see pkey_store.hpp ), doesn't pay for
+// decoding and forward transforming h, on every call.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `verify_ntt_scratch_bytes<N>()`
+// -bytes.
+template<const size_t N, const int32_t β2>
+static inline bool
+verify_ntt(const ff::ff_t* const __restrict h_ntt,
+           const uint8_t* const __restrict msg,
+           const size_t mlen,
+           const uint8_t* const __restrict sig,
+           uint8_t* const __restrict scratch // see `verify_ntt_scratch_bytes`
+           )
+  requires((N == 512) || (N == 1024))
+{
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  int32_t* const s2 = scratch::take<int32_t>(buf, N);
+  ff::ff_t* const c = scratch::take<ff::ff_t>(buf, N);
+
+  uint8_t salt[40];
+
+  const size_t decoded = decoding::decode_sig<N>(sig, salt, s2);
+  if (!decoded) [[unlikely]] {
+    return decoded;
+  }
+
+  hashing::hash_to_point<N>(salt, sizeof(salt), msg, mlen, c);
+  return verify_hashed<N, β2>(h_ntt, s2, c, buf);
+}
+
+// Compile-time compute how many bytes of scratch space are required by scratch
+// taking variant of `verify_ntt_xn`, which keeps W decoded s2 and W hashed
+// points c, on top of what `verify_hashed` requires.
+template<const size_t N, const size_t W>
+static inline constexpr size_t
+verify_ntt_xn_scratch_bytes()
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  return scratch::bytes<int32_t>(N * W) + scratch::bytes<ff::ff_t>(N * W) +
+         verify_hashed_scratch_bytes<N>();
+}
+
+// Verifies W signatures at once, s.t. signature sigs[w] is checked against
+// message msgs[w] of mlens[w] -bytes and public key h_ntt[w] ( in NTT form ),
+// writing whether it's valid to ok[w], same as `verify_ntt` would do. Salts and
+// messages of all W signatures are hashed at once, see
+// `hashing::hash_to_point_xn`, which is what makes it faster than W calls to
+// `verify_ntt`, when messages are short. Returns true only if all W signatures
+// are valid.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `verify_ntt_xn_scratch_bytes<N,
+// W>()` -bytes.
+template<const size_t N, const int32_t β2, const size_t W>
+static inline bool
+verify_ntt_xn(const ff::ff_t* const* const __restrict h_ntt,
+              const uint8_t* const* const __restrict msgs,
+              const size_t* const __restrict mlens,
+              const uint8_t* const* const __restrict sigs,
+              bool* const __restrict ok,
+              uint8_t* const __restrict scratch)
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+
+  int32_t* const s2x = scratch::take<int32_t>(buf, N * W);
+  ff::ff_t* const cx = scratch::take<ff::ff_t>(buf, N * W);
+
+  uint8_t salt[W][40]{};
+  const uint8_t* salts[W];
+  ff::ff_t* cs[W];
+
+  for (size_t w = 0; w < W; w++) {
+    ok[w] = decoding::decode_sig<N>(sigs[w], salt[w], s2x + w * N);
+
+    salts[w] = salt[w];
+    cs[w] = cx + w * N;
+  }
+
+  // lanes whose signature can't be decoded are hashed too, but never checked
+  hashing::hash_to_point_xn<N, W>(salts, sizeof(salt[0]), msgs, mlens, cs);
+
+  bool all = true;
+
+  for (size_t w = 0; w < W; w++) {
+    if (ok[w]) [[likely]] {
+      ok[w] = verify_hashed<N, β2>(h_ntt[w], s2x + w * N, cs[w], buf);
+    }
+
+    all &= ok[w];
+  }
+
+  return all;
+}
+
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N, const int32_t β2, const size_t W>
+static inline bool
+verify_ntt_xn(const ff::ff_t* const* const __restrict h_ntt,
+              const uint8_t* const* const __restrict msgs,
+              const size_t* const __restrict mlens,
+              const uint8_t* const* const __restrict sigs,
+              bool* const __restrict ok)
+  requires(((N == 512) || (N == 1024)) && ((W == 4) || (W == 8)))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[verify_ntt_xn_scratch_bytes<N, W>()];
+  return verify_ntt_xn<N, β2, W>(h_ntt, msgs, mlens, sigs, ok, buf);
+}
+
+// Given mlen -bytes message, {666, 1280} -bytes signature ( encapsulating
+// polynomial s2 ) and Falcon{512, 1024} public key as degree N polynomial over
+// Z_q ( i.e. h ), this routine checks whether s1 + s2*h = c ( mod q ) equation
+// holds or not, by computing s1, using arithmetic over Z_q[x]/(x^N + 1) and
+// trying to assert if squared norm of vector of polynomials (s1, s2) is within
+// expected bound β2.
+//
+// This routine returns boolean truth value in case of successful signature
+// verification, otherwise it returns false.
+//
+// All temporaries live in caller-provided scratch buffer, which must be
+// aligned to `scratch::ALIGNMENT` and span `verify_scratch_bytes<N>()` -bytes.
+template<const size_t N, const int32_t β2>
+static inline bool
+verify(const ff::ff_t* const __restrict h,
+       const uint8_t* const __restrict msg,
+       const size_t mlen,
+       const uint8_t* const __restrict sig,
+       uint8_t* const __restrict scratch // see `verify_scratch_bytes`
+       )
+  requires((N == 512) || (N == 1024))
+{
+  assert(scratch::is_aligned(scratch));
+
+  uint8_t* buf = scratch;
+  ff::ff_t* const h_ = scratch::take<ff::ff_t>(buf, N);
+
+  std::memcpy(h_, h, sizeof(ff::ff_t) * N);
+  ntt::ntt<log2<N>()>(h_);
+
+  return verify_ntt<N, β2>(h_, msg, mlen, sig, buf);
+}
+
+// Same as above, but keeps required scratch space on the stack.
+template<const size_t N, const int32_t β2>
+static inline bool
+verify(const ff::ff_t* const __restrict h,
+       const uint8_t* const __restrict msg,
+       const size_t mlen,
+       const uint8_t* const __restrict sig)
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[verify_scratch_bytes<N>()];
+  return verify<N, β2>(h, msg, mlen, sig, buf);
+}
+
+// Same as `verify_ntt`, but keeps required scratch space on the stack.
+template<const size_t N, const int32_t β2>
+static inline bool
+verify_ntt(const ff::ff_t* const __restrict h_ntt,
+           const uint8_t* const __restrict msg,
+           const size_t mlen,
+           const uint8_t* const __restrict sig)
+  requires((N == 512) || (N == 1024))
+{
+  alignas(scratch::ALIGNMENT) uint8_t buf[verify_ntt_scratch_bytes<N>()];
+  return verify_ntt<N, β2>(h_ntt, msg, mlen, sig, buf);
+}
+
 }
@@ -0,0 +1,273 @@
+#pragma once
+#include "isa.hpp"
+#include "keccak_xn.hpp"
+#include "shake256.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// SHAKE256 XOF, used by both PRNG and message hashing, backed by Falcon-side
+// Keccak-f[1600] permutation, unless `FALCON_SHA3_SHAKE256` is defined, in
+// which case SHAKE256 from sha3 submodule is used instead.
+namespace xof {
+
+// Bytes absorbed into/ squeezed out of SHAKE256 state, per permutation
+constexpr size_t RBYTES = shake256::rate >> 3;
+
+// Lanes of Keccak state, which are kept complemented, while inside permutation,
+// indexed by x + 5 * y. With this pattern, χ step needs 8 NOTs per round,
+// instead of 25, see section 2.2 of Keccak implementation overview
+// https://keccak.team/files/Keccak-implementation-3.2.pdf
+//
+// Lane complementing pays off on targets, lacking an and-not instruction. With
+// BMI1 ( `andn` ) or on AArch64 ( `bic` ), χ needs no NOT to start with, so
+// it's opt-in, by defining `FALCON_KECCAK_LANE_COMPLEMENTING`.
+#if defined FALCON_KECCAK_LANE_COMPLEMENTING
+constexpr bool LC[25]{ 0, 1, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1,
+                       0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0 };
+#else
+constexpr bool LC[25]{};
+#endif
+
+// Whether i-th lane is complemented, after θ, ρ and π steps, but before χ, when
+// lanes in `LC` were complemented, at start of round.
+struct lc_after_pi_t
+{
+  bool v[25]{};
+
+  constexpr lc_after_pi_t()
+  {
+    bool c[5]{};
+    for (size_t i = 0; i < 25; i++) {
+      c[i % 5] ^= LC[i];
+    }
+
+    for (size_t i = 0; i < 25; i++) {
+      const size_t x = i % 5;
+      v[keccak_xn::PI[i]] = LC[i] ^ c[(x + 4) % 5] ^ c[(x + 1) % 5];
+    }
+  }
+};
+
+constexpr lc_after_pi_t LC_PI{};
+
+// Computes χ step's a ^ (~b & c), where a, b, c and result are stored
+// complemented, if respective flag is set, choosing whichever of its equivalent
+// forms needs fewest NOTs. Flags are compile-time constants, once loops calling
+// this are unrolled, so that only chosen form is emitted.
+static inline uint64_t
+chi(const uint64_t a,
+    const uint64_t b,
+    const uint64_t c,
+    const bool fa,
+    const bool fb,
+    const bool fc,
+    const bool fo)
+{
+  uint64_t t = 0;
+  bool neg = false; // whether t is complement of ~b & c
+
+  if (fb && !fc) {
+    t = b & c;
+  } else if (!fb && fc) {
+    t = b | c;
+    neg = true;
+  } else if (!fb) {
+    neg = fa ^ fo;
+    t = neg ? (b | ~c) : (~b & c);
+  } else {
+    neg = fa ^ fo;
+    t = neg ? (~b | c) : (b & ~c);
+  }
+
+  return (fa ^ fo ^ neg) ? ~(a ^ t) : (a ^ t);
+}
+
+// Applies Keccak-f[1600] permutation on a single state. Loops over state words
+// are fully unrolled, so that whole state stays in registers, throughout all 24
+// rounds, letting compiler use `andn`/ `rorx`, when BMI1/ BMI2 is available.
+//
+// Data parallel SIMD doesn't help a single state, see keccak_xn.hpp for hashing
+// many messages at once, instead.
+static inline void
+permute(uint64_t* const __restrict state)
+{
+  isa::dispatch([&] {
+    uint64_t a[25];
+
+  #pragma GCC unroll 25
+    for (size_t i = 0; i < 25; i++) {
+      a[i] = LC[i] ? ~state[i] : state[i];
+    }
+
+    for (size_t r = 0; r < 24; r++) {
+      uint64_t c[5];
+      uint64_t d[5];
+      uint64_t b[25];
+
+      // θ
+  #pragma GCC unroll 5
+      for (size_t x = 0; x < 5; x++) {
+        c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+      }
+
+  #pragma GCC unroll 5
+      for (size_t x = 0; x < 5; x++) {
+        d[x] = c[(x + 4) % 5] ^ std::rotl(c[(x + 1) % 5], 1);
+      }
+
+      // θ, ρ and π
+  #pragma GCC unroll 25
+      for (size_t i = 0; i < 25; i++) {
+        b[keccak_xn::PI[i]] = std::rotl(a[i] ^ d[i % 5], keccak_xn::ROT[i]);
+      }
+
+      // χ
+  #pragma GCC unroll 5
+      for (size_t y = 0; y < 25; y += 5) {
+  #pragma GCC unroll 5
+        for (size_t x = 0; x < 5; x++) {
+          const size_t i0 = y + x;
+          const size_t i1 = y + (x + 1) % 5;
+          const size_t i2 = y + (x + 2) % 5;
+
+          a[i0] = chi(b[i0],
+                      b[i1],
+                      b[i2],
+                      LC_PI.v[i0],
+                      LC_PI.v[i1],
+                      LC_PI.v[i2],
+                      LC[i0]);
+        }
+      }
+
+      // ι
+      a[0] ^= keccak_xn::RC[r];
+    }
+
+  #pragma GCC unroll 25
+    for (size_t i = 0; i < 25; i++) {
+      state[i] = LC[i] ? ~a[i] : a[i];
+    }
+  });
+}
+
+// XORs `len` -bytes into Keccak state, starting at byte offset `off`.
+static inline void
+xor_bytes(uint64_t* const __restrict state,
+          const size_t off,
+          const uint8_t* const __restrict bytes,
+          const size_t len)
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    uint8_t* const st = reinterpret_cast<uint8_t*>(state) + off;
+    for (size_t i = 0; i < len; i++) {
+      st[i] ^= bytes[i];
+    }
+  } else {
+    for (size_t i = 0; i < len; i++) {
+      const size_t j = off + i;
+      state[j >> 3] ^= static_cast<uint64_t>(bytes[i]) << ((j & 7) << 3);
+    }
+  }
+}
+
+// Copies `len` -bytes out of Keccak state, starting at byte offset `off`.
+static inline void
+copy_bytes(const uint64_t* const __restrict state,
+           const size_t off,
+           uint8_t* const __restrict bytes,
+           const size_t len)
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(bytes, reinterpret_cast<const uint8_t*>(state) + off, len);
+  } else {
+    for (size_t i = 0; i < len; i++) {
+      const size_t j = off + i;
+      bytes[i] = static_cast<uint8_t>(state[j >> 3] >> ((j & 7) << 3));
+    }
+  }
+}
+
+// Incremental SHAKE256 XOF, on top of Falcon-side Keccak-f[1600] permutation,
+// exposing same absorb -> finalize -> read API as SHAKE256 from sha3 submodule
+// does, so that either can be used, see `shake256_t`.
+//
+// Bytes are XOR-ed into and copied out of state, a run at a time, instead of
+// one byte at a time. When reading more than a block, whole blocks are
+// squeezed straight into destination buffer.
+class falcon_shake256_t
+{
+private:
+  uint64_t state[25]{};
+  size_t offset = 0; // bytes absorbed into/ read from current block
+
+public:
+  // Absorbs `len` -bytes message into state. Can be called many times, before
+  // `finalize`.
+  inline void absorb(const uint8_t* const __restrict msg, const size_t len)
+  {
+    size_t off = 0;
+
+    while (off < len) {
+      const size_t take = std::min(RBYTES - offset, len - off);
+
+      xor_bytes(state, offset, msg + off, take);
+      offset += take;
+      off += take;
+
+      if (offset == RBYTES) {
+        permute(state);
+        offset = 0;
+      }
+    }
+  }
+
+  // Pads absorbed message and prepares state for squeezing.
+  inline void finalize()
+  {
+    const uint8_t pad0 = 0x1f;
+    const uint8_t pad1 = 0x80;
+
+    xor_bytes(state, offset, &pad0, 1);
+    xor_bytes(state, RBYTES - 1, &pad1, 1);
+    permute(state);
+
+    offset = 0;
+  }
+
+  // Squeezes `len` -bytes out of state. Can be called many times, after
+  // `finalize`.
+  inline void read(uint8_t* const __restrict bytes, const size_t len)
+  {
+    const size_t head = std::min(RBYTES - offset, len);
+
+    copy_bytes(state, offset, bytes, head);
+    offset += head;
+
+    size_t off = head;
+
+    while (len - off >= RBYTES) {
+      permute(state);
+      copy_bytes(state, 0, bytes + off, RBYTES);
+      offset = RBYTES;
+      off += RBYTES;
+    }
+
+    if (off < len) {
+      permute(state);
+      copy_bytes(state, 0, bytes + off, len - off);
+      offset = len - off;
+    }
+  }
+};
+
+#if defined FALCON_SHA3_SHAKE256
+using shake256_t = shake256::shake256<true>;
+#else
+using shake256_t = falcon_shake256_t;
+#endif
+
+}
@@ -26,10 +26,31 @@ main()
   test_falcon::test_fft_split_merge<10>();
   std::cout << "[test] Splitting and merging of polynomials in FFT form\n";
 
+  test_falcon::test_codelets<1>();
+  test_falcon::test_codelets<2>();
+  test_falcon::test_codelets<3>();
+  std::cout << "[test] Unrolled codelets for small degree polynomials\n";
+
   test_falcon::test_falcon512_samplerz();
   test_falcon::test_falcon1024_samplerz();
   std::cout << "[test] Sampler over the Integers, using KATs\n";
 
+  test_falcon::test_samplerz_xn<4>();
+  test_falcon::test_samplerz_xn<8>();
+  std::cout << "[test] Lane-batched Sampler over the Integers\n";
+
+  test_falcon::test_hash_to_point_xn<512, 4>();
+  test_falcon::test_hash_to_point_xn<512, 8>();
+  test_falcon::test_hash_to_point_xn<1024, 4>();
+  test_falcon::test_hash_to_point_xn<1024, 8>();
+  std::cout << "[test] Hashing Many Messages to Points, at once\n";
+
+  test_falcon::test_xof();
+  std::cout << "[test] SHAKE256 on Falcon-side Keccak-f[1600] permutation\n";
+
+  test_falcon::test_thread_prng();
+  std::cout << "[test] Fork-safe PRNG, local to a thread\n";
+
   test_falcon::test_ntru_gen<512>();
   test_falcon::test_ntru_gen<1024>();
   std::cout << "[test] NTRUGen\n";
@@ -42,23 +63,105 @@ main()
   test_falcon::test_encoding_skey<1024>();
   std::cout << "[test] Encode/ Decode Secret Key\n";
 
+  test_falcon::test_encoding_fixed_width<512>();
+  test_falcon::test_encoding_fixed_width<1024>();
+  std::cout << "[test] Fixed-width Key Fields, packed with BMI2/ portably\n";
+
   test_falcon::test_keygen<512>();
   test_falcon::test_keygen<1024>();
   std::cout << "[test] Falcon KeyGen\n";
 
   test_falcon::test_ff_sampling<512>(165.736617183, 1.277833697);
   test_falcon::test_ff_sampling<1024>(168.388571447, 1.298280334);
+  test_falcon::test_ff_sampling_inplace<512>(165.736617183, 1.277833697);
+  test_falcon::test_ff_sampling_inplace<1024>(168.388571447, 1.298280334);
   std::cout << "[test] Fast Fourier Sampling\n";
 
   test_falcon::test_sig_compression<512>(165.736617183, 1.277833697, 34034726);
   test_falcon::test_sig_compression<1024>(168.388571447, 1.298280334, 70265242);
   test_falcon::test_sig_decompression<512>();
   test_falcon::test_sig_decompression<1024>();
+  test_falcon::test_sig_compression_bounds<512>();
+  test_falcon::test_sig_compression_bounds<1024>();
+  test_falcon::test_sig_decompression_canonical<512>();
+  test_falcon::test_sig_decompression_canonical<1024>();
   std::cout << "[test] Signature Compression/ Decompression\n";
 
   test_falcon::test_keygen_sign_verify<512>();
   test_falcon::test_keygen_sign_verify<1024>();
   std::cout << "[test] Keygen -> Sign -> Verify\n";
 
+  test_falcon::test_verify_norm_overflow<512>();
+  test_falcon::test_verify_norm_overflow<1024>();
+  std::cout << "[test] Rejecting Forged Signature, with Norm Overflowing int32\n";
+
+  test_falcon::test_sign_replay<512>();
+  test_falcon::test_sign_replay<1024>();
+  std::cout << "[test] Replaying Seeded Signing, with Rejection Counters\n";
+
+  test_falcon::test_sign_dyn<512>();
+  test_falcon::test_sign_dyn<1024>();
+  std::cout << "[test] Tree-less ( dynamic ) Signing\n";
+
+  test_falcon::test_scratch_api<512>();
+  test_falcon::test_scratch_api<1024>();
+  std::cout << "[test] Caller-supplied Scratch Buffer API\n";
+
+  test_falcon::test_preorder_tree<512>();
+  test_falcon::test_preorder_tree<1024>();
+  std::cout << "[test] Pre-order Falcon Tree Layout\n";
+
+  test_falcon::test_sign_batch<512>();
+  test_falcon::test_sign_batch<1024>();
+  std::cout << "[test] Multi-threaded Batch Signing\n";
+
+  test_falcon::test_sign_xn<512, 4>();
+  test_falcon::test_sign_xn<512, 8>();
+  test_falcon::test_sign_xn<1024, 4>();
+  test_falcon::test_sign_xn<1024, 8>();
+  std::cout << "[test] Lockstep Signing of Many Messages\n";
+
+  test_falcon::test_key_cache<512>();
+  test_falcon::test_key_cache<1024>();
+  std::cout << "[test] Expanded Secret Key Cache\n";
+
+  test_falcon::test_key_store<512>();
+  test_falcon::test_key_store<1024>();
+  std::cout << "[test] Memory-mapped Expanded Secret Key Store\n";
+
+  test_falcon::test_pkey_store<512>();
+  test_falcon::test_pkey_store<1024>();
+  std::cout << "[test] Memory-mapped Public Key Store\n";
+
+  test_falcon::test_key_segment<512>();
+  test_falcon::test_key_segment<1024>();
+  std::cout << "[test] Sealed Shared Memory Expanded Key Segment\n";
+
+  test_falcon::test_keygen_from_seed<512>();
+  test_falcon::test_keygen_from_seed<1024>();
+  std::cout << "[test] Deterministic Key Generation from Seed\n";
+
+  test_falcon::test_key_loader<512>();
+  test_falcon::test_key_loader<1024>();
+  std::cout << "[test] Parallel Bulk Secret Key Expansion\n";
+
+  test_falcon::test_streaming<512>();
+  test_falcon::test_streaming<1024>();
+  std::cout << "[test] Streaming Signing and Verification\n";
+
+  test_falcon::test_entropy_producer<512>();
+  test_falcon::test_entropy_producer<1024>();
+  std::cout << "[test] Asynchronous Entropy Producer\n";
+
+  test_falcon::test_isa_dispatch<512>();
+  test_falcon::test_isa_dispatch<1024>();
+  std::cout << "[test] Run Time ISA Dispatch of Hot Kernels ( using "
+            << isa::name(isa::active()) << " )\n";
+
+  test_falcon::test_fpr_ops();
+  test_falcon::test_fpr_sign<512>();
+  test_falcon::test_fpr_sign<1024>();
+  std::cout << "[test] Emulated ( integer only ) Floating Point Signing\n";
+
   return EXIT_SUCCESS;
 }